@@ -23,6 +23,13 @@
 #include <errno.h>
 #include <sys/sysinfo.h>
 #include <signal.h>
+#include <stddef.h>
+#include <sys/timerfd.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <limits.h>
+#include <semaphore.h>
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
@@ -31,8 +38,22 @@
 /*                     EXPORTED TYPES and DEFINITIONS                         */
 /******************************************************************************/
 #define MAX_CONNECTIONS 100
+#define CONNECTION_TABLE_INITIAL_SIZE 1024
+#define MAX_REACTORS 64
+#define DEFAULT_LISTEN_BACKLOG 4096 // capped by net.core.somaxconn
+#define DEFAULT_EPOLL_BATCH 64      // events returned per epoll_wait
+#define IO_URING_ENTRIES 4096       // submission queue depth of the io_uring backend
+
+// sensor handle = generation | slot | shard, packed in a non-negative int
+#define HANDLE_SHARD_BITS 6 // log2(MAX_REACTORS)
+#define HANDLE_SLOT_BITS 16
+#define HANDLE_GENERATION_BITS 9
+#define POOL_CHUNK_SLOTS 256 // connection slots allocated at once
+#define POOL_MAX_CHUNKS ((1 << HANDLE_SLOT_BITS) / POOL_CHUNK_SLOTS)
+#define MAX_PORT_NUMBER 65535
 #define BUFFER_SIZE 256
-#define RING_BUFFER_SIZE 1024
+#define RING_BUFFER_SIZE 65536 // pending readings per queue, must be a power of two
+#define CACHE_LINE_SIZE 64
 #define MAX_WORDS 10
 #define MAX_WORD_LENGTH 100
 
@@ -46,12 +67,76 @@
 #define SQL_DISCONNECTED "DISCONNECTED"
 #define SQL_RETRY_LIMIT 3
 #define SQL_RETRY_DELAY_SEC 5
-
-#define TEMPERATURE_HISTORY_SIZE 5
+#define STORAGE_BATCH_MAX_ROWS 512       // rows written per BEGIN/COMMIT transaction
+#define STORAGE_BATCH_MAX_LATENCY_MS 200 // a pending reading is committed within this delay
+#define SPILL_FILE_NAME "sensor_data.spill"
+#define SPILL_MAGIC 0x4C505353u        // "SSPL"
+#define SPILL_HEADER_BYTES 4096        // first page of the journal, holds SpillHeader
+#define SPILL_WINDOW_BYTES (1 << 20)   // part of the journal mapped at a time
+#define SPILL_DEFAULT_MAX_MIB 256      // unreplayed journal size past which readings are dropped (-j)
+#define SEGMENT_DIR "sensor_segments"
+#define SEGMENT_MAGIC 0x53474553u      // "SEGS"
+#define SEGMENT_RECORDS 65536          // readings per segment file
+#define SEGMENT_BLOCK_RECORDS 512      // readings per sparse time index entry
+#define SEGMENT_HEADER_BYTES 4096      // header and sparse index, records start on the next page
+#define STORAGE_IDLE_CHECKPOINT_MS 2000  // the WAL is checkpointed and truncated after this long without writes
+#define STORAGE_READER_BUSY_TIMEOUT_MS 2000
+#define STORAGE_ROW_PAYLOAD_BYTES 16 // timestamp + sensor id + temperature, the baseline of the write amplification
+#define COUNTING_VFS_NAME "gateway-counting"
+#define STORAGE_PARTITION_SECONDS 86400 // one partition table per UTC day
+#define STORAGE_PARTITION_CACHE 4       // partitions with a cached INSERT statement
+#define STORAGE_PARTITION_NAME_SIZE 32
+#define STORAGE_DEFAULT_RETENTION_DAYS 30 // partitions older than this are dropped (0: keep everything)
+#define STORAGE_QUERY_MAX_PARTITIONS 400   // partitions a single query may visit
+#define STORAGE_PAGE_DEFAULT_ROWS 50       // readdb page size without limit=
+#define STORAGE_PAGE_MAX_ROWS 10000
+#define ROLLUP_MINUTE_SECONDS 60
+#define ROLLUP_HOUR_SECONDS 3600
+#define STORAGE_CHUNK_MAX_READINGS 1024  // readings per compressed chunk, also the id stride of a chunk
+#define STORAGE_CHUNK_WINDOW_SECONDS 3600 // a chunk never spans two windows, so a page looks back at most this far
+#define STORAGE_COMPACTION_STEP_READINGS 16384 // readings one compaction step rewrites at most (one per commit)
+#define GORILLA_MAX_BYTES(count) (8 + 10 * (size_t)(count)) // worst-case encoded size of `count` readings
+
+#define TEMPERATURE_HISTORY_SIZE 5 // default analysis window, in samples
+#define STATS_EWMA_ALPHA 0.2       // weight of the newest reading in the exponential moving average
+#define STATS_INITIAL_CAPACITY 8   // samples a sensor's window holds before growing, a power of two
+#define STATS_MAX_WINDOW_SAMPLES (1 << 20) // a window in seconds never holds more readings than this
+#define STATEMAP_MIN_CAPACITY 64          // slots of the sensor state map, a power of two
+#define DATA_SENSOR_IDLE_SECONDS 600      // analysis state of a sensor silent this long is freed
+#define DATA_EXPIRY_SWEEP_SECONDS 10      // the data thread looks for idle sensors this often
+#define ALERT_HOT_THRESHOLD 50.0f  // default thresholds of the sensors no profile covers
+#define ALERT_COLD_THRESHOLD 10.0f
+#define ALERT_HYSTERESIS 2.0f      // degrees the average must come back inside a threshold to recover
+#define ALERT_REALERT_SECONDS 300  // an alert is logged at most this often per sensor
+#define THRESHOLD_LINE_LENGTH 256  // longest line of a threshold profile file
+#define DATA_BATCH_MAX_READINGS 256 // readings analyzed per drain of the analysis queue
+#define DATA_IDLE_WAIT_MS 200       // the idle data thread still wakes this often to notice a stop request
 
 #define MAX_CONNECTIONS_PER_IP 5
 #define MAX_UNIQUE_IPS 256
 
+#define HANDSHAKE_TIMEOUT_SECONDS 10
+
+#define TIMER_WHEEL_SLOTS 64 // one slot per second; longer deadlines are re-armed when their slot comes round
+
+// extra return codes of SecureCommunicationInterface send/recv/handshake on non-blocking sockets
+#define SECURE_IO_WANT_READ -2
+#define SECURE_IO_WANT_WRITE -3
+
+// length-prefixed binary measurement frame (all fields big-endian):
+// u16 length | u8 version | u8 count | u32 sequence | u32 base timestamp | count x (u16 offset, u32 float bits)
+#define PROTOCOL_VERSION 1
+#define PROTOCOL_LENGTH_FIELD_SIZE 2 // the length prefix does not count itself
+#define PROTOCOL_HEADER_SIZE 12
+#define PROTOCOL_READING_SIZE 6
+#define PROTOCOL_MAX_READINGS 128
+#define PROTOCOL_MAX_FRAME_SIZE (PROTOCOL_HEADER_SIZE + PROTOCOL_MAX_READINGS * PROTOCOL_READING_SIZE)
+
+#define CONNECTION_RX_BUFFER_SIZE 4096 // per-connection receive buffer, holds several frames
+
+#define SENSOR_SAMPLE_INTERVAL_SECONDS 1 // built-in simulated sensor (connect command)
+#define SENSOR_SAMPLES_PER_FRAME 3
+
 /******************************************************************************/
 /*                              EXPORTED DATA                                 */
 /******************************************************************************/
@@ -67,6 +152,7 @@ typedef struct
 {
     int (*send)(void *self, const char *data, size_t len);
     int (*recv)(void *self, char *buffer, size_t len);
+    int (*handshake)(void *self); // 0 when done, SECURE_IO_WANT_* to resume later, -1 on failure
     void (*close)(void *self);
 } SecureCommunicationInterface;
 
@@ -89,6 +175,24 @@ typedef struct
     int fd;
 } PlainConnection;
 
+// ─── MEASUREMENT PROTOCOL ──────────────────────────────────────────────────────
+//
+typedef struct
+{
+    uint16_t offset;   // seconds after the frame's base timestamp
+    float temperature; // Measured temperature
+} MeasurementReading;
+
+// decoded form of one frame; a frame carries a batch of readings from one sensor
+typedef struct
+{
+    uint8_t version;
+    uint8_t count;
+    uint32_t sequence;       // incremented by the sensor for every frame
+    uint32_t base_timestamp; // Epoch time of the first reading
+    MeasurementReading readings[PROTOCOL_MAX_READINGS];
+} MeasurementFrame;
+
 // ─── DOMAIN MODEL ──────────────────────────────────────────────────────────────
 //
 typedef enum
@@ -97,10 +201,27 @@ typedef enum
     CONN_STATUS_DISCONNECTED,
     CONN_STATUS_TIMEOUT
 } ConnectionStatus;
+
+// handshake progress of an accepted socket, resumed on EPOLLIN/EPOLLOUT
+typedef enum
+{
+    CONN_STATE_TCP_ACCEPTED,
+    CONN_STATE_TLS_HANDSHAKING,
+    CONN_STATE_AWAIT_CLIENT_INFO,
+    CONN_STATE_ESTABLISHED
+} ConnectionState;
+
+// first message a sensor sends after the TLS handshake
+typedef struct
+{
+    int sock_fd;
+    char ip_address[INET_ADDRSTRLEN];
+    int port;
+} ClientInfoPacket;
 typedef struct
 {
     int timestamp;     // Epoch time
-    int sensor_id;     // Unique ID per sensor
+    int sensor_id;     // Stable sensor identity: the port it reported (connection handles change on reconnect)
     float temperature; // Measured temperature
     bool is_valid;     // Data validity
 } SensorData;
@@ -125,31 +246,153 @@ typedef struct
     ConnectionStatus status;
 
     SecureCommunication *secure_comm;
+
+    // handshake state (only meaningful until state == CONN_STATE_ESTABLISHED)
+    ConnectionState state;
+    time_t accepted_time;
+    bool want_write; // epoll currently armed for EPOLLOUT
+
+    // bytes received but not parsed yet (client info, then measurement frames); owned by the connection
+    uint8_t *rx_buffer;
+    size_t rx_length;
+
+    uint32_t next_sequence;
+    bool has_sequence; // next_sequence is known (a frame was already received)
+
+    int shard_index; // reactor shard that owns the socket
 } SensorConnection;
 
 //
 // ─── CONNECTION MANAGER ────────────────────────────────────────────────────────
 //
 
+// intrusive timer, embedded in the object it times out
+typedef struct TimerEntry
+{
+    struct TimerEntry *next;
+    struct TimerEntry *prev;
+    time_t expires;
+    int slot; // wheel slot holding the entry while armed
+    bool armed;
+} TimerEntry;
+
+typedef struct
+{
+    TimerEntry *slots[TIMER_WHEEL_SLOTS];
+    time_t current; // every slot before this second has been processed
+    int timer_fd;   // periodic 1 s timerfd watched by the reactor's I/O backend
+} TimerWheel;
+
 typedef struct ConnectionNode
 {
     SensorConnection connection;
     SensorData latest_data;
+    TimerEntry timer; // handshake deadline while pending, inactivity deadline once established
     struct ConnectionNode *next;
+    struct ConnectionNode *prev;
 } ConnectionNode;
 
+// ─── I/O BACKEND ───────────────────────────────────────────────────────────────
+typedef enum
+{
+    IO_BACKEND_EPOLL,
+    IO_BACKEND_URING // only available when built with USE_URING=1
+} IoBackendType;
+
+typedef enum
+{
+    IO_EVENT_LISTENER, // listener readable: drain it with accept
+    IO_EVENT_ACCEPTED, // `fd` was already accepted by the backend (multishot accept)
+    IO_EVENT_TIMER,    // the timer wheel's timerfd ticked
+    IO_EVENT_SOCKET    // a client socket is ready; handlers read until SECURE_IO_WANT_*
+} IoEventType;
+
 typedef struct
 {
-    ConnectionNode *head;
+    IoEventType type;
+    int fd;
+} IoEvent;
+
+// readiness notifications are edge-like on both backends: a socket is reported again only after new activity
+typedef struct
+{
+    bool (*watch_listener)(void *self, int listen_fd);
+    bool (*watch_timer)(void *self, int timer_fd);
+    bool (*add)(void *self, int fd); // start watching a client socket for input
+    bool (*set_interest)(void *self, int fd, bool want_write);
+    void (*remove)(void *self, int fd); // must be called before the socket is closed
+    int (*wait)(void *self, IoEvent *events, int max_events, int timeout_ms); // -1 on failure
+    void (*destroy)(void *self);
+} IoBackendInterface;
+
+typedef struct
+{
+    IoBackendInterface interface;
+    void *impl;
+    IoBackendType type;
+} IoBackend;
+
+// one pooled connection; `node` must stay the first member
+typedef struct
+{
+    ConnectionNode node;
+    atomic_int handle;   // sensor handle while established, -1 otherwise (readable without locks)
+    uint32_t generation; // bumped on every release, so stale handles never match again
+    int index;
+    int next_free;
+    uint8_t *rx_buffer; // kept across reuse
+} ConnectionSlot;
+
+// growable slab of connection slots; chunks never move, so node pointers stay valid
+typedef struct
+{
+    ConnectionSlot *_Atomic chunks[POOL_MAX_CHUNKS];
+    int chunk_count;
+    int free_head; // -1 when every allocated slot is in use
+    int used;
+    int owner_index; // shard index encoded in the handles
+} ConnectionPool;
+
+// One reactor: its own SO_REUSEPORT listener, I/O backend and slice of the connection table
+typedef struct ConnectionShard
+{
+    int index;
+    int listen_fd;
+    IoBackend *io; // owned by the reactor thread; add/set_interest/remove need the mutex below
+    pthread_t thread;
+    bool thread_started;
+    pthread_mutex_t mutex; // guards everything below
+
+    ConnectionNode *head;         // established connections
+    ConnectionNode *pending_head; // accepted sockets still handshaking
+    int pending_count;
     int active_count;
+
+    ConnectionPool pool; // storage of every node above, indexed by sensor handle
+    ConnectionNode **fd_table; // slot per socket fd (pending and established)
+    int fd_table_size;
+
+    TimerWheel timers; // handshake and inactivity timeouts of this shard's connections
+
+    // accept statistics: each listener wakeup drains the accept queue
+    unsigned long accept_wakeups;
+    unsigned long accepted_total;
+    int max_accepts_per_wakeup;
+} ConnectionShard;
+
+typedef struct
+{
+    ConnectionShard *shards;
+    int shard_count;
     int running_port; // save port running
-    pthread_mutex_t mutex;
+    pthread_mutex_t mutex; // guards running_port and connected_ports
 
-    void (*add)(struct ConnectionNode **, SensorConnection, SensorData);
-    void (*remove)(struct ConnectionNode **, int sensor_id);
-    struct ConnectionNode *(*find)(struct ConnectionNode *, int sensor_id);
-    void (*update)(struct ConnectionNode *, int sensor_id, SensorData);
-    void (*display)(ConnectionNode *);
+    unsigned char connected_ports[(MAX_PORT_NUMBER >> 3) + 1]; // bitmap of reported ports in use
+
+    void (*remove)(int sensor_id);
+    struct ConnectionNode *(*find)(int sensor_id); // caller holds the owning shard's mutex
+    void (*update)(int sensor_id, SensorData);
+    void (*display)(void);
 } ConnectionManager;
 
 //
@@ -187,41 +430,450 @@ typedef struct LogManager
 } LogManager;
 
 // Factory
+//
+// ─── READING QUEUE ─────────────────────────────────────────────────────────────
+//
+
+typedef struct
+{
+    atomic_size_t sequence; // position the cell is ready for (Vyukov bounded queue)
+    SensorData data;
+} ReadingRingCell;
+
+// bounded lock-free multi-producer / single-consumer queue of readings
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t enqueue_pos; // producers (reactor threads)
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t dequeue_pos; // the consumer only
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t high_water_mark;
+    atomic_ulong overflows; // readings dropped because the queue was full
+    ReadingRingCell *cells;
+    size_t mask; // capacity - 1
+} ReadingRing;
+
 //
 // ─── SQL STORAGE MANAGER ───────────────────────────────────────────────────────
 //
 
+typedef enum
+{
+    STORAGE_PROFILE_ROLLBACK, // rollback journal, synchronous FULL (SQLite defaults)
+    STORAGE_PROFILE_SAFE,     // WAL, synchronous FULL: no committed batch is lost on power failure
+    STORAGE_PROFILE_NORMAL,   // WAL, synchronous NORMAL: the last batches may be lost on power failure
+    STORAGE_PROFILE_FAST      // WAL, synchronous OFF: relies on the OS to write the data back
+} StorageProfileType;
+
+typedef struct
+{
+    const char *name;
+    bool wal;
+    const char *synchronous; // PRAGMA synchronous value
+    int page_size;           // bytes, only applies when the database file is created
+    int cache_size_kib;
+    int checkpoint_pages; // passive checkpoint once the WAL holds this many pages
+} StorageProfile;
+
+// bytes SQLite wrote through the counting VFS, by file
+typedef struct
+{
+    atomic_ullong db_bytes;
+    atomic_ullong wal_bytes;
+    atomic_ullong journal_bytes; // rollback journal
+    atomic_ullong temp_bytes;    // sorter spills, statement journals and other temporary files
+    atomic_ulong syncs;
+} StorageIoStats;
+
+// writer side of one day partition
+typedef struct
+{
+    int day; // days since the epoch (UTC), -1 if the entry is unused
+    sqlite3_stmt *insert_stmt;
+    sqlite3_stmt *minute_stmt; // UPSERT into the partition's minute rollup
+    unsigned long last_used;
+    int rows; // rows the current transaction inserted, not yet added to the catalog
+    int min_timestamp;
+    int max_timestamp;
+} PartitionWriter;
+
+// Gorilla-style encoder: delta-of-delta timestamps and XOR-compressed float values, bits written MSB first
+typedef struct
+{
+    unsigned char *out;
+    size_t capacity;
+    size_t size;        // complete bytes in `out`
+    uint64_t bits;      // bits not yet forming a byte
+    int bit_count;
+    int count;          // readings encoded
+    uint32_t timestamp; // previous reading
+    uint32_t delta;
+    uint32_t value;
+    int leading;        // XOR window of the previous value
+    int trailing;
+} GorillaEncoder;
+
+typedef struct
+{
+    const unsigned char *in;
+    size_t size;
+    size_t offset;      // next byte of `in`
+    uint64_t bits;
+    int bit_count;
+    int count;          // readings decoded
+    int remaining;
+    uint32_t timestamp;
+    uint32_t delta;
+    uint32_t value;
+    int leading;
+    int trailing;
+} GorillaDecoder;
+
+typedef struct
+{
+    PartitionWriter writers[STORAGE_PARTITION_CACHE];
+    sqlite3_stmt *catalog_stmt; // UPSERT of a partition's row count and time range
+    unsigned long clock;        // LRU clock of `writers`
+    long long compact_window;   // windows before this one are compacted
+    long long written_window;   // oldest window written since the compaction last ran
+    atomic_ulong encoded_readings; // readings written as chunks, compactions included
+    atomic_ulong encoded_bytes;    // size of their encoded data
+    atomic_ulong compacted_chunks; // small chunks merged by the compaction
+} PartitionWriterCache;
+
+// count, sum, min, max and last value of the readings of one sensor over a period
+typedef struct
+{
+    long count;
+    double sum;
+    double min;
+    double max;
+    double last;
+    int last_timestamp;
+} RollupAggregate;
+
+// rows an aggregate query read at each resolution
+typedef struct
+{
+    int hour_rows;
+    int minute_rows;
+    int raw_rows;
+} RollupQueryStats;
+
+// one row of the partition catalog
+typedef struct
+{
+    int day;
+    char table_name[STORAGE_PARTITION_NAME_SIZE];
+    long rows;
+    int min_timestamp;
+    int max_timestamp;
+} PartitionInfo;
+
+// position after the last row of a page; rows are ordered by (timestamp, id)
+typedef struct
+{
+    int timestamp;
+    long id;
+} ReadingCursor;
+
+// outcome of printing one page of readings
+typedef struct
+{
+    bool more;          // the page is full, more rows may follow
+    ReadingCursor next; // cursor of the next page, valid when `more`
+} ReadingPage;
+
+// first bytes of the spill journal
+typedef struct
+{
+    uint32_t magic;
+    uint32_t record_size;
+    uint64_t replay_offset; // records before this file offset are in the database
+} SpillHeader;
+
+// one reading in the spill journal
+typedef struct
+{
+    uint32_t crc; // CRC-32 of the fields below; a mismatch marks the end of the journal
+    int32_t timestamp;
+    int32_t sensor_id;
+    float temperature;
+} SpillRecord;
+
+// append-only, mmap-backed journal of the readings that could not reach the database
+typedef struct
+{
+    const char *path;
+    int fd;              // -1 if the journal could not be opened
+    SpillHeader *header; // first page of the file, mapped while open
+    unsigned char *window; // SPILL_WINDOW_BYTES mapped at `window_offset`, NULL if none
+    off_t window_offset;
+    off_t write_offset; // end of the last record (storage thread only)
+    off_t file_size;    // allocated size of the file
+    off_t live_offset;  // windows before this offset were replayed and their space given back
+    off_t max_bytes;    // cap on the space from live_offset to the end of the file, 0 for none
+    atomic_ulong pending; // records not replayed yet
+    atomic_ulong spilled;
+    atomic_ulong replayed;
+    atomic_ulong dropped; // readings lost because the journal was full or failed
+} SpillJournal;
+
+// a page of readings to read
+typedef struct
+{
+    int sensor_id; // -1 for every sensor
+    int from;      // first epoch second
+    int to;        // last epoch second
+    int limit;     // rows per page
+    bool has_cursor;
+    ReadingCursor after; // resume after this row when has_cursor
+} ReadingQuery;
+
+// ─── STORAGE BACKEND ───────────────────────────────────────────────────────────
+typedef enum
+{
+    STORAGE_BACKEND_SQLITE,  // day partitions, rollups and a WAL in sensor_data.db
+    STORAGE_BACKEND_SEGMENT  // append-only fixed-size segment files in SEGMENT_DIR
+} StorageBackendType;
+
+// receives each reading returned by a range query; `id` orders readings of the same second
+typedef void (*ReadingVisitor)(const SensorData *data, long id, void *arg);
+
+// append_batch/drop_before/flush run on the storage thread, query_range/aggregate on the user interface thread
+typedef struct
+{
+    bool (*open)(void *self); // false if unavailable; retried SQL_RETRY_DELAY_SEC later
+    // stores a batch in one unit (may reorder `batch`); readings of days before first_kept_day are skipped
+    bool (*append_batch)(void *self, SensorData *batch, int count, int first_kept_day, int *expired);
+    // visits up to `max` readings matching `query` stored after `after`, which is moved to the last one;
+    // returns the number visited, -1 on failure
+    int (*query_range)(void *self, const ReadingQuery *query, ReadingCursor *after, int max,
+                       ReadingVisitor visit, void *arg);
+    // optional (NULL: computed from query_range)
+    bool (*aggregate)(void *self, const ReadingQuery *query, RollupAggregate *aggregate, RollupQueryStats *stats);
+    int (*drop_before)(void *self, int first_kept_day); // units of storage dropped, -1 on failure
+    void (*flush)(void *self);                          // called once the writer is idle
+    void (*display_stats)(void *self);
+    const char *(*last_error)(void *self);
+    void (*close)(void *self);
+} StorageBackendInterface;
+
+typedef struct
+{
+    StorageBackendInterface interface;
+    void *impl;
+    StorageBackendType type;
+} StorageBackend;
+
+// one reading in a segment file
+typedef struct
+{
+    int32_t timestamp;
+    int32_t sensor_id;
+    float temperature;
+} SegmentRecord;
+
+// time range of one block of SEGMENT_BLOCK_RECORDS records
+typedef struct
+{
+    int32_t min_timestamp;
+    int32_t max_timestamp;
+} SegmentIndexEntry;
+
+// first page of a segment file
+typedef struct
+{
+    uint32_t magic;
+    uint32_t record_size;
+    uint32_t sequence; // segments are filled in sequence order
+    uint32_t count;    // records written
+    int32_t min_timestamp;
+    int32_t max_timestamp;
+    SegmentIndexEntry index[SEGMENT_RECORDS / SEGMENT_BLOCK_RECORDS]; // sparse time index
+} SegmentHeader;
+
+// catalog entry of a segment, copied by readers
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t count;
+    int min_timestamp;
+    int max_timestamp;
+} SegmentInfo;
+
+typedef struct
+{
+    const char *directory;
+    pthread_mutex_t mutex; // guards the catalog: `segments` and `segment_count`
+    SegmentInfo *segments; // sorted by sequence, the last one is being written
+    int segment_count;
+    int segment_capacity;
+
+    int active_fd;          // segment being written, -1 if none (writer only)
+    unsigned char *active;  // its mapping, header then records
+    bool dirty;             // written since the last sync
+    bool sync_each_batch;   // msync after every batch (profiles with synchronous != OFF)
+    atomic_ulong syncs;
+    char error[128];
+} SegmentStore;
+
 typedef struct
 {
     char status[20]; // CONNECTED / DISCONNECTED
     int retry_count;
     time_t last_retry_time;
     sqlite3 *db_handle;
+    PartitionWriterCache partitions; // INSERT statements of the partitions being written
+    sqlite3_stmt *hour_rollup_stmt;  // UPSERT into sensor_rollup_hour
+    sqlite3 *read_handle;      // read-only connection for the user interface, never used by the writer
 } SQLConnectionInfo;
 
 typedef struct
 {
-    SQLConnectionInfo sql_info;
-    pthread_mutex_t mutex;
+    StorageBackend backend;
+    SQLConnectionInfo sql_info; // connection state of the backend; the SQLite handles when it is the backend
+    SegmentStore segments;      // state of the segment backend
+    pthread_mutex_t mutex; // guards the counters below
     int total_messages_received;
-    ConnectionNode *pending_data_head; // linked lists contain waiting data
+    unsigned long batches_committed;
+    unsigned long checkpoints;            // passive checkpoints run by the WAL policy
+    unsigned long truncating_checkpoints; // checkpoints that reset the WAL while idle
+
+    const StorageProfile *profile;
+    StorageIoStats io_stats;
+    int wal_pages;               // pages in the WAL after the last commit (storage thread only)
+    struct timespec last_commit; // CLOCK_MONOTONIC time of the last commit (storage thread only)
+    int retention_day;           // UTC day the retention policy last ran (storage thread only)
+    unsigned long partitions_dropped;
+    unsigned long expired_readings; // readings older than the retention window, not stored
+
+    ReadingRing pending; // readings waiting for the database, filled without locks
+    sem_t batch_ready;   // posted when the queue becomes non-empty or a full batch is pending
+    atomic_bool wake_pending;
+    SensorData *batch; // batch being written (storage thread only)
+    int batch_count;
+
+    SpillJournal spill;       // readings written while the database is unavailable
+    SensorData *replay_batch; // records read back from the journal (storage thread only)
 } StorageManager;
 
 // Struct: DataManager - manage data
 //--------------------------------------------------
+
+// length of the analysis window: the last `samples` readings, or the readings of the last `seconds`
 typedef struct
 {
-    float history[TEMPERATURE_HISTORY_SIZE];
-    int count;
-    int index;
-} TemperatureHistory;
+    int samples; // 0 when the window is in seconds
+    int seconds; // 0 when the window is in samples
+} StatsWindow;
+
+// one reading in a sliding window
+typedef struct
+{
+    int timestamp;
+    float value;
+} StatsSample;
+
+// sliding-window statistics of one sensor, updated in constant time per reading
+typedef struct
+{
+    StatsSample *samples;   // ring of the readings in the window, sample `seq` at seq & (capacity - 1)
+    unsigned long *min_seq; // monotonic deques of sample sequence numbers, same capacity and indexing
+    unsigned long *max_seq;
+    size_t capacity;        // power of two, grows by doubling
+    unsigned long head;     // sequence number of the oldest sample in the window
+    unsigned long tail;     // sequence number of the next sample
+    unsigned long min_head, min_tail;
+    unsigned long max_head, max_tail;
+    double sum;
+    double mean; // Welford running mean and sum of squared deviations over the window
+    double m2;
+    double ewma;
+    unsigned long total; // readings ever added
+} SensorStats;
+
+// statistics of a window at one point in time
+typedef struct
+{
+    long count;
+    double mean;
+    double ewma;
+    double min;
+    double max;
+    double stddev;
+} StatsSnapshot;
+
+typedef enum
+{
+    ALERT_NORMAL,
+    ALERT_HOT,
+    ALERT_COLD
+} AlertLevel;
 
+// threshold alert state machine of one sensor
+typedef struct
+{
+    AlertLevel level;
+    bool reported;            // the current alarm was logged
+    long entered_at;          // CLOCK_MONOTONIC second the current alarm started
+    long last_alert;          // CLOCK_MONOTONIC second an alarm was last logged, 0 if never
+    unsigned long suppressed; // alarm events not logged since then
+} AlertState;
+
+// analysis state of one sensor
 typedef struct
 {
+    int sensor_id;  // key, -1 for a free slot
+    long last_seen; // CLOCK_MONOTONIC second of the last reading
+    SensorStats stats;
+    AlertState alert;
+} SensorState;
+
+// open-addressing hash map of sensor states keyed by sensor ID (linear probing, no tombstones)
+typedef struct
+{
+    SensorState *slots;
+    size_t capacity; // power of two, at least STATEMAP_MIN_CAPACITY
+    size_t count;
+} SensorStateMap;
+
+// alert thresholds of a range of reported sensor ports
+typedef struct
+{
+    int first_port; // inclusive range of reported ports, -1 for the default profile
+    int last_port;
     float hot_threshold;
     float cold_threshold;
+    float hysteresis;    // see ALERT_HYSTERESIS
+    int realert_seconds; // see ALERT_REALERT_SECONDS
+} ThresholdProfile;
+
+// immutable set of threshold profiles, replaced as a whole on reload
+typedef struct ThresholdTable
+{
+    ThresholdProfile fallback;  // sensors no profile covers
+    ThresholdProfile *profiles; // sorted by first_port, ranges never overlap
+    size_t count;
+    unsigned long generation;            // 1 at startup, +1 per reload
+    struct ThresholdTable *next_retired; // replaced tables waiting to be freed (reloading thread only)
+} ThresholdTable;
+
+typedef struct
+{
+    _Atomic(ThresholdTable *) thresholds; // current profiles, read by the data thread without locks
+    atomic_ulong thresholds_quiescent;    // newest generation the data thread has seen between batches
+    ThresholdTable *thresholds_retired;   // replaced tables, freed once the data thread is past them
+    unsigned long alerts_logged;
+    unsigned long alerts_suppressed;
     pthread_mutex_t mutex;
-    TemperatureHistory *sensor_histories;
+    SensorStateMap sensors;      // analysis state of the sensors heard from recently
+    unsigned long sensors_expired;
+    long next_expiry_sweep;      // CLOCK_MONOTONIC second (data thread only)
+
+    ReadingRing readings;     // readings waiting for analysis, filled by the reactors without locks
+    sem_t reading_ready;      // posted when the queue becomes non-empty
+    atomic_bool wake_pending;
+    SensorData *batch;        // readings being analyzed (data thread only)
+    atomic_ulong analyzed;
 } DataManager;
 //
 // ─── SECURITY MANAGER ───────────────────────────────────────────────────────
@@ -244,8 +896,27 @@ typedef struct
 // ─── CENTRAL SYSTEM MANAGER ────────────────────────────────────────────────────
 //
 
+// runtime options parsed from the command line
 typedef struct
 {
+    int reactor_count; // connection manager threads, one SO_REUSEPORT listener each
+    int listen_backlog;
+    int epoll_batch; // events handled per backend wait
+    IoBackendType io_backend;
+    StorageProfileType storage_profile;
+    StorageBackendType storage_backend;
+    int retention_days; // 0 keeps every partition
+    int analysis_batch; // readings the data thread drains at once, 1 analyzes them one by one
+    StatsWindow stats_window;
+    int sensor_idle_seconds; // analysis state of a silent sensor is freed after this, 0 keeps it
+    long spill_max_mib;      // cap on the unreplayed spill journal, 0 for none (free disk space only)
+    const char *thresholds_path; // threshold profile file, NULL for the built-in thresholds only
+} GatewayConfig;
+
+typedef struct
+{
+    GatewayConfig config;
+
     ConnectionManager connection_manager;
     LogManager log_manager;
     StorageManager storage_manager;
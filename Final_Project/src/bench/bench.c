@@ -0,0 +1,570 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#define _GNU_SOURCE // nftw()
+#include <ftw.h>
+#include "../../include/shared_data.h"
+#include "../utils/utils.h"
+#include "../storage/storage.h"
+#include "../ring/ring.h"
+/******************************************************************************/
+/*                              EXPORTED DATA                                 */
+/******************************************************************************/
+// required by the storage module
+SystemManager system_manager;
+volatile sig_atomic_t stop_requested = 0;
+/******************************************************************************/
+/*                     PRIVATE TYPES and DEFINITIONS                          */
+/******************************************************************************/
+#define BENCH_CONNECT_TIMEOUT_SECONDS 10.0
+#define BENCH_DRAIN_TIMEOUT_SECONDS 120.0 // time allowed for the queued readings to be committed
+#define BENCH_POLL_SECONDS 0.001
+#define BENCH_MAX_PRODUCERS 64
+#define BENCH_QUERY_COUNT 5
+
+typedef struct
+{
+    StorageBackendType backend;
+    StorageProfileType profile;
+    long readings;         // total readings enqueued
+    int sensors;
+    int producers;         // enqueuing threads, like reactor threads
+    double rate;           // readings per second over all producers, 0 = as fast as the queue drains
+    int burst;             // readings of one sensor enqueued back to back, like one frame
+    int query_runs;        // runs of each range query
+    const char *directory; // NULL: temporary directory removed at the end
+    const char *output;    // JSON report, NULL for stdout
+} BenchConfig;
+
+// growable array of latency samples
+typedef struct
+{
+    double *values;
+    size_t count;
+    size_t capacity;
+} SampleSet;
+
+typedef struct
+{
+    int index;
+    pthread_t thread;
+    long enqueued;
+    SampleSet latency; // storage_add_data() calls, microseconds
+} BenchProducer;
+
+// one kind of range query, run `query_runs` times
+typedef struct
+{
+    const char *name;
+    const char *description;
+    SampleSet latency; // milliseconds
+    long rows;         // readings visited by the last run
+} BenchQuery;
+
+// visits the readings of a query without printing them
+typedef struct
+{
+    long rows;
+    RollupAggregate aggregate;
+} QueryResult;
+/******************************************************************************/
+/*                              PRIVATE DATA                                  */
+/******************************************************************************/
+static BenchConfig config;
+static int first_timestamp; // timestamp of the first reading of every sensor
+static long readings_per_sensor;
+static double producers_started;
+static long long disk_total; // nftw has no callback argument
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns a monotonic timestamp in seconds.
+ *
+ * \return double Seconds since an arbitrary point.
+ */
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/**
+ * \brief Sleeps for a fractional number of seconds.
+ *
+ * \param seconds Time to sleep (ignored if not positive).
+ */
+static void sleep_seconds(double seconds)
+{
+    if (seconds <= 0)
+        return;
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+}
+/**
+ * \brief Appends a sample to a set.
+ *
+ * \param set The sample set.
+ * \param value The sample.
+ */
+static void sample_add(SampleSet *set, double value)
+{
+    if (set->count == set->capacity)
+    {
+        size_t capacity = set->capacity ? set->capacity * 2 : 1024;
+        double *grown = realloc(set->values, capacity * sizeof(double));
+        if (!grown)
+            return;
+        set->values = grown;
+        set->capacity = capacity;
+    }
+    set->values[set->count++] = value;
+}
+/**
+ * \brief qsort comparator for doubles.
+ */
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+/**
+ * \brief Writes the percentiles of a sample set as JSON members (sorts it in place).
+ *
+ * \param out The report.
+ * \param set The sample set.
+ */
+static void write_percentiles(FILE *out, SampleSet *set)
+{
+    if (set->count == 0)
+    {
+        fprintf(out, "\"samples\": 0");
+        return;
+    }
+    qsort(set->values, set->count, sizeof(double), compare_doubles);
+#define PERCENTILE(p) set->values[(size_t)((p) * (set->count - 1))]
+    fprintf(out, "\"samples\": %zu, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f", set->count,
+            PERCENTILE(0.50), PERCENTILE(0.99), set->values[set->count - 1]);
+#undef PERCENTILE
+}
+/**
+ * \brief Bench log manager: errors and warnings go to stderr, the rest is dropped.
+ */
+static void bench_log(LogManager *self, LogLevel level, const char *source, const char *message)
+{
+    (void)self;
+    if (level == LOG_ERROR || level == LOG_WARNING)
+        fprintf(stderr, "[%s] %s\n", source, message);
+}
+/**
+ * \brief Adds the size of a file to the running total (nftw callback).
+ */
+static int add_file_size(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    (void)path;
+    (void)ftw;
+    if (type == FTW_F)
+        disk_total += st->st_size;
+    return 0;
+}
+/**
+ * \brief Returns the size of every file under the bench directory.
+ *
+ * \return long long Bytes.
+ */
+static long long disk_usage()
+{
+    disk_total = 0;
+    nftw(".", add_file_size, 16, FTW_PHYS);
+    return disk_total;
+}
+/**
+ * \brief Removes a file or an empty directory (nftw callback).
+ */
+static int remove_entry(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+/**
+ * \brief Returns the number of readings committed so far.
+ */
+static long committed_readings()
+{
+    pthread_mutex_lock(&system_manager.storage_manager.mutex);
+    long rows = system_manager.storage_manager.total_messages_received;
+    pthread_mutex_unlock(&system_manager.storage_manager.mutex);
+    return rows;
+}
+/**
+ * \brief Producer thread: enqueues its share of the sensors' readings and times each storage_add_data().
+ *
+ * \param arg The BenchProducer.
+ *
+ * \return NULL
+ *
+ * \note Producer i owns the sensors i, i + producers, ... Every sensor sends one reading per second from
+ *       `first_timestamp`; the readings of a burst are consecutive seconds of one sensor, as in a frame.
+ *       With a rate the producer sleeps to keep its share of it; without one it pauses while the queue is
+ *       more than half full, so the run measures the commit path instead of queue overflows.
+ */
+static void *producer_main(void *arg)
+{
+    BenchProducer *producer = arg;
+    ReadingRing *pending = &system_manager.storage_manager.pending;
+    double share = config.rate / config.producers;
+    unsigned int seed = (unsigned int)(producer->index * 2654435761u);
+
+    for (long offset = 0; offset < readings_per_sensor; offset += config.burst)
+    {
+        for (int sensor = producer->index; sensor < config.sensors; sensor += config.producers)
+        {
+            if (config.rate > 0)
+                sleep_seconds(producers_started + producer->enqueued / share - now_seconds());
+            else
+                while (ring_size(pending) > ring_capacity(pending) / 2)
+                    sleep_seconds(BENCH_POLL_SECONDS);
+
+            for (long i = offset; i < offset + config.burst && i < readings_per_sensor; i++)
+            {
+                SensorData data = {.timestamp = first_timestamp + (int)i,
+                                   .sensor_id = sensor,
+                                   .temperature = 20.0f + (float)(rand_r(&seed) % 400) / 100.0f,
+                                   .is_valid = true};
+                double started = now_seconds();
+                storage_add_data(data);
+                sample_add(&producer->latency, (now_seconds() - started) * 1e6);
+                producer->enqueued++;
+            }
+        }
+    }
+    return NULL;
+}
+/**
+ * \brief Counts one reading of a query (ReadingVisitor).
+ */
+static void count_reading(const SensorData *data, long id, void *arg)
+{
+    (void)data;
+    (void)id;
+    ((QueryResult *)arg)->rows++;
+}
+/**
+ * \brief Adds one reading to the aggregate of a query (ReadingVisitor).
+ */
+static void aggregate_reading(const SensorData *data, long id, void *arg)
+{
+    (void)id;
+    RollupAggregate *aggregate = &((QueryResult *)arg)->aggregate;
+    if (aggregate->count == 0 || data->temperature < aggregate->min)
+        aggregate->min = data->temperature;
+    if (aggregate->count == 0 || data->temperature > aggregate->max)
+        aggregate->max = data->temperature;
+    aggregate->count++;
+    aggregate->sum += data->temperature;
+    ((QueryResult *)arg)->rows++;
+}
+/**
+ * \brief Runs one query of the suite the way the user interface does.
+ *
+ * \param kind Index of the query in the suite.
+ * \param run Run number; the sensor-filtered queries rotate over the sensors.
+ * \param result Output: the readings visited.
+ *
+ * \return bool true on success, false otherwise.
+ */
+static bool run_query(int kind, int run, QueryResult *result)
+{
+    StorageBackend *backend = &system_manager.storage_manager.backend;
+    int last_timestamp = first_timestamp + (int)readings_per_sensor - 1;
+    ReadingQuery query = {-1, first_timestamp, last_timestamp, STORAGE_PAGE_DEFAULT_ROWS, false, {0, 0}};
+    ReadingCursor after = {INT_MIN, LONG_MIN};
+    int max = query.limit;
+
+    memset(result, 0, sizeof(*result));
+    switch (kind)
+    {
+    case 0: // readdb: first page over everything
+        break;
+    case 1: // readdb sensor=N from=<last hour>: one large page
+        query.sensor_id = run % config.sensors;
+        query.from = last_timestamp - 3599;
+        query.limit = max = STORAGE_PAGE_MAX_ROWS;
+        break;
+    case 2: // every sensor over the last hour
+        query.from = last_timestamp - 3599;
+        max = INT_MAX;
+        break;
+    case 3: // aggregate sensor=N over everything
+        query.sensor_id = run % config.sensors;
+        if (backend->interface.aggregate)
+        {
+            RollupQueryStats stats;
+            if (!backend->interface.aggregate(backend->impl, &query, &result->aggregate, &stats))
+                return false;
+            result->rows = result->aggregate.count;
+            return true;
+        }
+        return backend->interface.query_range(backend->impl, &query, &after, INT_MAX, aggregate_reading,
+                                              result) >= 0;
+    default: // full scan, what printing the whole table costs without the console
+        max = INT_MAX;
+        break;
+    }
+    return backend->interface.query_range(backend->impl, &query, &after, max, count_reading, result) >= 0;
+}
+/**
+ * \brief Prints the command line usage.
+ *
+ * \param program argv[0].
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-S sqlite|segment] [-s rollback|safe|normal|fast] [-n readings] [-m sensors]\n"
+            "          [-t producers] [-r readings/s, 0 = unthrottled] [-f readings per burst] [-q query runs]\n"
+            "          [-d directory] [-o report.json]\n",
+            program);
+}
+/**
+ * \brief Parses the command line into the bench configuration.
+ *
+ * \param argc Argument count.
+ * \param argv Argument vector.
+ *
+ * \return int 0 on success, -1 on invalid usage.
+ */
+static int parse_arguments(int argc, char *argv[])
+{
+    config.backend = STORAGE_BACKEND_SQLITE;
+    config.profile = STORAGE_PROFILE_NORMAL;
+    config.readings = 200000;
+    config.sensors = 100;
+    config.producers = 1;
+    config.rate = 0.0;
+    config.burst = SENSOR_SAMPLES_PER_FRAME;
+    config.query_runs = 20;
+    config.directory = NULL;
+    config.output = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "S:s:n:m:t:r:f:q:d:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'S':
+            if (!storage_backend_from_name(optarg, &config.backend))
+                return -1;
+            break;
+        case 's':
+            if (!storage_profile_from_name(optarg, &config.profile))
+                return -1;
+            break;
+        case 'n':
+            config.readings = atol(optarg);
+            break;
+        case 'm':
+            config.sensors = atoi(optarg);
+            break;
+        case 't':
+            config.producers = atoi(optarg);
+            break;
+        case 'r':
+            config.rate = atof(optarg);
+            break;
+        case 'f':
+            config.burst = atoi(optarg);
+            break;
+        case 'q':
+            config.query_runs = atoi(optarg);
+            break;
+        case 'd':
+            config.directory = optarg;
+            break;
+        case 'o':
+            config.output = optarg;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    if (optind != argc || config.readings < 1 || config.sensors < 1 || config.producers < 1 ||
+        config.producers > BENCH_MAX_PRODUCERS || config.rate < 0 || config.burst < 1 || config.query_runs < 1)
+        return -1;
+    if (config.producers > config.sensors)
+        config.producers = config.sensors;
+    return 0;
+}
+/**
+ * \brief Writes the JSON report.
+ *
+ * \param out The report.
+ * \param producers The producer array.
+ * \param queries The query suite.
+ * \param committed Readings committed by the run.
+ * \param ingest_seconds From the first enqueue to the last commit.
+ * \param disk Bytes on disk before the run, after the ingest and after closing the backend.
+ */
+static void write_report(FILE *out, BenchProducer *producers, BenchQuery *queries, long committed,
+                         double ingest_seconds, const long long disk[3])
+{
+    StorageManager *storage = &system_manager.storage_manager;
+    SampleSet enqueue = {0};
+    long enqueued = 0;
+    for (int i = 0; i < config.producers; i++)
+    {
+        enqueued += producers[i].enqueued;
+        for (size_t j = 0; j < producers[i].latency.count; j++)
+            sample_add(&enqueue, producers[i].latency.values[j]);
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"config\": {\"backend\": \"%s\", \"profile\": \"%s\", \"readings\": %ld, \"sensors\": %d, "
+                 "\"producers\": %d, \"rate\": %.1f, \"burst\": %d, \"batch_max_rows\": %d},\n",
+            storage_backend_name(config.backend), storage_profile_get(config.profile)->name, config.readings,
+            config.sensors, config.producers, config.rate, config.burst, STORAGE_BATCH_MAX_ROWS);
+    fprintf(out, "  \"enqueue_us\": {");
+    write_percentiles(out, &enqueue);
+    fprintf(out, ", \"dropped\": %lu, \"queue_high_water_mark\": %zu},\n",
+            atomic_load(&storage->pending.overflows), atomic_load(&storage->pending.high_water_mark));
+    fprintf(out, "  \"commit\": {\"enqueued\": %ld, \"committed\": %ld, \"spilled\": %lu, \"batches\": %lu, "
+                 "\"seconds\": %.3f, \"rows_per_second\": %.1f},\n",
+            enqueued, committed, atomic_load(&storage->spill.spilled), storage->batches_committed, ingest_seconds,
+            ingest_seconds > 0 ? committed / ingest_seconds : 0.0);
+    fprintf(out, "  \"disk\": {\"bytes_before\": %lld, \"bytes_after_ingest\": %lld, \"bytes_after_close\": %lld, "
+                 "\"bytes_per_reading\": %.2f, \"write_amplification\": %.2f, \"syncs\": %lu},\n",
+            disk[0], disk[1], disk[2], committed > 0 ? (double)(disk[2] - disk[0]) / committed : 0.0,
+            storage_write_amplification(), atomic_load(&storage->io_stats.syncs));
+    fprintf(out, "  \"queries_ms\": [\n");
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++)
+    {
+        fprintf(out, "    {\"name\": \"%s\", \"query\": \"%s\", \"rows\": %ld, ", queries[i].name,
+                queries[i].description, queries[i].rows);
+        write_percentiles(out, &queries[i].latency);
+        fprintf(out, "}%s\n", i + 1 < BENCH_QUERY_COUNT ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    free(enqueue.values);
+}
+
+// ==== Main Function ====
+
+int main(int argc, char *argv[])
+{
+    if (parse_arguments(argc, argv) < 0)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // the storage files are created in the working directory
+    char temporary[] = "/tmp/storage_bench.XXXXXX";
+    const char *directory = config.directory;
+    if (directory == NULL && (directory = mkdtemp(temporary)) == NULL)
+    {
+        handle_error("Failed to create the bench directory");
+        return EXIT_FAILURE;
+    }
+    mkdir(directory, 0755);
+    FILE *out = config.output ? fopen(config.output, "w") : stdout;
+    if (out == NULL || chdir(directory) != 0)
+    {
+        handle_error("Failed to open the bench directory or report");
+        return EXIT_FAILURE;
+    }
+
+    system_manager.log_manager.log = bench_log;
+    system_manager.config.storage_backend = config.backend;
+    system_manager.config.storage_profile = config.profile;
+    system_manager.config.retention_days = 0;
+    system_manager.config.spill_max_mib = SPILL_DEFAULT_MAX_MIB;
+
+    long long disk[3];
+    disk[0] = disk_usage();
+    init_storage_manager();
+    pthread_t storage_thread;
+    pthread_create(&storage_thread, NULL, storage_manager, NULL);
+
+    double deadline = now_seconds() + BENCH_CONNECT_TIMEOUT_SECONDS;
+    while (strcmp(system_manager.storage_manager.sql_info.status, SQL_CONNECTED) != 0 && now_seconds() < deadline)
+        sleep_seconds(BENCH_POLL_SECONDS);
+
+    // every sensor sends one reading per second, the last ones just now
+    readings_per_sensor = (config.readings + config.sensors - 1) / config.sensors;
+    first_timestamp = (int)time(NULL) - (int)readings_per_sensor;
+    long committed_before = committed_readings();
+
+    BenchProducer producers[BENCH_MAX_PRODUCERS];
+    memset(producers, 0, sizeof(producers));
+    producers_started = now_seconds();
+    for (int i = 0; i < config.producers; i++)
+    {
+        producers[i].index = i;
+        pthread_create(&producers[i].thread, NULL, producer_main, &producers[i]);
+    }
+    long enqueued = 0;
+    for (int i = 0; i < config.producers; i++)
+    {
+        pthread_join(producers[i].thread, NULL);
+        enqueued += producers[i].enqueued;
+    }
+
+    // the ingest ends once every reading not dropped is committed or spilled
+    long expected = enqueued - (long)atomic_load(&system_manager.storage_manager.pending.overflows);
+    deadline = now_seconds() + BENCH_DRAIN_TIMEOUT_SECONDS;
+    while (committed_readings() - committed_before +
+                   (long)atomic_load(&system_manager.storage_manager.spill.spilled) < expected &&
+           now_seconds() < deadline)
+        sleep_seconds(BENCH_POLL_SECONDS);
+    double ingest_seconds = now_seconds() - producers_started;
+    long committed = committed_readings() - committed_before;
+    disk[1] = disk_usage();
+    fprintf(stderr, "Ingested %ld readings in %.2f s, running the queries\n", enqueued, ingest_seconds);
+
+    BenchQuery queries[BENCH_QUERY_COUNT] = {
+        {"page_first", "readdb (first page of 50 over everything)", {0}, 0},
+        {"page_sensor_hour", "readdb sensor=N, last hour, limit 10000", {0}, 0},
+        {"scan_hour", "every sensor over the last hour", {0}, 0},
+        {"aggregate_sensor", "aggregate sensor=N over everything", {0}, 0},
+        {"scan_all", "every reading, as printing the whole database reads them", {0}, 0},
+    };
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++)
+    {
+        for (int run = 0; run < config.query_runs; run++)
+        {
+            QueryResult result;
+            double started = now_seconds();
+            if (!run_query(i, run, &result))
+            {
+                fprintf(stderr, "Query %s failed\n", queries[i].name);
+                break;
+            }
+            sample_add(&queries[i].latency, (now_seconds() - started) * 1e3);
+            queries[i].rows = result.rows;
+        }
+    }
+
+    stop_requested = 1;
+    pthread_join(storage_thread, NULL);
+    cleanup_storage_manager();
+    disk[2] = disk_usage();
+
+    write_report(out, producers, queries, committed, ingest_seconds, disk);
+    if (out != stdout)
+        fclose(out);
+
+    for (int i = 0; i < config.producers; i++)
+        free(producers[i].latency.values);
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++)
+        free(queries[i].latency.values);
+    if (config.directory == NULL)
+    {
+        if (chdir("/") == 0)
+            nftw(directory, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    return EXIT_SUCCESS;
+}
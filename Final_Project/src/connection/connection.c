@@ -5,160 +5,340 @@
 /******************************************************************************/
 /*                            FUNCTIONS                              */
 /******************************************************************************/
+/*---------------Reactor shards-------------------------------------------------------------*/
 /**
- * \brief Creates a new node for the connection list.
+ * \brief Returns the reactor shard that owns a sensor ID.
  *
- * Allocates memory for a new ConnectionNode, initializes its fields with the provided
- * sensor connection and sensor data, and sets the next pointer to NULL.
- * If memory allocation fails, returns NULL.
+ * Sensor IDs are pool handles that carry their shard index in the low bits, so the
+ * owning shard is recovered without any lookup.
  *
- * \param connection The SensorConnection structure containing the details of the sensor connection.
- * \param data The SensorData structure containing the latest data for the sensor connection.
+ * \param sensor_id The sensor ID.
  *
- * \return ConnectionNode* Pointer to the newly created node, or NULL if memory allocation fails.
+ * \return ConnectionShard* The owning shard, or NULL for an invalid ID.
  */
-static ConnectionNode *create_node(SensorConnection connection, SensorData data)
+ConnectionShard *connection_shard_of(int sensor_id)
 {
-    ConnectionNode *node = (ConnectionNode *)malloc(sizeof(ConnectionNode));
-    if (!node)
+    ConnectionManager *manager = &system_manager.connection_manager;
+
+    if (sensor_id < 0 || HANDLE_SHARD(sensor_id) >= manager->shard_count)
         return NULL;
-    node->connection = connection;
-    node->latest_data = data;
-    node->next = NULL;
-    return node;
+    return &manager->shards[HANDLE_SHARD(sensor_id)];
 }
+/**
+ * \brief Tells whether a sensor ID still refers to a live connection.
+ *
+ * \param sensor_id The sensor ID (pool handle).
+ *
+ * \return bool true if the sensor is connected and the ID was not recycled since.
+ *
+ * \note Lock-free, so data and storage threads can check IDs without touching the shard mutex.
+ */
+bool connection_is_live(int sensor_id)
+{
+    ConnectionShard *shard = connection_shard_of(sensor_id);
+    return shard && connection_pool_is_live(&shard->pool, sensor_id);
+}
+/*---------------O(1) connection indexes---------------------------------------------------*/
+/**
+ * \brief Grows a dense slot table so that `index` is a valid slot.
+ *
+ * The table at least doubles on each growth, new slots are zeroed.
+ * Must be called with the shard mutex held.
+ *
+ * \param table Pointer to the table pointer.
+ * \param size Pointer to the current number of slots.
+ * \param index The slot that must become addressable.
+ *
+ * \return bool true on success, false if memory allocation fails.
+ */
+static bool ensure_table_slot(ConnectionNode ***table, int *size, int index)
+{
+    if (index < *size)
+        return true;
+
+    int new_size = *size > 0 ? *size : CONNECTION_TABLE_INITIAL_SIZE;
+    while (new_size <= index)
+        new_size *= 2;
 
+    ConnectionNode **grown = realloc(*table, new_size * sizeof(ConnectionNode *));
+    if (!grown)
+        return false;
+
+    memset(grown + *size, 0, (new_size - *size) * sizeof(ConnectionNode *));
+    *table = grown;
+    *size = new_size;
+    return true;
+}
 /**
- * \brief Adds a new sensor connection to the linked list of active connections.
+ * \brief Atomically claims a reported sensor port, or reports that it is taken.
  *
- * Verifies IP rate limits before adding. Updates the global connection manager and ensures thread safety.
+ * Ports are unique across all shards, so the bitmap lives in the connection manager.
+ *
+ * \param port The port reported by the sensor.
+ *
+ * \return bool true if the port was free and is now claimed, false otherwise.
+ */
+static bool claim_port(int port)
+{
+    if (!is_valid_port(port))
+        return false;
+
+    ConnectionManager *manager = &system_manager.connection_manager;
+    unsigned char bit = (unsigned char)(1u << (port & 7));
+
+    pthread_mutex_lock(&manager->mutex);
+    bool free_port = !(manager->connected_ports[port >> 3] & bit);
+    if (free_port)
+        manager->connected_ports[port >> 3] |= bit;
+    pthread_mutex_unlock(&manager->mutex);
+
+    return free_port;
+}
+/**
+ * \brief Releases a reported sensor port claimed with claim_port().
  *
- * \param head Double pointer to the head of the connection list.
- * \param connection The sensor connection to add.
- * \param data The initial sensor data.
+ * \param port The port reported by the sensor.
  *
  * \return void
  */
-static void add_connection(ConnectionNode **head, SensorConnection connection, SensorData data)
+static void release_port(int port)
 {
-    // check IP limiter before connection
-    if (!ip_limiter_allow_connection(connection.ip_address))
-    {
-        printf("🚫 connection from IP %s rejeccted (over limit).\n", connection.ip_address);
+    if (!is_valid_port(port))
         return;
-    }
 
-    // add new node connection
-    ConnectionNode *new_node = create_node(connection, data);
-    if (!new_node)
-    {
-        handle_error("Failed add new connection");
-        return;
-    }
+    ConnectionManager *manager = &system_manager.connection_manager;
 
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
+    pthread_mutex_lock(&manager->mutex);
+    manager->connected_ports[port >> 3] &= (unsigned char)~(1u << (port & 7));
+    pthread_mutex_unlock(&manager->mutex);
+}
+/**
+ * \brief Records a node in the shard's fd slot table.
+ *
+ * Must be called with the shard mutex held.
+ *
+ * \param shard The owning shard.
+ * \param node The node to index by its socket fd.
+ *
+ * \return bool true on success, false if the table could not grow.
+ */
+static bool index_fd_locked(ConnectionShard *shard, ConnectionNode *node)
+{
+    int fd = node->connection.socket_fd;
 
-    new_node->next = *head;
-    *head = new_node;
-    system_manager.connection_manager.active_count++;
+    if (fd < 0 || !ensure_table_slot(&shard->fd_table, &shard->fd_table_size, fd))
+        return false;
 
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
+    shard->fd_table[fd] = node;
+    return true;
 }
 /**
- * \brief Removes a sensor connection from the list by sensor ID.
+ * \brief Clears the fd slot of a node, if the slot still refers to it.
  *
- * Releases associated resources including socket and memory,
- * and updates the active connection count.
+ * Must be called with the shard mutex held.
  *
- * \param head Double pointer to the head of the connection list.
- * \param sensor_id The ID of the sensor to remove.
+ * \param shard The owning shard.
+ * \param node The node being unindexed.
  *
  * \return void
  */
-static void remove_connection(ConnectionNode **head, int sensor_id)
+static void unindex_fd_locked(ConnectionShard *shard, ConnectionNode *node)
 {
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
+    int fd = node->connection.socket_fd;
 
-    ConnectionNode *current = *head, *prev = NULL;
-    while (current)
-    {
-        if (current->connection.sensor_id == sensor_id)
-        {
-            // remove ip from security
-            ip_limiter_remove_connection(current->connection.ip_address);
+    if (fd >= 0 && fd < shard->fd_table_size && shard->fd_table[fd] == node)
+        shard->fd_table[fd] = NULL;
+}
+/**
+ * \brief Links a node at the front of a doubly linked connection list.
+ *
+ * \param head Double pointer to the head of the list.
+ * \param node The node to link.
+ *
+ * \return void
+ */
+static void link_node(ConnectionNode **head, ConnectionNode *node)
+{
+    node->prev = NULL;
+    node->next = *head;
+    if (*head)
+        (*head)->prev = node;
+    *head = node;
+}
+/**
+ * \brief Unlinks a node from a doubly linked connection list in O(1).
+ *
+ * \param head Double pointer to the head of the list.
+ * \param node The node to unlink (not freed).
+ *
+ * \return void
+ */
+static void unlink_node(ConnectionNode **head, ConnectionNode *node)
+{
+    if (node->prev)
+        node->prev->next = node->next;
+    else if (*head == node)
+        *head = node->next;
 
-            if (prev)
-                prev->next = current->next;
-            else
-                *head = current->next;
+    if (node->next)
+        node->next->prev = node->prev;
 
-            // close socket
-            if (current->connection.socket_fd >= 0)
-            {
-                if (current->connection.secure_comm)
-                {
-                    destroy_secure_connection(current->connection.secure_comm);
-                    current->connection.secure_comm = NULL;
-                }
-                close(current->connection.socket_fd); // user add
-            }
+    node->next = NULL;
+    node->prev = NULL;
+}
+/**
+ * \brief Closes the secure channel and socket owned by a connection.
+ *
+ * The secure channel owns the socket, so the fd is only closed directly when
+ * no channel was created.
+ *
+ * \param conn The connection to close.
+ *
+ * \return void
+ */
+static void close_connection_io(SensorConnection *conn)
+{
+    conn->rx_length = 0; // the buffer itself stays with the pool slot
 
-            free(current);
-            system_manager.connection_manager.active_count--;
-            break;
-        }
-        prev = current;
-        current = current->next;
+    if (conn->secure_comm)
+    {
+        destroy_secure_connection(conn->secure_comm);
+        conn->secure_comm = NULL;
+    }
+    else if (conn->socket_fd >= 0)
+    {
+        close(conn->socket_fd);
     }
+    conn->socket_fd = -1;
+}
+/**
 
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
+\brief Returns the deadline a connection is currently held to.
+
+\details Pending connections must finish their handshake within HANDSHAKE_TIMEOUT_SECONDS of being
+accepted; established ones are dropped after CONNECTION_TIMEOUT_SECONDS without a frame.
+
+\param conn The connection.
+
+\return The epoch second at which the connection expires. */
+static time_t connection_deadline(const SensorConnection *conn)
+{
+    if (conn->state != CONN_STATE_ESTABLISHED)
+        return conn->accepted_time + HANDSHAKE_TIMEOUT_SECONDS;
+    return conn->last_active_time + CONNECTION_TIMEOUT_SECONDS;
 }
+/*-----------------------------------------------------------------------------------------*/
 
 /**
- * \brief Finds a connection node in the list by sensor ID.
+ * \brief Finds a connection node by sensor ID inside its shard.
+ *
+ * Must be called with the shard mutex held.
  *
- * \param head Pointer to the head of the connection list.
+ * \param shard The owning shard (see connection_shard_of()).
  * \param sensor_id The ID of the sensor to search for.
  *
  * \return ConnectionNode* Pointer to the found node, or NULL if not found.
  */
-static ConnectionNode *find_connection(ConnectionNode *head, int sensor_id)
+static ConnectionNode *find_connection_locked(ConnectionShard *shard, int sensor_id)
 {
-    // pthread_mutex_lock(&system_manager.connection_manager.mutex);
-    while (head)
-    {
-        if (head->connection.sensor_id == sensor_id)
-        {
-            // pthread_mutex_unlock(&system_manager.connection_manager.mutex);
-            return head;
-        }
+    return connection_pool_lookup(&shard->pool, sensor_id);
+}
+/**
+ * \brief Unlinks, unindexes and frees an established connection.
+ *
+ * Releases associated resources including secure channel, socket, IP limiter slot,
+ * reported port and pool slot, and updates the active connection count.
+ * Must be called with the shard mutex held.
+ *
+ * \param shard The owning shard.
+ * \param node The node to release.
+ *
+ * \return void
+ */
+static void release_connection_locked(ConnectionShard *shard, ConnectionNode *node)
+{
+    SensorConnection *conn = &node->connection;
+
+    // remove ip from security
+    ip_limiter_remove_connection(conn->ip_address);
+    release_port(conn->port);
+
+    if (shard->io) // NULL once the reactor has exited
+        shard->io->interface.remove(shard->io->impl, conn->socket_fd);
+    timer_wheel_cancel(&shard->timers, &node->timer);
+    unindex_fd_locked(shard, node);
+    unlink_node(&shard->head, node);
+    close_connection_io(conn);
+
+    // invalidates the sensor ID: a later sensor in the same slot gets a new generation
+    connection_pool_release(&shard->pool, node);
+    shard->active_count--;
+}
+/**
+ * \brief Removes a sensor connection by sensor ID.
+ *
+ * The owning shard is derived from the ID and the node is unlinked in O(1).
+ *
+ * \param sensor_id The ID of the sensor to remove.
+ *
+ * \return void
+ */
+static void remove_connection(int sensor_id)
+{
+    ConnectionShard *shard = connection_shard_of(sensor_id);
+    if (!shard)
+        return;
 
-        head = head->next;
-    }
-    // pthread_mutex_unlock(&system_manager.connection_manager.mutex);
-    return NULL;
+    pthread_mutex_lock(&shard->mutex);
+
+    ConnectionNode *node = find_connection_locked(shard, sensor_id);
+    if (node)
+        release_connection_locked(shard, node);
+
+    pthread_mutex_unlock(&shard->mutex);
+}
+
+/**
+ * \brief Finds a connection node by sensor ID.
+ *
+ * The ID is a pool handle, so the lookup is a slot access plus a generation check; the caller
+ * must hold the owning shard's mutex (connection_shard_of()) while using the result.
+ *
+ * \param sensor_id The ID of the sensor to search for.
+ *
+ * \return ConnectionNode* Pointer to the found node, or NULL if not found.
+ */
+static ConnectionNode *find_connection(int sensor_id)
+{
+    ConnectionShard *shard = connection_shard_of(sensor_id);
+    if (!shard)
+        return NULL;
+    return find_connection_locked(shard, sensor_id);
 }
 /**
  * \brief Updates the latest sensor data and timestamp for a specific sensor connection.
  *
- * \param head Pointer to the head of the connection list.
  * \param sensor_id The ID of the sensor whose data is being updated.
  * \param data The new sensor data to assign.
  *
  * \return void
  */
-static void update_data_connection(ConnectionNode *head, int sensor_id, SensorData data)
+static void update_data_connection(int sensor_id, SensorData data)
 {
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
+    ConnectionShard *shard = connection_shard_of(sensor_id);
+    if (!shard)
+        return;
 
-    ConnectionNode *node = find_connection(head, sensor_id);
+    pthread_mutex_lock(&shard->mutex);
+
+    ConnectionNode *node = find_connection_locked(shard, sensor_id);
     if (node)
     {
         node->latest_data = data;
         node->connection.last_active_time = time(NULL);
     }
 
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
+    pthread_mutex_unlock(&shard->mutex);
 }
 
 /*---------------Function print data connection-----------------------------------------*/
@@ -230,7 +410,7 @@ static void print_connection_info(const SensorConnection *conn)
 
     const char *status_str = connection_status_to_string(conn->status);
 
-    printf("| %4d | %17s | %5d | %10s | %19s | %19s |\n",
+    printf("| %7d | %17s | %5d | %10s | %19s | %19s |\n",
            conn->sensor_id,
            conn->ip_address,
            conn->port,
@@ -238,35 +418,61 @@ static void print_connection_info(const SensorConnection *conn)
            connected_time_str,
            last_active_time_str);
 }
+/**
+ * \brief Sums the active and pending connection counts over all shards.
+ *
+ * \param active Output: established connections.
+ * \param pending Output: sockets still handshaking.
+ *
+ * \return void
+ */
+static void count_connections(int *active, int *pending)
+{
+    ConnectionManager *manager = &system_manager.connection_manager;
+
+    *active = 0;
+    *pending = 0;
+    for (int i = 0; i < manager->shard_count; i++)
+    {
+        pthread_mutex_lock(&manager->shards[i].mutex);
+        *active += manager->shards[i].active_count;
+        *pending += manager->shards[i].pending_count;
+        pthread_mutex_unlock(&manager->shards[i].mutex);
+    }
+}
 
 /**
  * \brief Displays all currently active sensor connections in a formatted table.
  *
  * Includes connection ID, IP address, port, status, connected time, and last active time.
- * Ensures thread-safe access to the connection list.
- *
- * \param head Pointer to the head of the connection list.
+ * All reactor shards are merged into one table; each shard is locked while its rows print.
  *
  * \return void
  */
-void display_active_connections(ConnectionNode *head)
+void display_active_connections(void)
 {
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
+    ConnectionManager *manager = &system_manager.connection_manager;
+    int active = 0, pending = 0;
+    count_connections(&active, &pending);
 
-    printf("\n=== ACTIVE CONNECTIONS (%d) ===\n", system_manager.connection_manager.active_count);
-    printf("+------+-------------------+-------+------------+---------------------+---------------------+\n");
-    printf("|  ID  |      IP Address   | Port  |   Status   |    Connected Time   |   Last Active Time  |\n");
-    printf("+------+-------------------+-------+------------+---------------------+---------------------+\n");
+    printf("\n=== ACTIVE CONNECTIONS (%d) ===\n", active);
+    printf("+---------+-------------------+-------+------------+---------------------+---------------------+\n");
+    printf("|    ID   |      IP Address   | Port  |   Status   |    Connected Time   |   Last Active Time  |\n");
+    printf("+---------+-------------------+-------+------------+---------------------+---------------------+\n");
 
-    ConnectionNode *current = head;
-    while (current != NULL)
+    for (int i = 0; i < manager->shard_count; i++)
     {
-        print_connection_info(&current->connection);
-        current = current->next;
+        pthread_mutex_lock(&manager->shards[i].mutex);
+        ConnectionNode *current = manager->shards[i].head;
+        while (current != NULL)
+        {
+            print_connection_info(&current->connection);
+            current = current->next;
+        }
+        pthread_mutex_unlock(&manager->shards[i].mutex);
     }
 
-    printf("+------+-------------------+-------+------------+---------------------+---------------------+\n");
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
+    printf("+---------+-------------------+-------+------------+---------------------+---------------------+\n");
 }
 /*-----------------------------------------------------------------------------------------*/
 /**
@@ -294,129 +500,243 @@ static void display_resource_usage()
         perror("sysinfo");
     }
 }
+/**
+ * \brief Returns the I/O backend the reactors actually run.
+ *
+ * \return IoBackendType The first running reactor's backend, which differs from the configured one
+ * when io_uring was requested but is unavailable.
+ */
+static IoBackendType active_io_backend(void)
+{
+    ConnectionManager *manager = &system_manager.connection_manager;
+    IoBackendType type = system_manager.config.io_backend;
+
+    for (int i = 0; i < manager->shard_count; i++)
+    {
+        pthread_mutex_lock(&manager->shards[i].mutex);
+        bool running = manager->shards[i].io != NULL;
+        if (running)
+            type = manager->shards[i].io->type;
+        pthread_mutex_unlock(&manager->shards[i].mutex);
+        if (running)
+            break;
+    }
+    return type;
+}
+/**
+ * \brief Displays the accept statistics of all reactor shards.
+ *
+ * Shows how many connections each listener wakeup accepted, on average and at most.
+ *
+ * \return void
+ */
+static void display_accept_stats(void)
+{
+    ConnectionManager *manager = &system_manager.connection_manager;
+    unsigned long wakeups = 0, accepted = 0;
+    int max_batch = 0;
+
+    for (int i = 0; i < manager->shard_count; i++)
+    {
+        pthread_mutex_lock(&manager->shards[i].mutex);
+        wakeups += manager->shards[i].accept_wakeups;
+        accepted += manager->shards[i].accepted_total;
+        if (manager->shards[i].max_accepts_per_wakeup > max_batch)
+            max_batch = manager->shards[i].max_accepts_per_wakeup;
+        pthread_mutex_unlock(&manager->shards[i].mutex);
+    }
+
+    printf(" Accepts per wakeup      : %.2f avg, %d max (%lu accepted, backlog %d)\n",
+           wakeups ? (double)accepted / wakeups : 0.0, max_batch, accepted, system_manager.config.listen_backlog);
+}
 /**
  * \brief Displays overall system status including active connections and message statistics.
  *
  * Gathers and prints information from connection and storage managers, including RAM/CPU usage.
+ * Connection counts are aggregated over all reactor shards.
  *
  * \return void
  */
 void display_system_status()
 {
     int active_connections = 0;
-    int total_messages_conn = 0;
+    int pending_connections = 0;
     int total_messages_db = 0;
 
     // num sensor
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
-    active_connections = system_manager.connection_manager.active_count;
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
+    count_connections(&active_connections, &pending_connections);
 
     // num message receive
     pthread_mutex_lock(&system_manager.storage_manager.mutex);
     total_messages_db = system_manager.storage_manager.total_messages_received;
     pthread_mutex_unlock(&system_manager.storage_manager.mutex);
+    ReadingRing *queue = &system_manager.storage_manager.pending;
 
     printf("\n[System Status]\n");
     printf("Active connections       : %d\n", active_connections);
-    printf(" Total messages received : %d (live buffer: %d)\n", total_messages_db, total_messages_conn);
+    printf(" Handshakes in progress  : %d\n", pending_connections);
+    printf(" Reactor threads         : %d\n", system_manager.connection_manager.shard_count);
+    printf(" I/O backend             : %s\n", io_backend_name(active_io_backend()));
+    printf(" Total messages received : %d\n", total_messages_db);
+    printf(" Storage queue           : %zu pending, high water %zu/%zu, %lu dropped\n",
+           ring_size(queue), atomic_load(&queue->high_water_mark), ring_capacity(queue),
+           atomic_load(&queue->overflows));
+    data_display_stats();
+    storage_display_stats();
+    display_accept_stats();
     display_resource_usage();
 }
+/**
+ * \brief Initializes one reactor shard with empty lists and indexes.
+ *
+ * \param shard The shard to initialize.
+ * \param index Its position in the shard array.
+ *
+ * \return void
+ */
+static void init_shard(ConnectionShard *shard, int index)
+{
+    memset(shard, 0, sizeof(*shard));
+    shard->index = index;
+    shard->listen_fd = -1;
+    shard->timers.timer_fd = -1;
+    connection_pool_init(&shard->pool, index);
+    pthread_mutex_init(&shard->mutex, NULL);
+}
 /**
 
-\brief Initializes the connection manager by setting initial values for connection list,
-active count, running port, and mutex.
-
-This function initializes the connection manager with default values,
-including setting the head of the connection list to NULL,
+\brief Initializes the connection manager by creating the reactor shards,
+setting the running port, and binding the manager methods.
 
-active connection count to 0, and running port to 0. Additionally,
-it initializes a mutex for thread safety and binds the connection
+This function allocates `config.reactor_count` shards (each with its own mutex,
+connection lists and indexes), clears the port bitmap, initializes the manager
+mutex and binds the connection
 
 management methods (add, remove, find, update, display) to the respective functions.
 
 \return void */
 void init_connection_manager()
 {
-    system_manager.connection_manager.head = NULL;
-    system_manager.connection_manager.active_count = 0;
-    system_manager.connection_manager.running_port = 0;
-    pthread_mutex_init(&system_manager.connection_manager.mutex, NULL);
+    ConnectionManager *manager = &system_manager.connection_manager;
+
+    manager->shard_count = system_manager.config.reactor_count > 0 ? system_manager.config.reactor_count : 1;
+    manager->shards = calloc(manager->shard_count, sizeof(ConnectionShard));
+    if (!manager->shards)
+    {
+        handle_error("Failed to allocate reactor shards");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < manager->shard_count; i++)
+        init_shard(&manager->shards[i], i);
+
+    manager->running_port = 0;
+    memset(manager->connected_ports, 0, sizeof(manager->connected_ports));
+    pthread_mutex_init(&manager->mutex, NULL);
 
     // Bind methods (OOP-style)
-    system_manager.connection_manager.add = add_connection;
-    system_manager.connection_manager.remove = remove_connection;
-    system_manager.connection_manager.find = find_connection;
-    system_manager.connection_manager.update = update_data_connection;
-    system_manager.connection_manager.display = display_active_connections;
+    manager->remove = remove_connection;
+    manager->find = find_connection;
+    manager->update = update_data_connection;
+    manager->display = display_active_connections;
+}
+/**
+ * \brief Releases every node and index of one shard.
+ *
+ * \param shard The shard to clean up (its reactor thread must have exited).
+ *
+ * \return void
+ */
+static void cleanup_shard(ConnectionShard *shard)
+{
+    pthread_mutex_lock(&shard->mutex);
+
+    ConnectionNode *lists[] = {shard->head, shard->pending_head}; // pending: still handshaking
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++)
+    {
+        ConnectionNode *current = lists[i];
+        while (current != NULL)
+        {
+            ConnectionNode *tmp = current;
+            current = current->next;
+
+            // release secure_comm and socket
+            close_connection_io(&tmp->connection);
+        }
+    }
+
+    // nodes live in the pool: this frees them all at once
+    connection_pool_destroy(&shard->pool);
+    free(shard->fd_table);
+    shard->fd_table = NULL;
+    shard->head = NULL;
+    shard->pending_head = NULL;
+    shard->active_count = 0;
+    shard->pending_count = 0;
+
+    pthread_mutex_unlock(&shard->mutex);
+    pthread_mutex_destroy(&shard->mutex);
 }
 /**
 
 \brief Cleans up the resources used by the connection manager.
 
-This function releases the memory allocated for each connection node in the connection list and resets the connection manager's
+This function closes every connection (established and pending) and releases the connection pool and fd table of every shard, and resets the connection manager's
 
-internal states (head, active count, running port). The mutex is unlocked and destroyed to free associated resources.
+internal states (shards, running port). The mutex is destroyed to free associated resources.
 
 \return void */
 void cleanup_connection_manager()
 {
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
-
-    ConnectionNode *current = system_manager.connection_manager.head;
-    while (current != NULL)
-    {
-        ConnectionNode *tmp = current;
-        current = current->next;
-
-        // release secure_comm
-        if (tmp->connection.secure_comm != NULL)
-        {
-            // destroy
-            destroy_secure_connection(tmp->connection.secure_comm);
-            tmp->connection.secure_comm = NULL;
-        }
+    ConnectionManager *manager = &system_manager.connection_manager;
 
-        // close socket
-        if (tmp->connection.socket_fd >= 0)
-        {
-            close(tmp->connection.socket_fd);
-        }
+    for (int i = 0; i < manager->shard_count; i++)
+        cleanup_shard(&manager->shards[i]);
 
-        free(tmp);
-    }
+    free(manager->shards);
+    manager->shards = NULL;
+    manager->shard_count = 0;
+    manager->running_port = 0;
 
-    system_manager.connection_manager.head = NULL;
-    system_manager.connection_manager.active_count = 0;
-    system_manager.connection_manager.running_port = 0;
-
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
-    pthread_mutex_destroy(&system_manager.connection_manager.mutex);
+    pthread_mutex_destroy(&manager->mutex);
 }
 /*------------------------handle new connection-----------------*/
 /**
 
-\brief Creates a new sensor connection from the client information and assigns a sensor ID.
+\brief Creates the pending sensor connection for a freshly accepted socket.
+
+\param shard The reactor shard that accepted the socket.
+
+\param client_fd The accepted (non-blocking) socket.
 
-\param packet Pointer to the ClientInfoPacket with client info.
+\param client_ip The peer IP address reported by accept().
 
-\param sensor_id The unique sensor ID for the connection.
+\param secure_comm The secure channel whose handshake is still to be driven.
 
-\return A new SensorConnection initialized with provided data. */
-// static SensorConnection create_sensor_connection(ClientInfoPacket *packet, int sensor_id)
-static SensorConnection create_sensor_connection(ClientInfoPacket *packet, int sensor_id, SecureCommunication *secure_comm)
+\param rx_buffer The receive buffer of the connection's pool slot (CONNECTION_RX_BUFFER_SIZE bytes).
+
+\return A SensorConnection in the CONN_STATE_TLS_HANDSHAKING state. */
+static SensorConnection create_pending_connection(ConnectionShard *shard, int client_fd, const char *client_ip,
+                                                  SecureCommunication *secure_comm, uint8_t *rx_buffer)
 {
     SensorConnection conn = {
-        .socket_fd = packet->sock_fd,
-        .port = packet->port,
-        .sensor_id = sensor_id,
-        .is_active = true,
-        .status = CONN_STATUS_CONNECTED,
+        .socket_fd = client_fd,
+        .port = 0,
+        .sensor_id = -1,
+        .is_active = false,
+        .status = CONN_STATUS_DISCONNECTED,
         .connected_time = time(NULL),
         .last_active_time = time(NULL),
         .secure_comm = secure_comm,
+        .state = CONN_STATE_TLS_HANDSHAKING,
+        .accepted_time = time(NULL),
+        .want_write = false,
+        .rx_buffer = rx_buffer,
+        .rx_length = 0,
+        .has_sequence = false,
+        .shard_index = shard->index,
     };
-    strncpy(conn.ip_address, packet->ip_address, INET_ADDRSTRLEN);
+    strncpy(conn.ip_address, client_ip, INET_ADDRSTRLEN);
+    conn.ip_address[INET_ADDRSTRLEN - 1] = '\0';
     return conn;
 }
 /**
@@ -438,253 +758,525 @@ static SensorData create_initial_sensor_data(int sensor_id)
 
 /**
 
-\brief Updates the sensor temperature and stores the new data.
+\brief Applies a decoded measurement frame to a sensor connection.
+
+\details Every valid reading is timestamped (frame base + offset) and handed to storage; the newest one
+becomes the connection's latest data. Sequence gaps are logged, they mean frames were lost upstream.
+Must be called with the shard mutex held.
 
-\param sensor_id The sensor ID to update.
+\param node The established connection node that received the frame.
 
-\param temperature The new temperature value.
+\param frame The decoded frame.
 
 \return void */
-static void update_sensor_temperature(int sensor_id, float temperature)
+static void apply_measurement_frame(ConnectionNode *node, const MeasurementFrame *frame)
 {
-    time_t current_time = time(NULL);
+    SensorConnection *conn = &node->connection;
 
-    SensorData new_data = {
-        .timestamp = current_time,
-        .sensor_id = sensor_id,
-        .temperature = temperature,
-        .is_valid = true};
+    if (conn->has_sequence && frame->sequence != conn->next_sequence)
+    {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Sensor %d sequence gap: expected %u, got %u",
+                 conn->sensor_id, conn->next_sequence, frame->sequence);
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_WARNING, "Connection", msg);
+    }
+    conn->next_sequence = frame->sequence + 1;
+    conn->has_sequence = true;
 
-    // update to connection manager
-    ConnectionNode *node = system_manager.connection_manager.find(
-        system_manager.connection_manager.head, sensor_id);
-    if (node)
+    for (int i = 0; i < frame->count; i++)
     {
-        node->latest_data = new_data;
-        node->connection.last_active_time = current_time;
+        SensorData data = {
+            .timestamp = (int)(frame->base_timestamp + frame->readings[i].offset),
+            .sensor_id = conn->port, // readings outlive the connection handle, so they carry the stable port
+            .temperature = frame->readings[i].temperature,
+            .is_valid = isfinite(frame->readings[i].temperature)};
+
+        if (!data.is_valid)
+            continue;
+
+        // update to connection manager
+        node->latest_data = data;
+
+        // store and analyze data
+        storage_add_data(data);
+        data_add_reading(data);
     }
 
-    // store data
-    storage_add_data(new_data);
+    conn->last_active_time = time(NULL);
 }
 /**
- * \brief Receives all data from a secure communication channel.
+ * \brief Finds the connection (pending or established) that owns a socket fd.
  *
- * This function repeatedly calls the `recv` method of the communication interface
- * until the requested number of bytes are received or an error occurs.
+ * Constant-time lookup through the shard's fd slot table.
+ * Must be called with the shard mutex held.
  *
- * \param comm The secure communication interface.
- * \param buffer The buffer to store the received data.
- * \param size The number of bytes to receive.
+ * \param shard The reactor shard that registered the socket.
+ * \param client_fd The socket file descriptor to search for.
  *
- * \return 0 on success, -1 if an error occurs or the connection is closed.
+ * \return A pointer to the ConnectionNode, or NULL if not found.
  */
-static int recv_all(SecureCommunication *comm, void *buffer, size_t size)
+static ConnectionNode *find_connection_by_fd_locked(ConnectionShard *shard, int client_fd)
 {
-    size_t total_received = 0;
-    while (total_received < size)
-    {
-        int bytes_received = comm->interface.recv(comm->impl, (char *)buffer + total_received, size - total_received);
-        if (bytes_received <= 0)
-        {
-            return -1; // Error or connection closed
-        }
-        total_received += bytes_received;
-    }
-    return 0; // OK
+    if (client_fd < 0 || client_fd >= shard->fd_table_size)
+        return NULL;
+    return shard->fd_table[client_fd];
 }
+/**
+ * \brief Aborts a connection that failed or stalled during its handshake.
+ *
+ * Removes the socket from the I/O backend, releases its IP limiter slot, closes the secure
+ * channel and socket, and frees the node. Must be called with the shard mutex held.
+ *
+ * \param shard The reactor shard owning the socket.
+ * \param node The pending node to drop.
+ * \param reason Short reason used for the error message.
+ *
+ * \return void
+ */
+static void drop_pending_connection(ConnectionShard *shard, ConnectionNode *node, const char *reason)
+{
+    SensorConnection *conn = &node->connection;
+
+    char msg[256];
+    snprintf(msg, sizeof(msg), "Handshake with %s aborted: %s", conn->ip_address, reason);
+    handle_error(msg);
+
+    shard->io->interface.remove(shard->io->impl, conn->socket_fd);
+    ip_limiter_remove_connection(conn->ip_address);
+    timer_wheel_cancel(&shard->timers, &node->timer);
+    unindex_fd_locked(shard, node);
+    unlink_node(&shard->pending_head, node);
+    shard->pending_count--;
+    close_connection_io(conn);
+
+    connection_pool_release(&shard->pool, node);
+}
+/**
+ * \brief Re-arms the I/O backend for read or write readiness depending on what the TLS layer waits for.
+ *
+ * \param shard The reactor shard owning the socket.
+ * \param conn The pending connection.
+ * \param want_write true to wait for output, false to wait for input.
+ *
+ * \return bool true on success, false if the backend failed.
+ */
+static bool set_pending_interest(ConnectionShard *shard, SensorConnection *conn, bool want_write)
+{
+    if (conn->want_write == want_write)
+        return true;
 
+    conn->want_write = want_write;
+    return shard->io->interface.set_interest(shard->io->impl, conn->socket_fd, want_write);
+}
 /**
 
-\brief Handles a new client connection, validates and adds it to the connection manager.
+\brief Promotes a connection whose handshake completed into its shard's active list.
 
-\param epoll_fd The epoll file descriptor.
+\details The client info packet is validated, the reported port is claimed, a sensor ID is assigned
+and the node moves from the pending list to the active list in place (its receive buffer and any
+frames already in it are kept). The socket stays registered in the I/O backend.
+Must be called with the shard mutex held.
 
-\param server_fd The server socket file descriptor.
+\param shard The reactor shard owning the socket.
 
-\return void */
-void handle_new_connection(int epoll_fd, int server_fd)
+\param node The pending node.
+
+\param packet The ClientInfoPacket the sensor sent.
+
+\return true if the node is now established, false if it was dropped (and freed). */
+static bool establish_connection(ConnectionShard *shard, ConnectionNode *node, const ClientInfoPacket *packet)
 {
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    char client_ip[INET_ADDRSTRLEN];
+    SensorConnection *conn = &node->connection;
 
-    int client_fd = accept_client(server_fd, &client_addr, &client_len);
-    if (client_fd < 0)
-    {
-        handle_error("Client fd accept fail");
-        return;
-    }
+    warn_if_ip_mismatch(conn->ip_address, packet->ip_address);
 
-    SecureCommunication *comm = create_secure_connection(client_fd, SECURE_SSL_SERVER);
-    if (!comm)
+    if (!set_pending_interest(shard, conn, false))
     {
-        handle_error("Fail accept client with security");
-        close(client_fd);
-        return;
+        drop_pending_connection(shard, node, "I/O backend failed");
+        return false;
     }
 
-    ClientInfoPacket packet;
-    if (recv_all(comm, &packet, sizeof(packet)) < 0)
+    if (!claim_port(packet->port))
     {
-        handle_error("Failed to read client info securely");
-        destroy_secure_connection(comm);
-        close(client_fd);
-        return;
+        drop_pending_connection(shard, node, "port already connected");
+        return false;
     }
 
-    inet_ntop(AF_INET, &(client_addr.sin_addr), client_ip, INET_ADDRSTRLEN);
-    warn_if_ip_mismatch(client_ip, packet.ip_address);
+    // the slot was taken at accept time; publishing it makes the (slot, generation) handle live
+    int sensor_id = connection_pool_publish(&shard->pool, node);
 
-    if (is_port_already_connected(packet.port))
-    {
-        handle_error("Port already connected");
-        destroy_secure_connection(comm);
-        close(client_fd);
-        return;
-    }
+    conn->sensor_id = sensor_id;
+    conn->port = packet->port;
+    conn->is_active = true;
+    conn->status = CONN_STATUS_CONNECTED;
+    conn->state = CONN_STATE_ESTABLISHED;
+    conn->connected_time = time(NULL);
+    conn->last_active_time = conn->connected_time;
+    node->latest_data = create_initial_sensor_data(packet->port);
 
-    int sensor_id = system_manager.connection_manager.active_count;
-    SensorConnection conn = create_sensor_connection(&packet, sensor_id, comm);
-    SensorData init_data = create_initial_sensor_data(sensor_id);
+    printf("New connection ip:%s port: %d (ID: %d)\n", packet->ip_address, packet->port, sensor_id);
 
-    system_manager.connection_manager.add(&system_manager.connection_manager.head, conn, init_data);
+    unlink_node(&shard->pending_head, node);
+    shard->pending_count--;
+    link_node(&shard->head, node);
+    shard->active_count++;
+    timer_wheel_arm(&shard->timers, &node->timer, connection_deadline(conn));
 
     // Log new connection
     char msg[256];
     snprintf(msg, sizeof(msg), "A sensor node with %d has opened a new connection", sensor_id);
     system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Connection", msg);
-
-    if (!add_client_fd_to_epoll(epoll_fd, client_fd))
+    return true;
+}
+/**
+ * \brief Closes a connection after a disconnect or a protocol error.
+ *
+ * Pending connections are dropped, established ones are logged and released.
+ * Must be called with the shard mutex held.
+ *
+ * \param shard The reactor shard owning the socket.
+ * \param node The connection node (freed on return).
+ * \param level LOG_INFO for an orderly close, LOG_ERROR otherwise.
+ * \param reason Short reason appended to the log message, or NULL for an orderly close.
+ *
+ * \return void
+ */
+static void close_connection(ConnectionShard *shard, ConnectionNode *node, LogLevel level, const char *reason)
+{
+    if (node->connection.state != CONN_STATE_ESTABLISHED)
     {
-        system_manager.connection_manager.remove(&system_manager.connection_manager.head, sensor_id);
-        snprintf(msg, sizeof(msg), "A sensor node with %d has closed the connection", sensor_id);
-        system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Connection", msg);
-        destroy_secure_connection(comm);
-        close(client_fd);
+        drop_pending_connection(shard, node, reason ? reason : "peer closed the connection");
         return;
     }
 
-    printf("New connection ip:%s port: %d (ID: %d)\n", packet.ip_address, packet.port, sensor_id);
-}
+    char msg[256];
+    if (reason)
+        snprintf(msg, sizeof(msg), "Sensor %d error disconnect: %s", node->connection.sensor_id, reason);
+    else
+        snprintf(msg, sizeof(msg), "Sensor %d disconnected", node->connection.sensor_id);
+    system_manager.log_manager.log(&system_manager.log_manager, level, "Connection", msg);
 
+    release_connection_locked(shard, node);
+}
 /**
+ * \brief Parses everything complete in a connection's receive buffer.
+ *
+ * A connection awaiting its client info is established as soon as the whole ClientInfoPacket is
+ * buffered; every complete measurement frame after it is decoded and applied. A trailing partial
+ * frame is moved to the front of the buffer and completed by later reads.
+ * Must be called with the shard mutex held.
+ *
+ * \param shard The reactor shard owning the socket.
+ * \param node The connection node.
+ *
+ * \return bool true if the connection is still open, false if it was closed (and freed).
+ */
+static bool process_rx_buffer(ConnectionShard *shard, ConnectionNode *node)
+{
+    SensorConnection *conn = &node->connection;
+    size_t offset = 0;
 
-\brief Updates the sensor data for all active connections every 3 seconds.
+    if (conn->state == CONN_STATE_AWAIT_CLIENT_INFO)
+    {
+        if (conn->rx_length < sizeof(ClientInfoPacket))
+            return true;
+
+        ClientInfoPacket packet;
+        memcpy(&packet, conn->rx_buffer, sizeof(packet));
+        offset = sizeof(packet);
+        if (!establish_connection(shard, node, &packet))
+            return false;
+    }
 
-\details This function iterates through all active sensor connections, generates a random temperature value for each, and updates the sensor data.
+    while (offset < conn->rx_length)
+    {
+        MeasurementFrame frame;
+        int consumed = protocol_decode_frame(conn->rx_buffer + offset, conn->rx_length - offset, &frame);
+        if (consumed < 0)
+        {
+            close_connection(shard, node, LOG_ERROR, "malformed frame");
+            return false;
+        }
+        if (consumed == 0)
+            break;
 
-\param arg Pointer to any argument (not used in this case).
+        apply_measurement_frame(node, &frame);
+        offset += consumed;
+    }
 
-\return NULL */
-void *update_sensor_data_thread(void *arg)
+    if (offset > 0)
+    {
+        memmove(conn->rx_buffer, conn->rx_buffer + offset, conn->rx_length - offset);
+        conn->rx_length -= offset;
+    }
+    return true;
+}
+/**
+ * \brief Drains a connection's socket into its receive buffer until the socket would block.
+ *
+ * Required by the edge-triggered I/O backends: a readiness edge is only reported once, so every byte (including
+ * plaintext already buffered by TLS) must be consumed before returning. Each read is parsed right away,
+ * so one wakeup can deliver many frames. Must be called with the shard mutex held.
+ *
+ * \param shard The reactor shard owning the socket.
+ * \param node The connection node (awaiting client info or established).
+ *
+ * \return void
+ */
+static void receive_from_connection(ConnectionShard *shard, ConnectionNode *node)
 {
+    SensorConnection *conn = &node->connection;
+    SecureCommunication *comm = conn->secure_comm;
+
     while (1)
     {
-
-        ConnectionNode *current = system_manager.connection_manager.head;
-        while (current != NULL)
+        // parsing always leaves less than one frame behind, so there is room to read
+        int ret = comm->interface.recv(comm->impl, (char *)conn->rx_buffer + conn->rx_length,
+                                       CONNECTION_RX_BUFFER_SIZE - conn->rx_length);
+        if (ret == SECURE_IO_WANT_READ || ret == SECURE_IO_WANT_WRITE)
         {
-            if (current->connection.is_active)
-            {
-                // create random temperature (0-50°C)
-                float new_temp = (float)(rand() % 50);
-                update_sensor_temperature(current->connection.sensor_id, new_temp);
-            }
-            current = current->next;
+            if (conn->state != CONN_STATE_ESTABLISHED && !set_pending_interest(shard, conn, ret == SECURE_IO_WANT_WRITE))
+                drop_pending_connection(shard, node, "I/O backend failed");
+            return;
+        }
+        if (ret == 0)
+        {
+            close_connection(shard, node, LOG_INFO, NULL);
+            return;
+        }
+        if (ret < 0)
+        {
+            close_connection(shard, node, LOG_ERROR, "receive failed");
+            return;
         }
 
-        sleep(3); // update after 3 seconds
+        conn->rx_length += ret;
+        if (!process_rx_buffer(shard, node))
+            return;
     }
-    return NULL;
 }
-
 /**
 
-\brief Checks if a sensor connection has timed out.
+\brief Advances the handshake state machine of a pending connection as far as the socket allows.
 
-\details This function compares the current time with the last active time of the sensor connection.
-If the difference exceeds the timeout threshold, it returns true.
+\details TLS handshaking -> awaiting client info -> established. Whenever OpenSSL or the socket
+would block, the function re-arms the I/O backend for the needed direction and returns; the next
+readiness event resumes from the saved state. Must be called with the shard mutex held.
 
-\param conn Pointer to the SensorConnection to check.
+\param shard The reactor shard owning the socket.
 
-\param now The current time to compare against.
+\param node The pending connection node.
 
-\return true if the connection has timed out, false otherwise. */
-static bool is_connection_timed_out(SensorConnection *conn, time_t now)
+\return void */
+static void advance_handshake(ConnectionShard *shard, ConnectionNode *node)
 {
-    return conn->is_active && difftime(now, conn->last_active_time) > CONNECTION_TIMEOUT_SECONDS;
+    SensorConnection *conn = &node->connection;
+    SecureCommunication *comm = conn->secure_comm;
+
+    if (conn->state == CONN_STATE_TLS_HANDSHAKING)
+    {
+        int ret = comm->interface.handshake(comm->impl);
+        if (ret == SECURE_IO_WANT_READ || ret == SECURE_IO_WANT_WRITE)
+        {
+            if (!set_pending_interest(shard, conn, ret == SECURE_IO_WANT_WRITE))
+                drop_pending_connection(shard, node, "I/O backend failed");
+            return;
+        }
+        if (ret < 0)
+        {
+            drop_pending_connection(shard, node, "TLS handshake failed");
+            return;
+        }
+        conn->state = CONN_STATE_AWAIT_CLIENT_INFO;
+    }
+
+    // client info and the first frames usually arrive together: one drain establishes and ingests them
+    receive_from_connection(shard, node);
 }
 /**
 
-\brief Cleans up inactive sensor connections that have timed out.
+\brief Starts the non-blocking handshake of a freshly accepted client socket.
+
+\details The socket is checked against the IP limiter, registered in the shard's I/O backend and parked
+in its pending list. No TLS work blocks the reactor: the handshake and the ClientInfoPacket read
+are resumed by advance_handshake() on later events. Must be called with the shard mutex held.
 
-\details This function iterates through the list of connections and removes those that have timed out based on the CONNECTION_TIMEOUT_SECONDS threshold.
+\param shard The reactor shard that accepted the socket.
 
-The corresponding socket is closed, and resources are freed.
+\param client_fd The accepted socket (already non-blocking).
+
+\param client_ip The peer IP address.
 
 \return void */
-static void check_and_cleanup_inactive_connections()
+static void start_pending_connection(ConnectionShard *shard, int client_fd, const char *client_ip)
 {
-    time_t now = time(NULL);
-    ConnectionManager *manager = &system_manager.connection_manager;
+    // check IP limiter before spending any TLS work on the peer
+    if (!ip_limiter_allow_connection(client_ip))
+    {
+        printf("🚫 connection from IP %s rejeccted (over limit).\n", client_ip);
+        close(client_fd);
+        return;
+    }
 
-    pthread_mutex_lock(&manager->mutex);
+    SecureCommunication *comm = create_secure_connection_deferred(client_fd, SECURE_SSL_SERVER);
+    if (comm == NULL)
+    {
+        handle_error("Fail accept client with security");
+        ip_limiter_remove_connection(client_ip);
+        close(client_fd);
+        return;
+    }
+
+    ConnectionNode *node = connection_pool_acquire(&shard->pool);
+    if (node)
+    {
+        node->connection = create_pending_connection(shard, client_fd, client_ip, comm, node->connection.rx_buffer);
+        node->latest_data = create_initial_sensor_data(-1);
+    }
+    if (!node || !index_fd_locked(shard, node))
+    {
+        handle_error("Failed add new connection");
+        ip_limiter_remove_connection(client_ip);
+        destroy_secure_connection(comm);
+        if (node)
+            connection_pool_release(&shard->pool, node);
+        return;
+    }
 
-    ConnectionNode *prev = NULL;
-    ConnectionNode *current = manager->head;
+    link_node(&shard->pending_head, node);
+    shard->pending_count++;
+    timer_wheel_arm(&shard->timers, &node->timer, connection_deadline(&node->connection));
 
-    while (current)
+    if (!shard->io->interface.add(shard->io->impl, client_fd))
     {
-        ConnectionNode *next = current->next;
+        drop_pending_connection(shard, node, "I/O backend failed");
+        return;
+    }
 
-        if (is_connection_timed_out(&current->connection, now))
-        {
-            // terminate connection
-            int sensor_id = current->connection.sensor_id;
-            printf("[TIMEOUT] Sensor ID %d disconnected due to inactivity.\n", sensor_id);
-            close(current->connection.socket_fd);
-            ip_limiter_remove_connection(current->connection.ip_address);
-
-            if (prev)
-                prev->next = next;
-            else
-                manager->head = next;
-
-            free(current);
-            manager->active_count--;
-
-            char msg[256];
-            snprintf(msg, sizeof(msg), "A sensor node with %d has closed the connection", sensor_id);
-            system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Connection", msg);
-        }
-        else
+    // the ClientHello is often already queued; try right away
+    advance_handshake(shard, node);
+}
+/**
+ * \brief Records how many connections one listener wakeup accepted.
+ *
+ * Must be called with the shard mutex held.
+ *
+ * \param shard The reactor shard.
+ * \param accepted Connections accepted in this wakeup.
+ *
+ * \return void
+ */
+static void record_accept_batch(ConnectionShard *shard, int accepted)
+{
+    shard->accept_wakeups++;
+    shard->accepted_total += accepted;
+    if (accepted > shard->max_accepts_per_wakeup)
+        shard->max_accepts_per_wakeup = accepted;
+}
+/**
+ * \brief Starts the handshake of a socket the I/O backend already accepted (io_uring multishot accept).
+ *
+ * Must be called with the shard mutex held.
+ *
+ * \param shard The reactor shard.
+ * \param client_fd The accepted, non-blocking socket.
+ *
+ * \return void
+ */
+static void handle_accepted_connection(ConnectionShard *shard, int client_fd)
+{
+    struct sockaddr_in client_addr;
+    socklen_t client_len = sizeof(client_addr);
+    char client_ip[INET_ADDRSTRLEN];
+
+    if (getpeername(client_fd, (struct sockaddr *)&client_addr, &client_len) < 0)
+    {
+        close(client_fd); // peer already gone
+        return;
+    }
+    inet_ntop(AF_INET, &(client_addr.sin_addr), client_ip, INET_ADDRSTRLEN);
+    start_pending_connection(shard, client_fd, client_ip);
+}
+/**
+
+\brief Drains a shard's accept queue.
+
+\details The listener is non-blocking, so one wakeup accepts every queued connection (accept4 until
+EAGAIN) instead of one per readiness round-trip; a reconnect storm after a restart clears in a few
+wakeups. The number of accepts per wakeup is recorded in the shard's statistics.
+Must be called with the shard mutex held.
+
+\param shard The reactor shard whose listening socket became readable.
+
+\return void */
+void handle_new_connection(ConnectionShard *shard)
+{
+    int accepted = 0;
+
+    while (1)
+    {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        char client_ip[INET_ADDRSTRLEN];
+
+        int client_fd = accept_client(shard->listen_fd, &client_addr, &client_len);
+        if (client_fd < 0)
         {
-            prev = current;
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                handle_error("Client fd accept fail"); // e.g. EMFILE: retry on the next wakeup
+            break;
         }
 
-        current = next;
+        accepted++;
+        inet_ntop(AF_INET, &(client_addr.sin_addr), client_ip, INET_ADDRSTRLEN);
+        start_pending_connection(shard, client_fd, client_ip);
     }
 
-    pthread_mutex_unlock(&manager->mutex);
+    record_accept_batch(shard, accepted);
 }
 /**
 
-\brief Periodically checks and cleans up inactive connections every 5 seconds.
+\brief Timer wheel callback: expires or re-arms a connection.
 
-\details This function runs in a separate thread and calls check_and_cleanup_inactive_connections to handle the removal of timed-out connections every 5 seconds.
+\details Activity only refreshes `last_active_time` (re-arming is free); the real deadline is checked
+here, and a connection that was active since the timer was armed is simply re-armed at its new deadline.
+Runs in the reactor with the shard mutex held.
 
-\param arg Pointer to any argument (not used in this case).
+\param entry The connection node's timer.
 
-\return NULL */
-void *check_timeout_connection_thread(void *arg)
+\param now Current epoch second.
+
+\param context The owning ConnectionShard.
+
+\return void */
+static void on_connection_timer(TimerEntry *entry, time_t now, void *context)
 {
-    while (1)
+    ConnectionShard *shard = (ConnectionShard *)context;
+    ConnectionNode *node = TIMER_ENTRY_OWNER(entry, ConnectionNode, timer);
+    time_t deadline = connection_deadline(&node->connection);
+
+    if (now < deadline)
     {
-        check_and_cleanup_inactive_connections();
-        sleep(5); // check again after 5 seconds
+        timer_wheel_arm(&shard->timers, entry, deadline);
+        return;
     }
-    return NULL;
+
+    if (node->connection.state != CONN_STATE_ESTABLISHED)
+    {
+        drop_pending_connection(shard, node, "handshake timeout");
+        return;
+    }
+
+    // terminate connection
+    int sensor_id = node->connection.sensor_id;
+    printf("[TIMEOUT] Sensor ID %d disconnected due to inactivity.\n", sensor_id);
+    release_connection_locked(shard, node);
+
+    char msg[256];
+    snprintf(msg, sizeof(msg), "A sensor node with %d has closed the connection", sensor_id);
+    system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Connection", msg);
 }
 /**
  * \brief Sets the currently running port in the connection manager.
@@ -703,122 +1295,155 @@ static void set_running_port(int port)
     pthread_mutex_unlock(&system_manager.connection_manager.mutex);
 }
 /**
- * \brief Finds a connection node by its socket file descriptor.
+ * \brief Handles a readiness event on a client socket.
  *
- * This function traverses the linked list of connections in a thread-safe
- * way to locate the connection associated with the given file descriptor.
+ * Sockets still handshaking are resumed through the handshake state machine;
+ * established sockets have their measurement frames read. Must be called with the shard mutex held.
  *
- * \param client_fd The socket file descriptor to search for.
- *
- * \return A pointer to the found ConnectionNode, or NULL if not found.
- */
-static ConnectionNode *find_connection_by_fd(int client_fd)
-{
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
-    ConnectionNode *curr = system_manager.connection_manager.head;
-    while (curr && curr->connection.socket_fd != client_fd)
-        curr = curr->next;
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
-    return curr;
-}
-/**
- * \brief Finds a connection node by its socket file descriptor.
+ * \param shard The reactor shard owning the socket.
+ * \param client_fd The socket file descriptor that became ready.
  *
- * This function traverses the linked list of connections in a thread-safe
- * way to locate the connection associated with the given file descriptor.
- *
- * \param client_fd The socket file descriptor to search for.
- *
- * \return A pointer to the found ConnectionNode, or NULL if not found.
+ * \return void
  */
-static void handle_existing_connection(int epoll_fd, int client_fd)
+static void handle_existing_connection(ConnectionShard *shard, int client_fd)
 {
-    ConnectionNode *conn = find_connection_by_fd(client_fd);
+    ConnectionNode *conn = find_connection_by_fd_locked(shard, client_fd);
     if (!conn)
         return;
 
-    char buffer[1];
-    int result = recv(client_fd, buffer, sizeof(buffer), MSG_PEEK);
-
-    if (result == 0)
+    if (conn->connection.state != CONN_STATE_ESTABLISHED)
     {
-        char msg[256];
-        snprintf(msg, sizeof(msg), "Sensor %d disconnected", conn->connection.sensor_id);
-        system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Connection", msg);
-
-        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-        system_manager.connection_manager.remove(&system_manager.connection_manager.head, conn->connection.sensor_id);
+        advance_handshake(shard, conn);
+        return;
     }
-    else if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
-    {
-        perror("recv");
-        char msg[256];
-        snprintf(msg, sizeof(msg), "Sensor %d error disconnect: %s", conn->connection.sensor_id, strerror(errno));
-        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Connection", msg);
 
-        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-        system_manager.connection_manager.remove(&system_manager.connection_manager.head, conn->connection.sensor_id);
-    }
+    receive_from_connection(shard, conn);
 }
 /**
 
-\brief Manages the connection setup and handling for the server.
+\brief Event loop of one reactor shard.
 
-\details This function initializes the server socket, listens for incoming connections, and handles new connections using epoll. It also tracks the active port.
+\details Each reactor binds its own SO_REUSEPORT listener on the running port, so the kernel spreads
+incoming connections across reactors, and runs its own I/O backend (epoll or io_uring, see
+GatewayConfig::io_backend) over the sockets it accepted. Handshake and inactivity timeouts come from the
+shard's timer wheel, whose timerfd is watched by the same backend. Events are handled with the shard mutex
+held; other threads (UI, data) only contend on the shard they touch.
 
-\param arg Pointer to the port number on which to bind the server.
+\param arg Pointer to the ConnectionShard to run.
 
 \return NULL */
-void *connection_manager(void *arg)
+static void *reactor_main(void *arg)
 {
-    int port = *(int *)arg;
+    ConnectionShard *shard = (ConnectionShard *)arg;
+    int batch = system_manager.config.epoll_batch;
 
-    int server_fd = create_and_bind_socket(port);
-    if (server_fd < 0)
+    shard->listen_fd = create_and_bind_socket(system_manager.connection_manager.running_port);
+    if (shard->listen_fd < 0)
         return NULL;
 
-    set_running_port(port);
-
-    if (listen(server_fd, 10) < 0)
+    if (listen(shard->listen_fd, system_manager.config.listen_backlog) < 0)
     {
         perror("Error listen socket");
         exit(EXIT_FAILURE);
     }
 
-    int epoll_fd = setup_epoll(server_fd);
-    if (epoll_fd == -1)
+    IoBackend *io = create_io_backend(system_manager.config.io_backend, batch);
+    IoEvent *events = malloc(batch * sizeof(IoEvent));
+    if (!io || !events || !io->interface.watch_listener(io->impl, shard->listen_fd) ||
+        !timer_wheel_init(&shard->timers) || !io->interface.watch_timer(io->impl, shard->timers.timer_fd))
     {
-        close(server_fd);
+        handle_error("Failed to start reactor I/O");
+        free(events);
+        timer_wheel_destroy(&shard->timers);
+        destroy_io_backend(io);
+        close(shard->listen_fd);
+        shard->listen_fd = -1;
         return NULL;
     }
 
-    struct epoll_event events[10];
+    pthread_mutex_lock(&shard->mutex);
+    shard->io = io;
+    pthread_mutex_unlock(&shard->mutex);
+
     while (!stop_requested)
     {
-        int nfds = epoll_wait(epoll_fd, events, 10, -1);
-        if (nfds == -1)
-        {
-            if (errno == EINTR)
-                continue;
-            perror("epoll_wait");
+        // the timeout only bounds how long a stop request goes unnoticed
+        int count = io->interface.wait(io->impl, events, batch, 1000);
+        if (count < 0)
             break;
-        }
 
-        for (int i = 0; i < nfds; ++i)
+        int accepted = 0;
+        pthread_mutex_lock(&shard->mutex);
+        for (int i = 0; i < count; ++i)
         {
-            int fd = events[i].data.fd;
-            if (fd == server_fd)
+            switch (events[i].type)
             {
-                handle_new_connection(epoll_fd, server_fd);
-            }
-            else
-            {
-                handle_existing_connection(epoll_fd, fd);
+            case IO_EVENT_LISTENER:
+                handle_new_connection(shard);
+                break;
+            case IO_EVENT_ACCEPTED:
+                accepted++;
+                handle_accepted_connection(shard, events[i].fd);
+                break;
+            case IO_EVENT_TIMER:
+                timer_wheel_advance(&shard->timers, time(NULL), on_connection_timer, shard);
+                break;
+            case IO_EVENT_SOCKET:
+                handle_existing_connection(shard, events[i].fd);
+                break;
             }
         }
+        if (accepted > 0)
+            record_accept_batch(shard, accepted); // one completion batch counts as one wakeup
+        pthread_mutex_unlock(&shard->mutex);
     }
 
-    close(epoll_fd);
-    close(server_fd);
+    pthread_mutex_lock(&shard->mutex);
+    shard->io = NULL;
+    pthread_mutex_unlock(&shard->mutex);
+
+    free(events);
+    destroy_io_backend(io);
+    timer_wheel_destroy(&shard->timers);
+    close(shard->listen_fd);
+    shard->listen_fd = -1;
     return NULL;
-}
\ No newline at end of file
+}
+/**
+
+\brief Manages the connection setup and handling for the server.
+
+\details This function records the running port, starts one reactor thread per shard (each with its
+own SO_REUSEPORT listener and event loop) and waits for all of them to finish once a stop is requested.
+
+\param arg Pointer to the port number on which to bind the server.
+
+\return NULL */
+void *connection_manager(void *arg)
+{
+    int port = *(int *)arg;
+    ConnectionManager *manager = &system_manager.connection_manager;
+
+    set_running_port(port);
+
+    for (int i = 0; i < manager->shard_count; i++)
+    {
+        ConnectionShard *shard = &manager->shards[i];
+        if (pthread_create(&shard->thread, NULL, reactor_main, shard) != 0)
+        {
+            handle_error("Failed to create reactor thread");
+            continue;
+        }
+        shard->thread_started = true;
+    }
+
+    for (int i = 0; i < manager->shard_count; i++)
+    {
+        if (manager->shards[i].thread_started)
+        {
+            pthread_join(manager->shards[i].thread, NULL);
+            manager->shards[i].thread_started = false;
+        }
+    }
+    return NULL;
+}
@@ -10,6 +10,12 @@
 #include "../storage/storage.h"
 #include "../utils/utils.h"
 #include "../security/security.h"
+#include "../protocol/protocol.h"
+#include "../timer/timer.h"
+#include "../pool/pool.h"
+#include "../io/io.h"
+#include "../ring/ring.h"
+#include "../data/data.h"
 /******************************************************************************/
 /*                     EXPORTED TYPES and DEFINITIONS                         */
 /******************************************************************************/
@@ -20,8 +26,8 @@
 void *connection_manager(void *arg);
 void init_connection_manager();
 void cleanup_connection_manager();
-void *check_timeout_connection_thread(void *arg);
-void *update_sensor_data_thread(void *arg);
 void display_system_status();
+ConnectionShard *connection_shard_of(int sensor_id);
+bool connection_is_live(int sensor_id);
 
 #endif
@@ -1,171 +1,475 @@
 /******************************************************************************/
 /*                              INCLUDE FILES                                 */
 /******************************************************************************/
+#define _GNU_SOURCE // sem_clockwait()
 #include "data.h"
 /******************************************************************************/
 /*                            FUNCTIONS                              */
 /******************************************************************************/
 /**
- * \brief Calculates the running average of temperature readings.
+ * \brief Returns the current CLOCK_MONOTONIC second.
+ */
+static long monotonic_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)now.tv_sec;
+}
+/**
+ * \brief Returns the alert level of a sensor given its window average.
  *
- * \param history Pointer to the TemperatureHistory structure containing the temperature data.
+ * \param level The current level.
+ * \param profile The sensor's thresholds.
+ * \param avg The window average.
  *
- * \return float The calculated running average, or 0.0f if no data is available.
+ * \return AlertLevel The new level.
+ *
+ * \note A threshold is crossed to enter an alarm, but the alarm only ends once the average is back inside the
+ *       threshold by the hysteresis, so an average hovering around a threshold does not flap.
  */
-static float calculate_running_average(TemperatureHistory *history)
+static AlertLevel next_alert_level(AlertLevel level, const ThresholdProfile *profile, double avg)
 {
-    if (history->count == 0)
-        return 0.0f;
-
-    float sum = 0.0f;
-    for (int i = 0; i < history->count; i++)
-    {
-        sum += history->history[i];
-    }
-    return sum / history->count;
+    if (level == ALERT_HOT && avg >= profile->hot_threshold - profile->hysteresis)
+        return ALERT_HOT;
+    if (level == ALERT_COLD && avg <= profile->cold_threshold + profile->hysteresis)
+        return ALERT_COLD;
+    if (avg > profile->hot_threshold)
+        return ALERT_HOT;
+    if (avg < profile->cold_threshold)
+        return ALERT_COLD;
+    return ALERT_NORMAL;
 }
 /**
- * \brief Updates the temperature history for a given sensor.
+ * \brief Runs the alert state machine of a sensor and logs its transitions.
  *
- * \param history Pointer to the TemperatureHistory structure for the sensor.
- * \param new_temp The new temperature reading to be added to the history.
+ * \param state The sensor's state.
+ * \param profile The sensor's thresholds.
+ * \param avg The window average.
+ * \param now CLOCK_MONOTONIC second the reading is analyzed at.
  *
- * \note If the history size is reached, the new temperature will overwrite the oldest value.
+ * \note Only transitions are logged: entering an alarm (warning) and recovering from it (info). An alarm is
+ *       logged at most every `realert_seconds` of the profile: alarms entered sooner are counted as suppressed
+ *       (their recoveries too) and the next logged alarm reports how many were. A lasting alarm is repeated
+ *       once per interval. Must be called with the data manager mutex held.
  */
-static void update_temperature_history(TemperatureHistory *history, float new_temp)
+static void update_alert(SensorState *state, const ThresholdProfile *profile, double avg, long now)
 {
-    if (history->count < TEMPERATURE_HISTORY_SIZE)
+    static const char *alert_names[] = {"normal", "overheating", "overcooling"};
+    DataManager *manager = &system_manager.data_manager;
+    AlertState *alert = &state->alert;
+    AlertLevel level = next_alert_level(alert->level, profile, avg);
+    char msg[256];
+
+    bool entered = level != alert->level && level != ALERT_NORMAL;
+    if (level != alert->level)
     {
-        history->history[history->count++] = new_temp;
+        if (alert->level != ALERT_NORMAL && alert->reported)
+        {
+            snprintf(msg, sizeof(msg), "Sensor %d recovered from %s (avg temp: %.1f) after %ld s",
+                     state->sensor_id, alert_names[alert->level], avg, now - alert->entered_at);
+            system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Data", msg);
+            manager->alerts_logged++;
+        }
+        alert->level = level;
+        alert->reported = false;
+        alert->entered_at = now;
     }
-    else
+    if (level == ALERT_NORMAL)
+        return;
+
+    if (alert->last_alert != 0 && now - alert->last_alert < profile->realert_seconds)
     {
-        history->history[history->index] = new_temp;
-        history->index = (history->index + 1) % TEMPERATURE_HISTORY_SIZE;
+        if (entered)
+        {
+            alert->suppressed++;
+            manager->alerts_suppressed++;
+        }
+        return;
     }
+
+    float threshold = level == ALERT_HOT ? profile->hot_threshold : profile->cold_threshold;
+    if (!alert->reported && alert->suppressed > 0)
+        snprintf(msg, sizeof(msg), "Sensor %d entered %s (avg temp: %.1f, threshold %.1f, %lu alert(s) suppressed)",
+                 state->sensor_id, alert_names[level], avg, threshold, alert->suppressed);
+    else if (!alert->reported)
+        snprintf(msg, sizeof(msg), "Sensor %d entered %s (avg temp: %.1f, threshold %.1f)",
+                 state->sensor_id, alert_names[level], avg, threshold);
+    else
+        snprintf(msg, sizeof(msg), "Sensor %d still %s (avg temp: %.1f, threshold %.1f) after %ld s",
+                 state->sensor_id, alert_names[level], avg, threshold, now - alert->entered_at);
+    system_manager.log_manager.log(&system_manager.log_manager, LOG_WARNING, "Data", msg);
+    manager->alerts_logged++;
+    alert->reported = true;
+    alert->last_alert = now;
+    alert->suppressed = 0;
 }
 /**
  * \brief Checks the temperature status of a given sensor and logs warnings if thresholds are exceeded.
  *
- * \param sensor_id The ID of the sensor to check.
- * \param temperature The current temperature reading from the sensor.
+ * \param data The reading.
+ * \param thresholds The threshold profiles the batch is analyzed with.
+ * \param now CLOCK_MONOTONIC second the reading is analyzed at.
  *
  * \return void
  *
- * \note This function checks if the average temperature of a sensor exceeds the hot or cold thresholds
- * and logs a warning if necessary. It also ensures thread safety by using a mutex.
+ * \note This function adds the reading to the sensor's analysis window and runs the alert state machine on
+ * the window average, with the thresholds of the sensor's profile. The sensor's state is created on its first
+ * reading. Must be called with the data manager mutex held.
  */
-static void check_temperature_status(int sensor_id, float temperature)
+static void check_temperature_status(const SensorData *data, const ThresholdTable *thresholds, long now)
 {
-    pthread_mutex_lock(&system_manager.data_manager.mutex);
+    int sensor_id = data->sensor_id;
 
-    // check sensorID
-    if (sensor_id < 0 || sensor_id >= MAX_CONNECTIONS)
+    // check sensorID and get (or create) its state
+    SensorState *state = statemap_get(&system_manager.data_manager.sensors, sensor_id);
+    if (state == NULL)
     {
         char msg[256];
         snprintf(msg, sizeof(msg),
-                 "Received data with invalid sensor ID: %d",
+                 "Received data with invalid sensor ID (or no memory for its state): %d",
                  sensor_id);
         system_manager.log_manager.log(&system_manager.log_manager,
                                        LOG_ERROR, "Data", msg);
         return;
     }
 
-    // sensor histories create
-    if (system_manager.data_manager.sensor_histories == NULL)
+    state->last_seen = now;
+    if (!stats_add(&state->stats, &system_manager.config.stats_window, data->timestamp, data->temperature))
     {
-        system_manager.data_manager.sensor_histories =
-            calloc(MAX_CONNECTIONS, sizeof(TemperatureHistory));
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Data",
+                                       "Failed to grow a sensor analysis window");
+        return;
     }
-
-    TemperatureHistory *history = &system_manager.data_manager.sensor_histories[sensor_id];
-    update_temperature_history(history, temperature);
-    float avg = calculate_running_average(history);
+    StatsSnapshot snapshot;
+    stats_snapshot(&state->stats, &snapshot);
 
     // check threadhold
-    char msg[256];
-    if (avg > system_manager.data_manager.hot_threshold)
+    update_alert(state, thresholds_lookup(thresholds, sensor_id), snapshot.mean, now);
+}
+/**
+ * \brief Queues a reading for analysis by the data thread.
+ *
+ * \param data The reading, as stored.
+ *
+ * \note Called by the reactors next to storage_add_data(), with the same lock-free queue: it never blocks
+ *       connection handling. The data thread is woken when the queue becomes non-empty. If the queue is
+ *       full the reading is not analyzed and is counted; drops are logged sparingly.
+ */
+void data_add_reading(SensorData data)
+{
+    DataManager *manager = &system_manager.data_manager;
+    size_t occupancy = ring_push(&manager->readings, &data);
+
+    if (occupancy == 0)
     {
-        snprintf(msg, sizeof(msg),
-                 "Sensor %d reports overheating (avg temp: %.1f)",
-                 sensor_id, avg);
-        system_manager.log_manager.log(&system_manager.log_manager,
-                                       LOG_WARNING, "Data", msg);
+        unsigned long dropped = atomic_load_explicit(&manager->readings.overflows, memory_order_relaxed);
+        if ((dropped & (dropped - 1)) == 0) // 1st, 2nd, 4th, 8th... drop
+        {
+            char log_msg[128];
+            snprintf(log_msg, sizeof(log_msg), "Analysis queue full, %lu readings not analyzed so far", dropped);
+            system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Data", log_msg);
+        }
+        return;
+    }
+
+    if (occupancy == 1 && !atomic_exchange_explicit(&manager->wake_pending, true, memory_order_acq_rel))
+        sem_post(&manager->reading_ready);
+}
+/**
+ * \brief Analyzes a batch of readings in arrival order under one lock of the data manager mutex.
+ *
+ * \param batch The readings.
+ * \param count Number of readings in `batch`.
+ *
+ * \note The threshold profiles are read once per batch, without a lock: a reload only swaps the table pointer,
+ *       and the table loaded here is not freed before the data thread reports having moved past it.
+ */
+static void analyze_batch(const SensorData *batch, int count)
+{
+    long now = monotonic_seconds();
+    const ThresholdTable *thresholds =
+        atomic_load_explicit(&system_manager.data_manager.thresholds, memory_order_acquire);
+    pthread_mutex_lock(&system_manager.data_manager.mutex);
+    for (int i = 0; i < count; i++)
+        check_temperature_status(&batch[i], thresholds, now);
+    pthread_mutex_unlock(&system_manager.data_manager.mutex);
+
+    atomic_fetch_add_explicit(&system_manager.data_manager.analyzed, count, memory_order_relaxed);
+}
+/**
+ * \brief Frees the state of the sensors silent for `sensor_idle_seconds`, every DATA_EXPIRY_SWEEP_SECONDS.
+ *
+ * \note A sensor that comes back later starts with an empty window. The sweep is one pass over the map.
+ */
+static void expire_idle_sensors()
+{
+    DataManager *manager = &system_manager.data_manager;
+    long now = monotonic_seconds();
+    if (system_manager.config.sensor_idle_seconds <= 0 || now < manager->next_expiry_sweep)
+        return;
+    manager->next_expiry_sweep = now + DATA_EXPIRY_SWEEP_SECONDS;
+
+    pthread_mutex_lock(&manager->mutex);
+    size_t expired = statemap_expire(&manager->sensors, now - system_manager.config.sensor_idle_seconds);
+    manager->sensors_expired += expired;
+    pthread_mutex_unlock(&manager->mutex);
+}
+/**
+ * \brief Prints the analysis queue, the number of readings analyzed, the analysis window and the sensor states.
+ */
+void data_display_stats()
+{
+    DataManager *manager = &system_manager.data_manager;
+    ReadingRing *queue = &system_manager.data_manager.readings;
+    char window[32];
+    stats_window_describe(&system_manager.config.stats_window, window, sizeof(window));
+    printf(" Analysis queue          : %zu pending, high water %zu/%zu, %lu dropped, %lu analyzed\n",
+           ring_size(queue), atomic_load(&queue->high_water_mark), ring_capacity(queue),
+           atomic_load(&queue->overflows), atomic_load(&system_manager.data_manager.analyzed));
+    printf(" Analysis window         : %s, EWMA alpha %.2f\n", window, STATS_EWMA_ALPHA);
+
+    pthread_mutex_lock(&manager->mutex);
+    size_t tracked = manager->sensors.count, capacity = manager->sensors.capacity;
+    unsigned long expired = manager->sensors_expired;
+    unsigned long logged = manager->alerts_logged, suppressed = manager->alerts_suppressed;
+    pthread_mutex_unlock(&manager->mutex);
+    // the user interface thread is the only one that reloads, so the table it reads here stays alive
+    const ThresholdTable *thresholds = atomic_load_explicit(&manager->thresholds, memory_order_acquire);
+    char fallback[128];
+    thresholds_describe(&thresholds->fallback, fallback, sizeof(fallback));
+    const char *path = system_manager.config.thresholds_path;
+    printf(" Threshold profiles      : %zu profile(s), %s (generation %lu, from %s)\n", thresholds->count, fallback,
+           thresholds->generation, path ? path : "built-in defaults");
+    printf(" Threshold alerts        : %lu logged, %lu suppressed\n", logged, suppressed);
+    if (system_manager.config.sensor_idle_seconds > 0)
+        printf(" Sensor states           : %zu tracked (%zu slots), %lu expired after %d s idle\n", tracked, capacity,
+               expired, system_manager.config.sensor_idle_seconds);
+    else
+        printf(" Sensor states           : %zu tracked (%zu slots), never expired\n", tracked, capacity);
+}
+/**
+ * \brief Prints the window statistics of one sensor.
+ *
+ * \param sensor_id The sensor ID.
+ *
+ * \return bool true if the sensor has statistics, false otherwise.
+ */
+bool data_display_sensor(int sensor_id)
+{
+    DataManager *manager = &system_manager.data_manager;
+    StatsSnapshot snapshot;
+    unsigned long total = 0;
+    AlertState alert;
+    bool found = false;
+
+    pthread_mutex_lock(&manager->mutex);
+    SensorState *state = statemap_find(&manager->sensors, sensor_id);
+    if (state && state->stats.total > 0)
+    {
+        stats_snapshot(&state->stats, &snapshot);
+        total = state->stats.total;
+        alert = state->alert;
+        found = true;
     }
-    else if (avg < system_manager.data_manager.cold_threshold)
+    pthread_mutex_unlock(&manager->mutex);
+
+    if (!found)
     {
-        snprintf(msg, sizeof(msg),
-                 "Sensor %d reports overcooling (avg temp: %.1f)",
-                 sensor_id, avg);
-        system_manager.log_manager.log(&system_manager.log_manager,
-                                       LOG_WARNING, "Data", msg);
+        printf("No readings analyzed for sensor %d\n", sensor_id);
+        return false;
     }
 
-    pthread_mutex_unlock(&system_manager.data_manager.mutex);
+    char window[32];
+    stats_window_describe(&system_manager.config.stats_window, window, sizeof(window));
+    printf("\n[Sensor %d]\n", sensor_id);
+    printf(" Window                  : %s, %ld readings (%lu analyzed)\n", window, snapshot.count, total);
+    printf(" Average                 : %.2f (EWMA %.2f)\n", snapshot.mean, snapshot.ewma);
+    printf(" Min / max               : %.2f / %.2f\n", snapshot.min, snapshot.max);
+    printf(" Standard deviation      : %.2f\n", snapshot.stddev);
+    char profile[128];
+    thresholds_describe(thresholds_lookup(atomic_load_explicit(&manager->thresholds, memory_order_acquire), sensor_id),
+                        profile, sizeof(profile));
+    printf(" Thresholds              : %s\n", profile);
+    if (alert.level == ALERT_NORMAL)
+        printf(" Alert                   : normal\n");
+    else
+        printf(" Alert                   : %s for %ld s%s\n", alert.level == ALERT_HOT ? "overheating" : "overcooling",
+               monotonic_seconds() - alert.entered_at, alert.reported ? "" : " (suppressed)");
+    return true;
+}
+/**
+ * \brief Frees the replaced threshold tables the data thread can no longer be reading.
+ *
+ * \note Quiescent-state reclamation: between two batches the data thread holds no table and publishes the
+ *       generation of the current one, so every table older than that generation is unreachable.
+ */
+static void reclaim_thresholds()
+{
+    DataManager *manager = &system_manager.data_manager;
+    unsigned long quiescent = atomic_load_explicit(&manager->thresholds_quiescent, memory_order_acquire);
+
+    ThresholdTable **link = &manager->thresholds_retired;
+    while (*link)
+    {
+        ThresholdTable *table = *link;
+        if (table->generation < quiescent)
+        {
+            *link = table->next_retired;
+            thresholds_free(table);
+        }
+        else
+            link = &table->next_retired;
+    }
+}
+/**
+ * \brief Reloads the threshold profile file (`-t`) and swaps it in as a whole.
+ *
+ * \return bool true if the new profiles are in use, false if the file was rejected (the current ones stay).
+ *
+ * \note Called from the user interface thread only (the `reload` command and SIGHUP), so reloads never race
+ *       each other. The new table is published with one atomic pointer store: the data thread keeps analyzing
+ *       its current batch with the old table and picks up the new one at the next batch, without any lock.
+ *       The old table is retired and freed once the data thread reports a newer generation, at a later reload
+ *       or at shutdown.
+ */
+bool data_reload_thresholds()
+{
+    DataManager *manager = &system_manager.data_manager;
+    const char *path = system_manager.config.thresholds_path;
+    char msg[THRESHOLD_LINE_LENGTH + 128], error[THRESHOLD_LINE_LENGTH];
+
+    reclaim_thresholds();
+    ThresholdTable *table = thresholds_load(path, error, sizeof(error));
+    ThresholdTable *current = atomic_load_explicit(&manager->thresholds, memory_order_relaxed);
+    if (!table)
+    {
+        snprintf(msg, sizeof(msg), "Threshold reload failed, keeping generation %lu: %s", current->generation, error);
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Data", msg);
+        printf("%s\n", msg);
+        return false;
+    }
+
+    table->generation = current->generation + 1;
+    atomic_store_explicit(&manager->thresholds, table, memory_order_release);
+    current->next_retired = manager->thresholds_retired;
+    manager->thresholds_retired = current;
+
+    snprintf(msg, sizeof(msg), "Threshold profiles reloaded from %s: %zu profile(s) + default (generation %lu)",
+             path ? path : "built-in defaults", table->count, table->generation);
+    system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Data", msg);
+    printf("%s\n", msg);
+    return true;
 }
 /**
  * \brief Initializes the data manager for handling sensor data.
  *
  * \return void
  *
- * \note This function sets up the mutex and initializes the thresholds and sensor history storage.
+ * \note This function sets up the analysis queue and the mutex, loads the threshold profiles (`-t`, the
+ *       gateway does not start with an invalid file) and initializes the sensor state map.
  */
 void init_data_manager()
 {
+    int batch = system_manager.config.analysis_batch;
+    system_manager.data_manager.batch = malloc(batch * sizeof(SensorData));
+    if (system_manager.data_manager.batch == NULL ||
+        !ring_init(&system_manager.data_manager.readings, RING_BUFFER_SIZE) ||
+        !statemap_init(&system_manager.data_manager.sensors))
+    {
+        handle_error("Failed to allocate the analysis queue");
+        exit(EXIT_FAILURE);
+    }
+    sem_init(&system_manager.data_manager.reading_ready, 0, 0);
+    atomic_init(&system_manager.data_manager.wake_pending, false);
+    atomic_init(&system_manager.data_manager.analyzed, 0);
+
+    char error[THRESHOLD_LINE_LENGTH];
+    ThresholdTable *thresholds = thresholds_load(system_manager.config.thresholds_path, error, sizeof(error));
+    if (thresholds == NULL)
+    {
+        handle_error(error);
+        exit(EXIT_FAILURE);
+    }
+    thresholds->generation = 1;
+    atomic_init(&system_manager.data_manager.thresholds, thresholds);
+    atomic_init(&system_manager.data_manager.thresholds_quiescent, 1);
+    system_manager.data_manager.thresholds_retired = NULL;
+
     pthread_mutex_init(&system_manager.data_manager.mutex, NULL);
-    system_manager.data_manager.hot_threshold = 50.0f;
-    system_manager.data_manager.cold_threshold = 10.0f;
-    system_manager.data_manager.sensor_histories = NULL;
+    system_manager.data_manager.alerts_logged = 0;
+    system_manager.data_manager.alerts_suppressed = 0;
+    system_manager.data_manager.sensors_expired = 0;
+    system_manager.data_manager.next_expiry_sweep = 0;
 }
 /**
  * \brief Cleans up the data manager by freeing allocated resources.
  *
  * \return void
  *
- * \note This function frees the memory for sensor histories and destroys the mutex to release resources.
+ * \note This function frees the sensor states (and their windows), the threshold profiles and the analysis
+ *       queue, and destroys the mutex to release resources. The data thread must have stopped.
  */
 void cleanup_data_manager()
 {
     pthread_mutex_lock(&system_manager.data_manager.mutex);
-    if (system_manager.data_manager.sensor_histories != NULL)
-    {
-        free(system_manager.data_manager.sensor_histories);
-        system_manager.data_manager.sensor_histories = NULL;
-    }
+    statemap_destroy(&system_manager.data_manager.sensors);
     pthread_mutex_unlock(&system_manager.data_manager.mutex);
     pthread_mutex_destroy(&system_manager.data_manager.mutex);
+
+    ring_destroy(&system_manager.data_manager.readings);
+    free(system_manager.data_manager.batch);
+    system_manager.data_manager.batch = NULL;
+    sem_destroy(&system_manager.data_manager.reading_ready);
+
+    while (system_manager.data_manager.thresholds_retired)
+    {
+        ThresholdTable *table = system_manager.data_manager.thresholds_retired;
+        system_manager.data_manager.thresholds_retired = table->next_retired;
+        thresholds_free(table);
+    }
+    thresholds_free(atomic_load(&system_manager.data_manager.thresholds));
+    atomic_store(&system_manager.data_manager.thresholds, NULL);
 }
 /**
- * \brief The main function for the data manager thread that processes sensor data periodically.
+ * \brief The main function for the data manager thread: analyzes every reading exactly once.
  *
  * \param arg A pointer to any arguments passed to the thread (not used here).
  *
  * \return void* Always returns NULL.
  *
- * \note This function continuously processes the data from active connections, checks the temperature status
- * of each sensor, and logs any warnings if thresholds are exceeded. The function sleeps for 1 second
- * between each iteration to regulate the processing rate.
+ * \note The thread drains the analysis queue up to `analysis_batch` readings at a time and sleeps on the
+ * semaphore while it is empty, waking at least every DATA_IDLE_WAIT_MS to notice a stop request and to
+ * expire idle sensors. It never touches the connection lists, so reactors are not held up by the analysis.
+ * Between batches it reports the threshold table generation it has seen, so replaced tables can be freed.
  */
 void *data_manager(void *arg)
 {
+    (void)arg;
+    DataManager *manager = &system_manager.data_manager;
+
     while (!stop_requested)
     {
-        pthread_mutex_lock(&system_manager.connection_manager.mutex);
+        // clear before draining, so a push after the drain posts again instead of being missed
+        atomic_store_explicit(&manager->wake_pending, false, memory_order_seq_cst);
+        expire_idle_sensors();
+
+        // quiescent state: no threshold table is held here
+        const ThresholdTable *thresholds = atomic_load_explicit(&manager->thresholds, memory_order_acquire);
+        atomic_store_explicit(&manager->thresholds_quiescent, thresholds->generation, memory_order_release);
 
-        ConnectionNode *current = system_manager.connection_manager.head;
-        while (current != NULL)
+        int count = (int)ring_pop_batch(&manager->readings, manager->batch, system_manager.config.analysis_batch);
+        if (count > 0)
         {
-            if (current->connection.is_active && current->latest_data.is_valid)
-            {
-                check_temperature_status(
-                    current->connection.sensor_id,
-                    current->latest_data.temperature);
-            }
-            current = current->next;
+            analyze_batch(manager->batch, count);
+            continue;
         }
 
-        pthread_mutex_unlock(&system_manager.connection_manager.mutex);
-        sleep(1);
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += (long)DATA_IDLE_WAIT_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        sem_clockwait(&manager->reading_ready, CLOCK_MONOTONIC, &deadline);
     }
     return NULL;
 }
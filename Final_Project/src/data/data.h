@@ -4,6 +4,12 @@
 /*                              INCLUDE FILES                                 */
 /******************************************************************************/
 #include "../../include/shared_data.h"
+#include "../pool/pool.h"
+#include "../ring/ring.h"
+#include "../utils/utils.h"
+#include "../stats/stats.h"
+#include "../statemap/statemap.h"
+#include "../thresholds/thresholds.h"
 
 /******************************************************************************/
 /*                            FUNCTIONS PROTOTYPES                             */
@@ -11,4 +17,8 @@
 void *data_manager(void *arg);
 void init_data_manager();
 void cleanup_data_manager();
+void data_add_reading(SensorData data);
+void data_display_stats();
+bool data_display_sensor(int sensor_id);
+bool data_reload_thresholds();
 #endif
\ No newline at end of file
@@ -0,0 +1,268 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "gorilla.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Appends the `count` low bits of `value` (at most 32), most significant first.
+ */
+static void write_bits(GorillaEncoder *encoder, uint32_t value, int count)
+{
+    encoder->bits = (encoder->bits << count) | (value & (uint32_t)((1ULL << count) - 1));
+    encoder->bit_count += count;
+    while (encoder->bit_count >= 8)
+    {
+        encoder->bit_count -= 8;
+        encoder->out[encoder->size++] = (unsigned char)(encoder->bits >> encoder->bit_count);
+    }
+}
+/**
+ * \brief Reads the next `count` bits (at most 32).
+ *
+ * \return bool false if the data ends first.
+ */
+static bool read_bits(GorillaDecoder *decoder, int count, uint32_t *value)
+{
+    while (decoder->bit_count < count)
+    {
+        if (decoder->offset == decoder->size)
+            return false;
+        decoder->bits = (decoder->bits << 8) | decoder->in[decoder->offset++];
+        decoder->bit_count += 8;
+    }
+    decoder->bit_count -= count;
+    *value = (uint32_t)(decoder->bits >> decoder->bit_count) & (uint32_t)((1ULL << count) - 1);
+    return true;
+}
+/**
+ * \brief Reads a unary prefix of up to `max` one bits.
+ *
+ * \return int The number of one bits before the first zero (or `max`), -1 if the data ends first.
+ */
+static int read_prefix(GorillaDecoder *decoder, int max)
+{
+    int ones = 0;
+    uint32_t bit;
+    while (ones < max)
+    {
+        if (!read_bits(decoder, 1, &bit))
+            return -1;
+        if (bit == 0)
+            break;
+        ones++;
+    }
+    return ones;
+}
+/**
+ * \brief Starts encoding readings into a buffer.
+ *
+ * \param encoder The encoder.
+ * \param out Output buffer, at least GORILLA_MAX_BYTES() of the readings to encode.
+ * \param capacity Size of `out`.
+ */
+void gorilla_encoder_init(GorillaEncoder *encoder, unsigned char *out, size_t capacity)
+{
+    encoder->out = out;
+    encoder->capacity = capacity;
+    encoder->size = 0;
+    encoder->bits = 0;
+    encoder->bit_count = 0;
+    encoder->count = 0;
+    encoder->timestamp = 0;
+    encoder->delta = 0;
+    encoder->value = 0;
+    encoder->leading = 0;
+    encoder->trailing = 0;
+}
+/**
+ * \brief Encodes the next reading.
+ *
+ * \param encoder The encoder.
+ * \param timestamp Epoch seconds; any order works, increasing timestamps at a regular rate encode best.
+ * \param value The value.
+ *
+ * \return bool true on success, false if the buffer is full (nothing is written then).
+ *
+ * \note The first reading is stored raw (32 + 32 bits). After it, the timestamp is stored as the change of
+ *       the delta to the previous one: `0` when it is unchanged (regular sampling), then 7, 9 or 12 bit
+ *       buckets, 32 bits otherwise. The value is XORed with the previous one: `0` when it is unchanged,
+ *       `10` and the meaningful bits when they fit the previous leading/trailing zero window, else `11`,
+ *       5 bits of leading zeros, 5 bits of length and the meaningful bits.
+ */
+bool gorilla_encode(GorillaEncoder *encoder, int timestamp, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    if (encoder->size + 11 > encoder->capacity) // worst case of one reading and the padding, see GORILLA_MAX_BYTES
+        return false;
+
+    if (encoder->count++ == 0)
+    {
+        write_bits(encoder, (uint32_t)timestamp, 32);
+        write_bits(encoder, bits, 32);
+        encoder->timestamp = (uint32_t)timestamp;
+        encoder->value = bits;
+        encoder->leading = -1; // no window yet
+        return true;
+    }
+
+    uint32_t delta = (uint32_t)timestamp - encoder->timestamp;
+    int32_t dod = (int32_t)(delta - encoder->delta);
+    if (dod == 0)
+        write_bits(encoder, 0x0, 1);
+    else if (dod >= -63 && dod <= 64)
+    {
+        write_bits(encoder, 0x2, 2);
+        write_bits(encoder, (uint32_t)(dod + 63), 7);
+    }
+    else if (dod >= -255 && dod <= 256)
+    {
+        write_bits(encoder, 0x6, 3);
+        write_bits(encoder, (uint32_t)(dod + 255), 9);
+    }
+    else if (dod >= -2047 && dod <= 2048)
+    {
+        write_bits(encoder, 0xE, 4);
+        write_bits(encoder, (uint32_t)(dod + 2047), 12);
+    }
+    else
+    {
+        write_bits(encoder, 0xF, 4);
+        write_bits(encoder, (uint32_t)dod, 32);
+    }
+    encoder->timestamp = (uint32_t)timestamp;
+    encoder->delta = delta;
+
+    uint32_t xor = bits ^ encoder->value;
+    encoder->value = bits;
+    if (xor == 0)
+    {
+        write_bits(encoder, 0x0, 1);
+        return true;
+    }
+
+    int leading = __builtin_clz(xor);
+    int trailing = __builtin_ctz(xor);
+    if (encoder->leading >= 0 && leading >= encoder->leading && trailing >= encoder->trailing)
+    {
+        write_bits(encoder, 0x2, 2);
+        write_bits(encoder, xor >> encoder->trailing, 32 - encoder->leading - encoder->trailing);
+        return true;
+    }
+
+    int length = 32 - leading - trailing;
+    write_bits(encoder, 0x3, 2);
+    write_bits(encoder, (uint32_t)leading, 5);
+    write_bits(encoder, (uint32_t)(length - 1), 5);
+    write_bits(encoder, xor >> trailing, length);
+    encoder->leading = leading;
+    encoder->trailing = trailing;
+    return true;
+}
+/**
+ * \brief Ends the encoding, padding the last byte with zeros.
+ *
+ * \param encoder The encoder.
+ *
+ * \return size_t Size of the encoded data in bytes.
+ */
+size_t gorilla_finish(GorillaEncoder *encoder)
+{
+    if (encoder->bit_count > 0)
+    {
+        encoder->out[encoder->size++] = (unsigned char)(encoder->bits << (8 - encoder->bit_count));
+        encoder->bit_count = 0;
+    }
+    return encoder->size;
+}
+/**
+ * \brief Starts decoding data written by the encoder.
+ *
+ * \param decoder The decoder.
+ * \param data The encoded data.
+ * \param size Size of `data` in bytes.
+ * \param count Number of readings encoded in `data`.
+ */
+void gorilla_decoder_init(GorillaDecoder *decoder, const void *data, size_t size, int count)
+{
+    decoder->in = data;
+    decoder->size = size;
+    decoder->offset = 0;
+    decoder->bits = 0;
+    decoder->bit_count = 0;
+    decoder->count = 0;
+    decoder->remaining = count;
+    decoder->timestamp = 0;
+    decoder->delta = 0;
+    decoder->value = 0;
+    decoder->leading = 0;
+    decoder->trailing = 0;
+}
+/**
+ * \brief Decodes the next reading.
+ *
+ * \param decoder The decoder.
+ * \param timestamp Output: epoch seconds.
+ * \param value Output: the value.
+ *
+ * \return bool true if a reading was decoded, false at the end or if the data is truncated.
+ */
+bool gorilla_decode(GorillaDecoder *decoder, int *timestamp, float *value)
+{
+    uint32_t bits;
+
+    if (decoder->remaining <= 0)
+        return false;
+
+    if (decoder->count == 0)
+    {
+        if (!read_bits(decoder, 32, &decoder->timestamp) || !read_bits(decoder, 32, &decoder->value))
+            return false;
+    }
+    else
+    {
+        static const int dod_bits[] = {0, 7, 9, 12, 32};
+        static const int32_t dod_bias[] = {0, 63, 255, 2047, 0};
+        int bucket = read_prefix(decoder, 4);
+        if (bucket < 0)
+            return false;
+        int32_t dod = 0;
+        if (bucket > 0)
+        {
+            if (!read_bits(decoder, dod_bits[bucket], &bits))
+                return false;
+            dod = (int32_t)bits - dod_bias[bucket];
+        }
+        decoder->delta += (uint32_t)dod;
+        decoder->timestamp += decoder->delta;
+
+        int control = read_prefix(decoder, 2);
+        if (control < 0)
+            return false;
+        if (control == 2)
+        {
+            uint32_t leading, length;
+            if (!read_bits(decoder, 5, &leading) || !read_bits(decoder, 5, &length))
+                return false;
+            decoder->leading = (int)leading;
+            decoder->trailing = 32 - (int)leading - (int)length - 1;
+            if (decoder->trailing < 0)
+                return false;
+        }
+        if (control > 0)
+        {
+            if (!read_bits(decoder, 32 - decoder->leading - decoder->trailing, &bits))
+                return false;
+            decoder->value ^= bits << decoder->trailing;
+        }
+    }
+
+    decoder->count++;
+    decoder->remaining--;
+    *timestamp = (int)decoder->timestamp;
+    memcpy(value, &decoder->value, sizeof(*value));
+    return true;
+}
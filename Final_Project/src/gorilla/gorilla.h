@@ -0,0 +1,16 @@
+#ifndef GORILLA_H
+#define GORILLA_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+void gorilla_encoder_init(GorillaEncoder *encoder, unsigned char *out, size_t capacity);
+bool gorilla_encode(GorillaEncoder *encoder, int timestamp, float value);
+size_t gorilla_finish(GorillaEncoder *encoder);
+
+void gorilla_decoder_init(GorillaDecoder *decoder, const void *data, size_t size, int count);
+bool gorilla_decode(GorillaDecoder *decoder, int *timestamp, float *value);
+#endif // GORILLA_H
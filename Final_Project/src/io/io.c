@@ -0,0 +1,721 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "io.h"
+
+#ifdef HAVE_LIBURING
+#include <poll.h>
+#include <liburing.h>
+#endif
+/******************************************************************************/
+/*                              PRIVATE DATA                                  */
+/******************************************************************************/
+// epoll backend: readiness only, the handlers do their own recv/SSL_read
+typedef struct
+{
+    int epoll_fd;
+    int listen_fd;
+    int timer_fd;
+    struct epoll_event *events;
+    int max_events;
+} EpollBackend;
+
+#ifdef HAVE_LIBURING
+// what a completion belongs to, stored in the top byte of its user_data
+typedef enum
+{
+    URING_OP_ACCEPT = 1,
+    URING_OP_TIMER,
+    URING_OP_SOCKET,
+    URING_OP_CANCEL
+} UringOp;
+
+// poll registration of one client socket, indexed by fd
+typedef struct
+{
+    uint32_t generation; // bumped whenever the poll is replaced or removed; stale completions are dropped
+    bool active;
+    bool want_write;
+} UringRegistration;
+
+// io_uring backend: multishot accept and multishot poll, all submitted together with the wait
+typedef struct
+{
+    struct io_uring ring;
+    int listen_fd;
+    int timer_fd;
+
+    pthread_mutex_t lock; // guards registrations and removals: remove() may run on a non-reactor thread
+    UringRegistration *registrations;
+    int registration_size;
+    uint64_t *removals; // user_data of polls to cancel, submitted by the reactor on its next wait
+    int removal_count;
+    int removal_capacity;
+} UringBackend;
+
+#define URING_DATA(op, generation, fd) \
+    (((uint64_t)(op) << 56) | ((uint64_t)((generation) & 0xFFFFFF) << 32) | (uint32_t)(fd))
+#define URING_DATA_OP(data) ((int)((data) >> 56))
+#define URING_DATA_GENERATION(data) ((uint32_t)(((data) >> 32) & 0xFFFFFF))
+#define URING_DATA_FD(data) ((int)((data) & 0xFFFFFFFF))
+#endif
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/*------------------------------------ epoll backend ------------------------------------*/
+/**
+ * \brief Watches the listening socket (level-triggered; the reactor drains it with accept).
+ *
+ * \param self Pointer to the EpollBackend instance.
+ * \param listen_fd The listening socket.
+ *
+ * \return bool true on success, false if epoll_ctl failed.
+ */
+static bool epoll_watch_listener(void *self, int listen_fd)
+{
+    EpollBackend *backend = (EpollBackend *)self;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = listen_fd;
+
+    if (epoll_ctl(backend->epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) == -1)
+    {
+        perror("epoll_ctl: listen_fd");
+        return false;
+    }
+    backend->listen_fd = listen_fd;
+    return true;
+}
+/**
+ * \brief Watches the timer wheel's timerfd.
+ *
+ * \param self Pointer to the EpollBackend instance.
+ * \param timer_fd The timerfd.
+ *
+ * \return bool true on success, false if epoll_ctl failed.
+ */
+static bool epoll_watch_timer(void *self, int timer_fd)
+{
+    EpollBackend *backend = (EpollBackend *)self;
+    if (!add_client_fd_to_epoll(backend->epoll_fd, timer_fd))
+        return false;
+    backend->timer_fd = timer_fd;
+    return true;
+}
+/**
+ * \brief Starts watching a client socket for input (edge-triggered).
+ *
+ * \param self Pointer to the EpollBackend instance.
+ * \param fd The client socket.
+ *
+ * \return bool true on success, false if epoll_ctl failed.
+ */
+static bool epoll_add(void *self, int fd)
+{
+    return add_client_fd_to_epoll(((EpollBackend *)self)->epoll_fd, fd);
+}
+/**
+ * \brief Switches a client socket between waiting for input and waiting for output.
+ *
+ * \param self Pointer to the EpollBackend instance.
+ * \param fd The client socket.
+ * \param want_write true to wait for EPOLLOUT, false to wait for EPOLLIN.
+ *
+ * \return bool true on success, false if epoll_ctl failed.
+ */
+static bool epoll_set_interest(void *self, int fd, bool want_write)
+{
+    return modify_client_fd_in_epoll(((EpollBackend *)self)->epoll_fd, fd,
+                                     (want_write ? EPOLLOUT : EPOLLIN) | EPOLLET);
+}
+/**
+ * \brief Stops watching a client socket.
+ *
+ * \param self Pointer to the EpollBackend instance.
+ * \param fd The client socket.
+ *
+ * \return void
+ */
+static void epoll_remove(void *self, int fd)
+{
+    epoll_ctl(((EpollBackend *)self)->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+/**
+ * \brief Waits for readiness and translates it into backend-neutral events.
+ *
+ * \param self Pointer to the EpollBackend instance.
+ * \param events Output array.
+ * \param max_events Capacity of `events`.
+ * \param timeout_ms Maximum time to block.
+ *
+ * \return int Number of events (0 on timeout or EINTR), -1 on failure.
+ */
+static int epoll_backend_wait(void *self, IoEvent *events, int max_events, int timeout_ms)
+{
+    EpollBackend *backend = (EpollBackend *)self;
+    if (max_events > backend->max_events)
+        max_events = backend->max_events;
+
+    int nfds = epoll_wait(backend->epoll_fd, backend->events, max_events, timeout_ms);
+    if (nfds == -1)
+    {
+        if (errno == EINTR)
+            return 0;
+        perror("epoll_wait");
+        return -1;
+    }
+
+    for (int i = 0; i < nfds; i++)
+    {
+        int fd = backend->events[i].data.fd;
+        events[i].fd = fd;
+        if (fd == backend->listen_fd)
+            events[i].type = IO_EVENT_LISTENER;
+        else if (fd == backend->timer_fd)
+            events[i].type = IO_EVENT_TIMER;
+        else
+            events[i].type = IO_EVENT_SOCKET;
+    }
+    return nfds;
+}
+/**
+ * \brief Closes the epoll instance and frees the backend.
+ *
+ * \param self Pointer to the EpollBackend instance.
+ *
+ * \return void
+ */
+static void epoll_destroy(void *self)
+{
+    EpollBackend *backend = (EpollBackend *)self;
+    close(backend->epoll_fd);
+    free(backend->events);
+    free(backend);
+}
+/**
+ * \brief Creates the epoll backend.
+ *
+ * \param backend The IoBackend to fill in.
+ * \param max_events Largest number of events returned by one wait.
+ *
+ * \return bool true on success, false on failure.
+ */
+static bool epoll_backend_create(IoBackend *backend, int max_events)
+{
+    EpollBackend *impl = calloc(1, sizeof(EpollBackend));
+    if (!impl)
+        return false;
+
+    impl->events = malloc(max_events * sizeof(struct epoll_event));
+    impl->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (!impl->events || impl->epoll_fd == -1)
+    {
+        perror("epoll_create1");
+        if (impl->epoll_fd != -1)
+            close(impl->epoll_fd);
+        free(impl->events);
+        free(impl);
+        return false;
+    }
+    impl->max_events = max_events;
+    impl->listen_fd = -1;
+    impl->timer_fd = -1;
+
+    backend->interface.watch_listener = epoll_watch_listener;
+    backend->interface.watch_timer = epoll_watch_timer;
+    backend->interface.add = epoll_add;
+    backend->interface.set_interest = epoll_set_interest;
+    backend->interface.remove = epoll_remove;
+    backend->interface.wait = epoll_backend_wait;
+    backend->interface.destroy = epoll_destroy;
+    backend->impl = impl;
+    backend->type = IO_BACKEND_EPOLL;
+    return true;
+}
+
+#ifdef HAVE_LIBURING
+/*------------------------------------ io_uring backend ------------------------------------*/
+/**
+ * \brief Returns a free submission queue entry, flushing the queue to the kernel if it is full.
+ *
+ * Only called on the reactor thread.
+ *
+ * \param backend The UringBackend instance.
+ *
+ * \return struct io_uring_sqe* The entry, or NULL if the queue is still full.
+ */
+static struct io_uring_sqe *uring_get_sqe(UringBackend *backend)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&backend->ring);
+    if (!sqe)
+    {
+        io_uring_submit(&backend->ring);
+        sqe = io_uring_get_sqe(&backend->ring);
+    }
+    return sqe;
+}
+/**
+ * \brief Returns the registration slot of a socket, growing the table as needed.
+ *
+ * Must be called with the backend lock held.
+ *
+ * \param backend The UringBackend instance.
+ * \param fd The socket.
+ *
+ * \return UringRegistration* The slot, or NULL if memory allocation fails.
+ */
+static UringRegistration *uring_registration(UringBackend *backend, int fd)
+{
+    if (fd < 0)
+        return NULL;
+
+    if (fd >= backend->registration_size)
+    {
+        int size = backend->registration_size > 0 ? backend->registration_size : CONNECTION_TABLE_INITIAL_SIZE;
+        while (size <= fd)
+            size *= 2;
+
+        UringRegistration *grown = realloc(backend->registrations, size * sizeof(UringRegistration));
+        if (!grown)
+            return NULL;
+        memset(grown + backend->registration_size, 0,
+               (size - backend->registration_size) * sizeof(UringRegistration));
+        backend->registrations = grown;
+        backend->registration_size = size;
+    }
+    return &backend->registrations[fd];
+}
+/**
+ * \brief Queues the poll of a socket for cancellation.
+ *
+ * Must be called with the backend lock held.
+ *
+ * \param backend The UringBackend instance.
+ * \param user_data The user_data the poll was submitted with.
+ *
+ * \return bool true on success, false if memory allocation fails.
+ */
+static bool uring_queue_removal(UringBackend *backend, uint64_t user_data)
+{
+    if (backend->removal_count == backend->removal_capacity)
+    {
+        int capacity = backend->removal_capacity > 0 ? backend->removal_capacity * 2 : 64;
+        uint64_t *grown = realloc(backend->removals, capacity * sizeof(uint64_t));
+        if (!grown)
+            return false;
+        backend->removals = grown;
+        backend->removal_capacity = capacity;
+    }
+    backend->removals[backend->removal_count++] = user_data;
+    return true;
+}
+/**
+ * \brief Submits (with the next wait) a poll for the current interest of a socket.
+ *
+ * Input is watched with a multishot poll, which keeps completing on every wakeup; output is a
+ * one-shot poll because the TLS layer switches back to input as soon as its write went through.
+ *
+ * \param backend The UringBackend instance.
+ * \param fd The socket.
+ * \param generation Current registration generation.
+ * \param want_write true to wait for POLLOUT, false for POLLIN.
+ *
+ * \return bool true on success, false if the submission queue is full.
+ */
+static bool uring_arm_poll(UringBackend *backend, int fd, uint32_t generation, bool want_write)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(backend);
+    if (!sqe)
+        return false;
+
+    if (want_write)
+        io_uring_prep_poll_add(sqe, fd, POLLOUT);
+    else
+        io_uring_prep_poll_multishot(sqe, fd, POLLIN);
+    io_uring_sqe_set_data64(sqe, URING_DATA(URING_OP_SOCKET, generation, fd));
+    return true;
+}
+/**
+ * \brief Submits (with the next wait) a multishot accept on the listener.
+ *
+ * \param backend The UringBackend instance.
+ *
+ * \return bool true on success, false if the submission queue is full.
+ */
+static bool uring_arm_accept(UringBackend *backend)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(backend);
+    if (!sqe)
+        return false;
+
+    // accepted sockets come back non-blocking, like accept4() on the epoll path
+    io_uring_prep_multishot_accept(sqe, backend->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    io_uring_sqe_set_data64(sqe, URING_DATA(URING_OP_ACCEPT, 0, backend->listen_fd));
+    return true;
+}
+/**
+ * \brief Submits (with the next wait) a multishot poll on the timerfd.
+ *
+ * \param backend The UringBackend instance.
+ *
+ * \return bool true on success, false if the submission queue is full.
+ */
+static bool uring_arm_timer(UringBackend *backend)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(backend);
+    if (!sqe)
+        return false;
+
+    io_uring_prep_poll_multishot(sqe, backend->timer_fd, POLLIN);
+    io_uring_sqe_set_data64(sqe, URING_DATA(URING_OP_TIMER, 0, backend->timer_fd));
+    return true;
+}
+/**
+ * \brief Accepts connections on the listener with a multishot accept.
+ *
+ * \param self Pointer to the UringBackend instance.
+ * \param listen_fd The listening socket.
+ *
+ * \return bool true on success, false on failure.
+ */
+static bool uring_watch_listener(void *self, int listen_fd)
+{
+    UringBackend *backend = (UringBackend *)self;
+    backend->listen_fd = listen_fd;
+    return uring_arm_accept(backend);
+}
+/**
+ * \brief Watches the timer wheel's timerfd.
+ *
+ * \param self Pointer to the UringBackend instance.
+ * \param timer_fd The timerfd.
+ *
+ * \return bool true on success, false on failure.
+ */
+static bool uring_watch_timer(void *self, int timer_fd)
+{
+    UringBackend *backend = (UringBackend *)self;
+    backend->timer_fd = timer_fd;
+    return uring_arm_timer(backend);
+}
+/**
+ * \brief Starts watching a client socket for input.
+ *
+ * \param self Pointer to the UringBackend instance.
+ * \param fd The client socket.
+ *
+ * \return bool true on success, false on failure.
+ */
+static bool uring_add(void *self, int fd)
+{
+    UringBackend *backend = (UringBackend *)self;
+
+    pthread_mutex_lock(&backend->lock);
+    UringRegistration *reg = uring_registration(backend, fd);
+    if (!reg)
+    {
+        pthread_mutex_unlock(&backend->lock);
+        return false;
+    }
+    reg->generation++;
+    reg->active = true;
+    reg->want_write = false;
+    uint32_t generation = reg->generation;
+    pthread_mutex_unlock(&backend->lock);
+
+    return uring_arm_poll(backend, fd, generation, false);
+}
+/**
+ * \brief Replaces the poll of a client socket with one for the requested direction.
+ *
+ * \param self Pointer to the UringBackend instance.
+ * \param fd The client socket.
+ * \param want_write true to wait for POLLOUT, false for POLLIN.
+ *
+ * \return bool true on success, false on failure.
+ */
+static bool uring_set_interest(void *self, int fd, bool want_write)
+{
+    UringBackend *backend = (UringBackend *)self;
+
+    pthread_mutex_lock(&backend->lock);
+    UringRegistration *reg = uring_registration(backend, fd);
+    if (!reg || !reg->active || !uring_queue_removal(backend, URING_DATA(URING_OP_SOCKET, reg->generation, fd)))
+    {
+        pthread_mutex_unlock(&backend->lock);
+        return false;
+    }
+    reg->generation++;
+    reg->want_write = want_write;
+    uint32_t generation = reg->generation;
+    pthread_mutex_unlock(&backend->lock);
+
+    return uring_arm_poll(backend, fd, generation, want_write);
+}
+/**
+ * \brief Stops watching a client socket.
+ *
+ * The cancellation is queued and submitted by the reactor on its next wait, so this may be called
+ * from any thread. Completions already in flight for the socket are recognised as stale by their generation.
+ *
+ * \param self Pointer to the UringBackend instance.
+ * \param fd The client socket.
+ *
+ * \return void
+ */
+static void uring_remove(void *self, int fd)
+{
+    UringBackend *backend = (UringBackend *)self;
+
+    pthread_mutex_lock(&backend->lock);
+    UringRegistration *reg = uring_registration(backend, fd);
+    if (reg && reg->active)
+    {
+        // the ring holds a reference to the socket until its poll is cancelled
+        if (!uring_queue_removal(backend, URING_DATA(URING_OP_SOCKET, reg->generation, fd)))
+            handle_error("Failed to queue io_uring poll removal");
+        reg->generation++;
+        reg->active = false;
+    }
+    pthread_mutex_unlock(&backend->lock);
+}
+/**
+ * \brief Turns one completion into an event and re-arms multishot requests the kernel ended.
+ *
+ * Must be called with the backend lock held.
+ *
+ * \param backend The UringBackend instance.
+ * \param cqe The completion.
+ * \param event Output event.
+ *
+ * \return bool true if `event` was filled in, false if the completion carries no event.
+ */
+static bool uring_translate(UringBackend *backend, struct io_uring_cqe *cqe, IoEvent *event)
+{
+    uint64_t data = io_uring_cqe_get_data64(cqe);
+    int fd = URING_DATA_FD(data);
+    bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+    switch (URING_DATA_OP(data))
+    {
+    case URING_OP_ACCEPT:
+        if (!more && !uring_arm_accept(backend))
+            handle_error("Failed to re-arm io_uring accept");
+        if (cqe->res < 0)
+            return false; // e.g. EMFILE: the accept is re-armed and retried
+        event->type = IO_EVENT_ACCEPTED;
+        event->fd = cqe->res;
+        return true;
+
+    case URING_OP_TIMER:
+        if (!more && !uring_arm_timer(backend))
+            handle_error("Failed to re-arm io_uring timer poll");
+        event->type = IO_EVENT_TIMER;
+        event->fd = fd;
+        return true;
+
+    case URING_OP_SOCKET:
+    {
+        UringRegistration *reg = fd < backend->registration_size ? &backend->registrations[fd] : NULL;
+        if (!reg || !reg->active || reg->generation != URING_DATA_GENERATION(data))
+            return false; // poll of a closed socket or a replaced interest
+
+        if (cqe->res == -ECANCELED)
+            return false;
+        // the kernel may end a multishot poll (e.g. on overflow); input stays watched
+        if (!more && !reg->want_write && !uring_arm_poll(backend, fd, reg->generation, false))
+            handle_error("Failed to re-arm io_uring poll");
+        event->type = IO_EVENT_SOCKET;
+        event->fd = fd;
+        return true;
+    }
+
+    default: // URING_OP_CANCEL
+        return false;
+    }
+}
+/**
+ * \brief Submits everything queued since the last call and waits for completions, in one syscall.
+ *
+ * \param self Pointer to the UringBackend instance.
+ * \param events Output array.
+ * \param max_events Capacity of `events`.
+ * \param timeout_ms Maximum time to block.
+ *
+ * \return int Number of events (0 on timeout or EINTR), -1 on failure.
+ */
+static int uring_backend_wait(void *self, IoEvent *events, int max_events, int timeout_ms)
+{
+    UringBackend *backend = (UringBackend *)self;
+
+    pthread_mutex_lock(&backend->lock);
+    int flushed = 0;
+    while (flushed < backend->removal_count)
+    {
+        struct io_uring_sqe *sqe = uring_get_sqe(backend);
+        if (!sqe)
+            break; // the rest goes out with the next wait
+        io_uring_prep_poll_remove(sqe, backend->removals[flushed++]);
+        io_uring_sqe_set_data64(sqe, URING_DATA(URING_OP_CANCEL, 0, 0));
+    }
+    backend->removal_count -= flushed;
+    memmove(backend->removals, backend->removals + flushed, backend->removal_count * sizeof(uint64_t));
+    pthread_mutex_unlock(&backend->lock);
+
+    struct __kernel_timespec timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (long long)(timeout_ms % 1000) * 1000000,
+    };
+    struct io_uring_cqe *cqe;
+    int ret = io_uring_submit_and_wait_timeout(&backend->ring, &cqe, 1, &timeout, NULL);
+    if (ret < 0 && ret != -ETIME && ret != -EINTR)
+    {
+        fprintf(stderr, "io_uring_submit_and_wait_timeout: %s\n", strerror(-ret));
+        return -1;
+    }
+
+    struct io_uring_cqe *cqes[max_events];
+    unsigned count = io_uring_peek_batch_cqe(&backend->ring, cqes, max_events);
+
+    int produced = 0;
+    pthread_mutex_lock(&backend->lock);
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (uring_translate(backend, cqes[i], &events[produced]))
+            produced++;
+    }
+    pthread_mutex_unlock(&backend->lock);
+    io_uring_cq_advance(&backend->ring, count);
+
+    return produced;
+}
+/**
+ * \brief Tears down the ring and frees the backend.
+ *
+ * \param self Pointer to the UringBackend instance.
+ *
+ * \return void
+ */
+static void uring_destroy(void *self)
+{
+    UringBackend *backend = (UringBackend *)self;
+    io_uring_queue_exit(&backend->ring);
+    pthread_mutex_destroy(&backend->lock);
+    free(backend->registrations);
+    free(backend->removals);
+    free(backend);
+}
+/**
+ * \brief Creates the io_uring backend.
+ *
+ * \param backend The IoBackend to fill in.
+ *
+ * \return bool true on success, false if the kernel refuses the ring.
+ */
+static bool uring_backend_create(IoBackend *backend)
+{
+    UringBackend *impl = calloc(1, sizeof(UringBackend));
+    if (!impl)
+        return false;
+
+    int ret = io_uring_queue_init(IO_URING_ENTRIES, &impl->ring, 0);
+    if (ret < 0)
+    {
+        fprintf(stderr, "io_uring_queue_init: %s\n", strerror(-ret));
+        free(impl);
+        return false;
+    }
+    pthread_mutex_init(&impl->lock, NULL);
+    impl->listen_fd = -1;
+    impl->timer_fd = -1;
+
+    backend->interface.watch_listener = uring_watch_listener;
+    backend->interface.watch_timer = uring_watch_timer;
+    backend->interface.add = uring_add;
+    backend->interface.set_interest = uring_set_interest;
+    backend->interface.remove = uring_remove;
+    backend->interface.wait = uring_backend_wait;
+    backend->interface.destroy = uring_destroy;
+    backend->impl = impl;
+    backend->type = IO_BACKEND_URING;
+    return true;
+}
+#endif // HAVE_LIBURING
+/*------------------------------------ common ------------------------------------*/
+/**
+ * \brief Creates the I/O backend of one reactor.
+ *
+ * \param type Requested backend. If io_uring is not compiled in or the kernel refuses the ring,
+ * the epoll backend is used instead and a warning is printed.
+ * \param max_events Largest number of events returned by one wait.
+ *
+ * \return IoBackend* The backend, or NULL on failure.
+ */
+IoBackend *create_io_backend(IoBackendType type, int max_events)
+{
+    IoBackend *backend = calloc(1, sizeof(IoBackend));
+    if (!backend)
+        return NULL;
+
+    if (type == IO_BACKEND_URING)
+    {
+#ifdef HAVE_LIBURING
+        if (uring_backend_create(backend))
+            return backend;
+        printf("Warning: io_uring unavailable, falling back to epoll\n");
+#else
+        printf("Warning: built without io_uring support (make USE_URING=1), falling back to epoll\n");
+#endif
+    }
+
+    if (!epoll_backend_create(backend, max_events))
+    {
+        free(backend);
+        return NULL;
+    }
+    return backend;
+}
+/**
+ * \brief Destroys an I/O backend. Sockets it watched are not closed.
+ *
+ * \param backend The backend (may be NULL).
+ *
+ * \return void
+ */
+void destroy_io_backend(IoBackend *backend)
+{
+    if (!backend)
+        return;
+    backend->interface.destroy(backend->impl);
+    free(backend);
+}
+/**
+ * \brief Returns the command line name of a backend.
+ *
+ * \param type The backend type.
+ *
+ * \return const char* "epoll" or "uring".
+ */
+const char *io_backend_name(IoBackendType type)
+{
+    return type == IO_BACKEND_URING ? "uring" : "epoll";
+}
+/**
+ * \brief Parses a backend name given on the command line.
+ *
+ * \param name "epoll" or "uring".
+ * \param type Output: the backend type.
+ *
+ * \return bool true if the name is known, false otherwise.
+ */
+bool io_backend_from_name(const char *name, IoBackendType *type)
+{
+    if (strcmp(name, "epoll") == 0)
+        *type = IO_BACKEND_EPOLL;
+    else if (strcmp(name, "uring") == 0)
+        *type = IO_BACKEND_URING;
+    else
+        return false;
+    return true;
+}
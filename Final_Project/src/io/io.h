@@ -0,0 +1,15 @@
+#ifndef IO_H
+#define IO_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+#include "../socket/socket.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+IoBackend *create_io_backend(IoBackendType type, int max_events);
+void destroy_io_backend(IoBackend *backend);
+const char *io_backend_name(IoBackendType type);
+bool io_backend_from_name(const char *name, IoBackendType *type);
+#endif // IO_H
@@ -0,0 +1,712 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+#include "../utils/utils.h"
+#include "../socket/socket.h"
+#include "../security/security.h"
+#include "../protocol/protocol.h"
+/******************************************************************************/
+/*                              EXPORTED DATA                                 */
+/******************************************************************************/
+// required by the shared socket/security modules
+SystemManager system_manager;
+volatile sig_atomic_t stop_requested = 0;
+/******************************************************************************/
+/*                     PRIVATE TYPES and DEFINITIONS                          */
+/******************************************************************************/
+#define LOADGEN_MAX_SLEEP_SECONDS 0.1    // a worker re-checks its sensors at least this often
+#define LOADGEN_DB_POLL_SECONDS 0.005    // commit watermark polling period
+#define LOADGEN_DRAIN_GRACE_SECONDS 5.0  // time allowed for the last frames to reach the database
+#define LOADGEN_RECONNECT_DELAY_SECONDS 1.0
+#define LOADGEN_REPORTED_PORT_BASE 1024 // sensor i reports port base + i, which the gateway requires to be unique
+
+typedef struct
+{
+    char host[INET_ADDRSTRLEN];
+    int port;
+    int sensors;
+    int threads;
+    double rate;          // readings per second per sensor
+    int readings_per_frame;
+    double duration;      // seconds
+    double churn;         // mean connection lifetime in seconds, 0 = never reconnect
+    const char *db_path;  // gateway database, enables end-to-end latency
+    int source_addresses; // distinct 127.x.y.z source addresses (loopback targets only)
+} LoadgenConfig;
+
+typedef struct
+{
+    SecureCommunication *comm;
+    int index;
+    uint32_t sequence;
+    double next_send;
+    double disconnect_at;
+    double reconnect_at;
+    bool connected;
+} SimulatedSensor;
+
+// growable array of latency samples in milliseconds
+typedef struct
+{
+    double *values;
+    size_t count;
+    size_t capacity;
+} SampleSet;
+
+typedef struct
+{
+    int index;
+    pthread_t thread;
+    unsigned int seed;
+    SampleSet connect_latency;
+} LoadgenWorker;
+
+// a sent frame waiting for its rows to show up in the database
+typedef struct
+{
+    unsigned long readings_total; // readings sent up to and including this frame
+    double sent_at;
+} PendingFrame;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    PendingFrame *frames; // ring buffer, grows when full
+    size_t head;
+    size_t count;
+    size_t capacity;
+    unsigned long readings_sent;
+    unsigned long committed;
+    SampleSet latency;
+} CommitTracker;
+/******************************************************************************/
+/*                              PRIVATE DATA                                  */
+/******************************************************************************/
+static LoadgenConfig config;
+static CommitTracker tracker;
+
+static atomic_ulong frames_sent;
+static atomic_ulong connects_ok;
+static atomic_ulong connects_failed;
+static atomic_ulong churned;
+static atomic_ulong send_failures;
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns a monotonic timestamp in seconds.
+ *
+ * \return double Seconds since an arbitrary point.
+ */
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/**
+ * \brief Sleeps for a fractional number of seconds.
+ *
+ * \param seconds Time to sleep (ignored if not positive).
+ *
+ * \return void
+ */
+static void sleep_seconds(double seconds)
+{
+    if (seconds <= 0)
+        return;
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+}
+/**
+ * \brief Appends a sample to a set.
+ *
+ * \param set The sample set.
+ * \param value The sample in milliseconds.
+ *
+ * \return void
+ */
+static void sample_add(SampleSet *set, double value)
+{
+    if (set->count == set->capacity)
+    {
+        size_t capacity = set->capacity ? set->capacity * 2 : 1024;
+        double *grown = realloc(set->values, capacity * sizeof(double));
+        if (!grown)
+            return;
+        set->values = grown;
+        set->capacity = capacity;
+    }
+    set->values[set->count++] = value;
+}
+/**
+ * \brief qsort comparator for doubles.
+ */
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+/**
+ * \brief Prints the percentiles of a sample set (sorts it in place).
+ *
+ * \param label Line label.
+ * \param set The sample set.
+ *
+ * \return void
+ */
+static void print_percentiles(const char *label, SampleSet *set)
+{
+    if (set->count == 0)
+    {
+        printf(" %-22s: no samples\n", label);
+        return;
+    }
+    qsort(set->values, set->count, sizeof(double), compare_doubles);
+#define PERCENTILE(p) set->values[(size_t)((p) * (set->count - 1))]
+    printf(" %-22s: p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms (%zu samples)\n", label,
+           PERCENTILE(0.50), PERCENTILE(0.95), PERCENTILE(0.99), set->values[set->count - 1], set->count);
+#undef PERCENTILE
+}
+/**
+ * \brief Records a frame that was just written to the gateway.
+ *
+ * The running reading count and the queue are updated under one lock, so queued frames stay ordered
+ * by the number of readings that must be committed before they are.
+ *
+ * \param readings Readings in the frame.
+ * \param sent_at Monotonic time the frame was sent.
+ *
+ * \return void
+ */
+static void tracker_frame_sent(int readings, double sent_at)
+{
+    pthread_mutex_lock(&tracker.mutex);
+    tracker.readings_sent += readings;
+
+    if (config.db_path)
+    {
+        if (tracker.count == tracker.capacity)
+        {
+            size_t capacity = tracker.capacity ? tracker.capacity * 2 : 4096;
+            PendingFrame *grown = malloc(capacity * sizeof(PendingFrame));
+            if (!grown)
+            {
+                pthread_mutex_unlock(&tracker.mutex);
+                return;
+            }
+            for (size_t i = 0; i < tracker.count; i++)
+                grown[i] = tracker.frames[(tracker.head + i) % tracker.capacity];
+            free(tracker.frames);
+            tracker.frames = grown;
+            tracker.head = 0;
+            tracker.capacity = capacity;
+        }
+        PendingFrame *frame = &tracker.frames[(tracker.head + tracker.count++) % tracker.capacity];
+        frame->readings_total = tracker.readings_sent;
+        frame->sent_at = sent_at;
+    }
+    pthread_mutex_unlock(&tracker.mutex);
+}
+/**
+ * \brief Reads the number of committed readings from the gateway's partition catalog.
+ *
+ * \param db Read-only connection to the gateway database.
+ *
+ * \return long The row count, 0 for an empty database, -1 on error.
+ */
+static long read_commit_watermark(sqlite3 *db)
+{
+    sqlite3_stmt *stmt;
+    long watermark = -1;
+
+    if (sqlite3_prepare_v2(db, "SELECT IFNULL(SUM(rows), 0) FROM sensor_partitions", -1, &stmt, NULL) != SQLITE_OK)
+        return -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        watermark = (long)sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return watermark;
+}
+/**
+ * \brief Commit tracker thread: turns the database watermark into end-to-end latencies.
+ *
+ * The gateway stores one row per reading. Once the number of rows committed since the start reaches
+ * the running reading count of a sent frame, that frame (and every earlier one) is in the database.
+ * This assumes the load generator is the only writer while it runs.
+ *
+ * \param arg Unused.
+ *
+ * \return NULL
+ */
+static void *tracker_main(void *arg)
+{
+    (void)arg;
+    sqlite3 *db;
+    if (sqlite3_open_v2(config.db_path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "Cannot open %s: %s\n", config.db_path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return NULL;
+    }
+    sqlite3_busy_timeout(db, 100);
+
+    long baseline = read_commit_watermark(db);
+    double drain_deadline = 0;
+
+    while (1)
+    {
+        long watermark = read_commit_watermark(db);
+        double now = now_seconds();
+
+        pthread_mutex_lock(&tracker.mutex);
+        if (watermark >= baseline && baseline >= 0)
+            tracker.committed = (unsigned long)(watermark - baseline);
+        while (tracker.count > 0 && tracker.frames[tracker.head].readings_total <= tracker.committed)
+        {
+            sample_add(&tracker.latency, (now - tracker.frames[tracker.head].sent_at) * 1000.0);
+            tracker.head = (tracker.head + 1) % tracker.capacity;
+            tracker.count--;
+        }
+        bool drained = tracker.count == 0;
+        pthread_mutex_unlock(&tracker.mutex);
+
+        if (stop_requested)
+        {
+            if (drain_deadline == 0)
+                drain_deadline = now + LOADGEN_DRAIN_GRACE_SECONDS;
+            if (drained || now >= drain_deadline)
+                break;
+        }
+        if (baseline < 0)
+            baseline = watermark; // table did not exist yet
+        sleep_seconds(LOADGEN_DB_POLL_SECONDS);
+    }
+
+    sqlite3_close(db);
+    return NULL;
+}
+/**
+ * \brief Binds a socket to the source address of a sensor.
+ *
+ * The gateway admits MAX_CONNECTIONS_PER_IP connections per source address, so against a loopback
+ * target the sensors are spread over 127.0.x.y addresses.
+ *
+ * \param fd The unconnected socket.
+ * \param sensor_index The sensor index.
+ *
+ * \return bool true on success (or when no source spreading is configured), false otherwise.
+ */
+static bool bind_source_address(int fd, int sensor_index)
+{
+    if (config.source_addresses <= 0)
+        return true;
+
+    int source = sensor_index % config.source_addresses;
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + source); // 127.0.0.2 onwards
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        handle_error("Failed to bind source address");
+        return false;
+    }
+    return true;
+}
+/**
+ * \brief Connects a simulated sensor: TCP connect, TLS handshake and client info packet.
+ *
+ * \param worker The worker owning the sensor (records the connect latency).
+ * \param sensor The sensor.
+ *
+ * \return bool true if the sensor is connected, false otherwise.
+ */
+static bool connect_sensor(LoadgenWorker *worker, SimulatedSensor *sensor)
+{
+    double started = now_seconds();
+
+    int fd = create_socket();
+    if (fd < 0)
+        return false;
+
+    if (!bind_source_address(fd, sensor->index) || !connect_to_server(fd, config.host, config.port))
+    {
+        close(fd);
+        return false;
+    }
+
+    // source ports repeat across source addresses, so the reported port is derived from the sensor index
+    ClientInfoPacket info;
+    memset(&info, 0, sizeof(info));
+    info.sock_fd = fd;
+    info.port = LOADGEN_REPORTED_PORT_BASE + sensor->index;
+
+    char local_ip[INET_ADDRSTRLEN];
+    int local_port = get_port(fd, local_ip);
+    bool ip_fits = local_port >= 0 &&
+                   snprintf(info.ip_address, sizeof(info.ip_address), "%s", local_ip) < (int)sizeof(info.ip_address);
+    SecureCommunication *comm = ip_fits ? create_secure_connection(fd, SECURE_SSL_CLIENT) : NULL;
+    if (!comm)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (!send_all(comm, (const uint8_t *)&info, sizeof(info)))
+    {
+        destroy_secure_connection(comm);
+        return false;
+    }
+
+    double now = now_seconds();
+    sample_add(&worker->connect_latency, (now - started) * 1000.0);
+
+    sensor->comm = comm;
+    sensor->connected = true;
+    sensor->next_send = now + config.readings_per_frame / config.rate;
+    sensor->disconnect_at = config.churn > 0
+                                ? now + config.churn * (0.5 + (double)rand_r(&worker->seed) / RAND_MAX)
+                                : 0;
+    return true;
+}
+/**
+ * \brief Closes a simulated sensor's connection.
+ *
+ * \param sensor The sensor.
+ * \param reconnect_at When the sensor connects again.
+ *
+ * \return void
+ */
+static void disconnect_sensor(SimulatedSensor *sensor, double reconnect_at)
+{
+    destroy_secure_connection(sensor->comm); // also closes the socket
+    sensor->comm = NULL;
+    sensor->connected = false;
+    sensor->reconnect_at = reconnect_at;
+}
+/**
+ * \brief Sends the next measurement frame of a sensor.
+ *
+ * \param worker The worker owning the sensor.
+ * \param sensor The connected sensor.
+ *
+ * \return bool true on success, false if the connection failed.
+ */
+static bool send_sensor_frame(LoadgenWorker *worker, SimulatedSensor *sensor)
+{
+    MeasurementFrame frame = {.version = PROTOCOL_VERSION};
+    uint8_t buffer[PROTOCOL_MAX_FRAME_SIZE];
+
+    frame.sequence = sensor->sequence++;
+    frame.base_timestamp = (uint32_t)time(NULL);
+    frame.count = (uint8_t)config.readings_per_frame;
+    for (int i = 0; i < frame.count; i++)
+    {
+        frame.readings[i].offset = 0;
+        frame.readings[i].temperature = 15.0f + (float)(rand_r(&worker->seed) % 200) / 10.0f;
+    }
+
+    size_t len = protocol_encode_frame(&frame, buffer, sizeof(buffer));
+    if (len == 0 || !send_all(sensor->comm, buffer, len))
+        return false;
+
+    atomic_fetch_add(&frames_sent, 1);
+    tracker_frame_sent(frame.count, now_seconds());
+    return true;
+}
+/**
+ * \brief Worker thread: drives every sensor whose index is congruent to the worker index.
+ *
+ * Sensor I/O is blocking, so a slow connect delays the other sensors of the same worker; use more
+ * workers (-t) when churn is high.
+ *
+ * \param arg The LoadgenWorker.
+ *
+ * \return NULL
+ */
+static void *worker_main(void *arg)
+{
+    LoadgenWorker *worker = (LoadgenWorker *)arg;
+
+    int count = 0;
+    for (int i = worker->index; i < config.sensors; i += config.threads)
+        count++;
+
+    SimulatedSensor *sensors = calloc(count, sizeof(SimulatedSensor));
+    if (!sensors)
+        return NULL;
+
+    double start = now_seconds();
+    for (int i = 0; i < count; i++)
+    {
+        sensors[i].index = worker->index + i * config.threads;
+        sensors[i].reconnect_at = start;
+    }
+
+    while (!stop_requested)
+    {
+        double now = now_seconds();
+        double wake = now + LOADGEN_MAX_SLEEP_SECONDS;
+
+        for (int i = 0; i < count && !stop_requested; i++)
+        {
+            SimulatedSensor *sensor = &sensors[i];
+
+            if (!sensor->connected)
+            {
+                if (now < sensor->reconnect_at)
+                {
+                    if (sensor->reconnect_at < wake)
+                        wake = sensor->reconnect_at;
+                    continue;
+                }
+                if (!connect_sensor(worker, sensor))
+                {
+                    atomic_fetch_add(&connects_failed, 1);
+                    sensor->reconnect_at = now_seconds() + LOADGEN_RECONNECT_DELAY_SECONDS;
+                    continue;
+                }
+                atomic_fetch_add(&connects_ok, 1);
+                now = now_seconds();
+            }
+
+            if (sensor->disconnect_at > 0 && now >= sensor->disconnect_at)
+            {
+                atomic_fetch_add(&churned, 1);
+                disconnect_sensor(sensor, now);
+                wake = now;
+                continue;
+            }
+
+            if (now >= sensor->next_send)
+            {
+                if (!send_sensor_frame(worker, sensor))
+                {
+                    atomic_fetch_add(&send_failures, 1);
+                    disconnect_sensor(sensor, now + LOADGEN_RECONNECT_DELAY_SECONDS);
+                    continue;
+                }
+                // keep the schedule, but do not burst to catch up after a stall
+                sensor->next_send += config.readings_per_frame / config.rate;
+                if (sensor->next_send < now)
+                    sensor->next_send = now;
+            }
+
+            if (sensor->next_send < wake)
+                wake = sensor->next_send;
+            if (sensor->disconnect_at > 0 && sensor->disconnect_at < wake)
+                wake = sensor->disconnect_at;
+        }
+
+        sleep_seconds(wake - now_seconds());
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (sensors[i].connected)
+            disconnect_sensor(&sensors[i], 0);
+    }
+    free(sensors);
+    return NULL;
+}
+/**
+ * \brief Handles SIGINT: ends the run early.
+ *
+ * \param sig The signal number (unused).
+ */
+static void handle_stop(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+/**
+ * \brief Prints the command line usage.
+ *
+ * \param program argv[0].
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-n sensors] [-t threads] [-r readings/s per sensor] [-f readings per frame]\n"
+            "          [-d seconds] [-c mean connection lifetime s] [-D gateway db] <host> <port>\n",
+            program);
+}
+/**
+ * \brief Parses the command line into the load generator configuration.
+ *
+ * \param argc Argument count.
+ * \param argv Argument vector.
+ *
+ * \return int 0 on success, -1 on invalid usage.
+ */
+static int parse_arguments(int argc, char *argv[])
+{
+    config.sensors = 100;
+    config.threads = 4;
+    config.rate = 1.0;
+    config.readings_per_frame = SENSOR_SAMPLES_PER_FRAME;
+    config.duration = 30.0;
+    config.churn = 0.0;
+    config.db_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:r:f:d:c:D:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            config.sensors = atoi(optarg);
+            break;
+        case 't':
+            config.threads = atoi(optarg);
+            break;
+        case 'r':
+            config.rate = atof(optarg);
+            break;
+        case 'f':
+            config.readings_per_frame = atoi(optarg);
+            break;
+        case 'd':
+            config.duration = atof(optarg);
+            break;
+        case 'c':
+            config.churn = atof(optarg);
+            break;
+        case 'D':
+            config.db_path = optarg;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    if (optind != argc - 2 || !is_valid_ip(argv[optind]) || !is_valid_port(atoi(argv[optind + 1])))
+        return -1;
+    if (snprintf(config.host, sizeof(config.host), "%s", argv[optind]) >= (int)sizeof(config.host))
+        return -1; // longer than any IPv4 address
+    if (config.sensors < 1 || config.threads < 1 || config.rate <= 0 || config.duration <= 0 ||
+        config.readings_per_frame < 1 || config.readings_per_frame > PROTOCOL_MAX_READINGS)
+        return -1;
+    if (config.sensors > MAX_PORT_NUMBER - LOADGEN_REPORTED_PORT_BASE)
+        return -1;
+    if (config.threads > config.sensors)
+        config.threads = config.sensors;
+
+    config.port = atoi(argv[optind + 1]);
+
+    // the gateway's IP limiter admits MAX_CONNECTIONS_PER_IP per address; spread loopback load over more
+    struct in_addr target;
+    inet_pton(AF_INET, config.host, &target);
+    if ((ntohl(target.s_addr) >> 24) == 127 && config.sensors > MAX_CONNECTIONS_PER_IP)
+    {
+        config.source_addresses = (config.sensors + MAX_CONNECTIONS_PER_IP - 1) / MAX_CONNECTIONS_PER_IP;
+        if (config.source_addresses > MAX_UNIQUE_IPS)
+        {
+            config.source_addresses = MAX_UNIQUE_IPS;
+            fprintf(stderr, "Warning: the gateway admits at most %d loopback sensors (%d addresses x %d)\n",
+                    MAX_UNIQUE_IPS * MAX_CONNECTIONS_PER_IP, MAX_UNIQUE_IPS, MAX_CONNECTIONS_PER_IP);
+        }
+    }
+    return 0;
+}
+/**
+ * \brief Prints the run summary.
+ *
+ * \param workers The worker array.
+ * \param elapsed Measured run time in seconds.
+ *
+ * \return void
+ */
+static void print_report(LoadgenWorker *workers, double elapsed)
+{
+    SampleSet connect_latency = {0};
+    for (int i = 0; i < config.threads; i++)
+    {
+        for (size_t j = 0; j < workers[i].connect_latency.count; j++)
+            sample_add(&connect_latency, workers[i].connect_latency.values[j]);
+    }
+
+    printf("\n+-------------------- Load generator report --------------------+\n");
+    printf(" Sensors               : %d on %d threads, %.2f readings/s each, %d per frame\n",
+           config.sensors, config.threads, config.rate, config.readings_per_frame);
+    printf(" Run time              : %.1f s\n", elapsed);
+    printf(" Connections           : %lu ok, %lu failed, %lu churned, %lu send failures\n",
+           atomic_load(&connects_ok), atomic_load(&connects_failed), atomic_load(&churned),
+           atomic_load(&send_failures));
+    print_percentiles("Connect latency", &connect_latency);
+    printf(" Sent                  : %lu readings in %lu frames (%.1f readings/s)\n",
+           tracker.readings_sent, atomic_load(&frames_sent), tracker.readings_sent / elapsed);
+    if (config.db_path)
+    {
+        printf(" Committed             : %lu rows (%.1f rows/s)\n", tracker.committed, tracker.committed / elapsed);
+        print_percentiles("End-to-end latency", &tracker.latency);
+        if (tracker.count > 0)
+            printf(" Not committed         : %zu frames still pending after %.0f s\n",
+                   tracker.count, LOADGEN_DRAIN_GRACE_SECONDS);
+    }
+    printf("+---------------------------------------------------------------+\n");
+
+    free(connect_latency.values);
+}
+
+// ==== Main Function ====
+
+int main(int argc, char *argv[])
+{
+    if (parse_arguments(argc, argv) < 0)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    init_ssl_context();
+    pthread_mutex_init(&tracker.mutex, NULL);
+
+    pthread_t tracker_thread;
+    bool tracking = config.db_path && pthread_create(&tracker_thread, NULL, tracker_main, NULL) == 0;
+
+    LoadgenWorker *workers = calloc(config.threads, sizeof(LoadgenWorker));
+    if (!workers)
+    {
+        handle_error("Failed to allocate workers");
+        return EXIT_FAILURE;
+    }
+
+    double started = now_seconds();
+    for (int i = 0; i < config.threads; i++)
+    {
+        workers[i].index = i;
+        workers[i].seed = (unsigned int)time(NULL) ^ (unsigned int)(i * 2654435761u);
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    }
+
+    // the run ends after the configured duration or on Ctrl+C
+    while (!stop_requested && now_seconds() - started < config.duration)
+        sleep_seconds(0.1);
+    stop_requested = 1;
+
+    for (int i = 0; i < config.threads; i++)
+        pthread_join(workers[i].thread, NULL);
+    double elapsed = now_seconds() - started;
+    if (tracking)
+        pthread_join(tracker_thread, NULL);
+
+    print_report(workers, elapsed);
+
+    for (int i = 0; i < config.threads; i++)
+        free(workers[i].connect_latency.values);
+    free(workers);
+    free(tracker.frames);
+    free(tracker.latency.values);
+    pthread_mutex_destroy(&tracker.mutex);
+    cleanup_ssl_context();
+    return EXIT_SUCCESS;
+}
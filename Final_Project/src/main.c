@@ -10,20 +10,23 @@
 #include "connection/connection.h"
 #include "user_interface/user_interface.h"
 #include "security/security.h"
+#include "io/io.h"
 
 /******************************************************************************/
 /*                              EXPORTED DATA                                 */
 /******************************************************************************/
 SystemManager system_manager;
 volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t reload_requested = 0; // SIGHUP received, the user interface thread reloads
 /******************************************************************************/
 /*                              PRIVATE DATA                                  */
 /******************************************************************************/
 
 pthread_t connection_thread, storage_thread, data_thread;
-pthread_t timeout_thread, update_thread;
 pthread_t log_thread;
 
+static int server_port; // must outlive initialize_system(): the connection thread reads it
+
 /******************************************************************************/
 /*                            FUNCTIONS PROTOTYPES                             */
 /******************************************************************************/
@@ -47,11 +50,26 @@ static void handle_sigint(int sig)
     write(STDOUT_FILENO, "\nSIGINT received. Cleaning up and exiting...\n", 45);
     // cleanup_system();
 }
+/**
+ * @brief Handle SIGHUP signal
+ *
+ * This function only sets the `reload_requested` flag: the threshold profiles are reloaded by the
+ * user interface loop, which wakes up at least once a second.
+ *
+ * @param sig The signal number (unused here).
+ */
+static void handle_sighup(int sig)
+{
+    (void)sig;
+    reload_requested = 1;
+}
 /**
  * @brief Register signal handlers
  *
  * This function registers the SIGINT signal handler to manage graceful program termination
- * when receiving SIGINT (Ctrl+C).
+ * when receiving SIGINT (Ctrl+C), and the SIGHUP handler that reloads the threshold profiles.
+ * SIGPIPE is ignored so a sensor vanishing in the middle of a TLS write surfaces as an error
+ * instead of killing the gateway.
  */
 static void register_signal_handlers()
 {
@@ -60,6 +78,10 @@ static void register_signal_handlers()
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = 0;
     sigaction(SIGINT, &sa, NULL);
+    sa.sa_handler = handle_sighup;
+    sigaction(SIGHUP, &sa, NULL);
+
+    signal(SIGPIPE, SIG_IGN);
 }
 
 /**
@@ -78,7 +100,8 @@ static void initialize_system(int port)
     init_ip_limiter_manager();
     init_ssl_context();
 
-    pthread_create(&connection_thread, NULL, connection_manager, &port);
+    server_port = port;
+    pthread_create(&connection_thread, NULL, connection_manager, &server_port);
     // pthread_detach(connection_thread);
 
     pthread_create(&storage_thread, NULL, storage_manager, NULL);
@@ -87,55 +110,37 @@ static void initialize_system(int port)
     pthread_create(&data_thread, NULL, data_manager, NULL);
     // pthread_detach(data_thread);
 }
-/**
- * @brief Start additional background threads
- *
- * This function creates additional threads for tasks such as checking connection timeouts
- * and updating sensor data.
- */
-static void start_background_threads()
-{
-
-    pthread_create(&timeout_thread, NULL, check_timeout_connection_thread, NULL);
-    // pthread_detach(timeout_thread);
-
-    pthread_create(&update_thread, NULL, update_sensor_data_thread, NULL);
-    // pthread_detach(update_thread);
-}
 /**
  * @brief Cleanup all threads
  *
- * This function cancels and joins all threads created by the system.
+ * This function joins all threads created by the system. The connection thread returns once every
+ * reactor thread has left its event loop. The storage thread is joined, so it never dies in the middle
+ * of a transaction, and so is the data thread, so it never dies holding the data manager mutex.
  */
 static void cleanup_threads()
 {
-    pthread_cancel(connection_thread);
-    pthread_cancel(storage_thread);
-    pthread_cancel(data_thread);
+    // reactors, the storage and the data threads notice stop_requested within one wait timeout, so they are
+    // joined, not cancelled
     // pthread_cancel(log_thread);
-    pthread_cancel(timeout_thread);
-    pthread_cancel(update_thread);
 
     pthread_join(connection_thread, NULL);
     pthread_join(storage_thread, NULL);
     pthread_join(data_thread, NULL);
     // pthread_join(log_thread, NULL);
-    pthread_join(timeout_thread, NULL);
-    pthread_join(update_thread, NULL);
 }
 /**
  * @brief Cleanup system resources
  *
- * This function calls the appropriate cleanup functions for system components such as
- * connection manager, data manager, storage manager, and SSL context.
+ * This function stops the worker threads first, then calls the appropriate cleanup functions for
+ * system components such as connection manager, data manager, storage manager, and SSL context.
  */
 static void cleanup_system()
 {
+    cleanup_threads();
     cleanup_connection_manager();
     cleanup_data_manager();
     cleanup_storage_manager();
     cleanup_log_manager();
-    cleanup_threads();
     cleanup_ssl_context();
 }
 
@@ -189,7 +194,8 @@ static int set_stdin_nonblocking(int enable)
  * @brief Handle user input from stdin
  *
  * This function continuously waits for user input in non-blocking mode. It processes
- * commands when received and stops if a termination signal is received.
+ * commands when received, reloads the threshold profiles after a SIGHUP and stops if a
+ * termination signal is received.
  */
 static void handle_user_input()
 {
@@ -200,6 +206,12 @@ static void handle_user_input()
 
     while (!stop_requested)
     {
+        if (reload_requested)
+        {
+            reload_requested = 0;
+            data_reload_thresholds();
+        }
+
         fd_set read_fds;
         FD_ZERO(&read_fds);
         FD_SET(STDIN_FILENO, &read_fds);
@@ -239,20 +251,143 @@ static void handle_user_input()
     set_stdin_nonblocking(0);
 }
 
+/**
+ * @brief Parse command line options into the gateway configuration
+ *
+ * Usage: app [-r reactors] [-b backlog] [-e epoll_batch] [-i epoll|uring] [-s profile] [-k days] [-S backend] [-a batch]
+ * [-w window] [-E idle_seconds] [-j spill_mib] [-t thresholds_file] <port>. The reactor count
+ * defaults to the number of online CPUs and is clamped to 1..MAX_REACTORS; the listen backlog and the
+ * number of events per wait default to DEFAULT_LISTEN_BACKLOG and DEFAULT_EPOLL_BATCH. The I/O backend
+ * defaults to epoll; io_uring needs a USE_URING=1 build. The storage durability profile defaults to
+ * "normal" (WAL, synchronous NORMAL); day partitions are kept for STORAGE_DEFAULT_RETENTION_DAYS (-k 0 keeps all).
+ * Readings are stored in SQLite by default; "segment" selects the append-only segment files. The data thread
+ * analyzes up to DATA_BATCH_MAX_READINGS queued readings per drain (-a 1 analyzes them one by one) over a window
+ * of TEMPERATURE_HISTORY_SIZE readings per sensor; -w takes a number of readings or of seconds ("60s"). The
+ * analysis state of a sensor silent for DATA_SENSOR_IDLE_SECONDS is freed (-E 0 keeps it). While the database is
+ * unavailable, up to SPILL_DEFAULT_MAX_MIB of readings wait in the spill journal (-j 0: only the disk limits it).
+ * Without -t every sensor has the ALERT_* thresholds; the threshold file is reloaded on SIGHUP and by the `reload` command.
+ *
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @param port Output: the listening port.
+ *
+ * @return 0 on success, -1 on invalid usage.
+ */
+static int parse_arguments(int argc, char *argv[], int *port)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int reactors = cpus > 0 ? (int)cpus : 1;
+    int backlog = DEFAULT_LISTEN_BACKLOG;
+    int batch = DEFAULT_EPOLL_BATCH;
+    IoBackendType io_backend = IO_BACKEND_EPOLL;
+    StorageProfileType storage_profile = STORAGE_PROFILE_NORMAL;
+    int retention_days = STORAGE_DEFAULT_RETENTION_DAYS;
+    StorageBackendType storage_backend = STORAGE_BACKEND_SQLITE;
+    int analysis_batch = DATA_BATCH_MAX_READINGS;
+    StatsWindow stats_window = {TEMPERATURE_HISTORY_SIZE, 0};
+    int sensor_idle_seconds = DATA_SENSOR_IDLE_SECONDS;
+    long spill_max_mib = SPILL_DEFAULT_MAX_MIB;
+    const char *thresholds_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:b:e:i:s:k:S:a:w:E:j:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            reactors = atoi(optarg);
+            break;
+        case 'b':
+            backlog = atoi(optarg);
+            break;
+        case 'e':
+            batch = atoi(optarg);
+            break;
+        case 'i':
+            if (!io_backend_from_name(optarg, &io_backend))
+                return -1;
+            break;
+        case 's':
+            if (!storage_profile_from_name(optarg, &storage_profile))
+                return -1;
+            break;
+        case 'k':
+            retention_days = atoi(optarg);
+            break;
+        case 'S':
+            if (!storage_backend_from_name(optarg, &storage_backend))
+                return -1;
+            break;
+        case 'a':
+            analysis_batch = atoi(optarg);
+            break;
+        case 'w':
+            if (!stats_window_from_text(optarg, &stats_window))
+                return -1;
+            break;
+        case 'E':
+            sensor_idle_seconds = atoi(optarg);
+            break;
+        case 'j':
+            spill_max_mib = atol(optarg);
+            break;
+        case 't':
+            thresholds_path = optarg;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    if (optind != argc - 1)
+        return -1;
+
+    if (reactors < 1)
+        reactors = 1;
+    if (reactors > MAX_REACTORS)
+        reactors = MAX_REACTORS;
+
+    if (backlog < 1)
+        backlog = DEFAULT_LISTEN_BACKLOG;
+    if (batch < 1)
+        batch = DEFAULT_EPOLL_BATCH;
+    if (retention_days < 0)
+        retention_days = 0;
+    if (analysis_batch < 1)
+        analysis_batch = DATA_BATCH_MAX_READINGS;
+    if (sensor_idle_seconds < 0)
+        sensor_idle_seconds = 0;
+    if (spill_max_mib < 0)
+        spill_max_mib = SPILL_DEFAULT_MAX_MIB;
+
+    system_manager.config.reactor_count = reactors;
+    system_manager.config.listen_backlog = backlog;
+    system_manager.config.epoll_batch = batch;
+    system_manager.config.io_backend = io_backend;
+    system_manager.config.storage_profile = storage_profile;
+    system_manager.config.retention_days = retention_days;
+    system_manager.config.storage_backend = storage_backend;
+    system_manager.config.analysis_batch = analysis_batch;
+    system_manager.config.stats_window = stats_window;
+    system_manager.config.sensor_idle_seconds = sensor_idle_seconds;
+    system_manager.config.spill_max_mib = spill_max_mib;
+    system_manager.config.thresholds_path = thresholds_path;
+    *port = atoi(argv[optind]);
+    return 0;
+}
+
 // ==== Main Function ====
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2)
+    int port;
+    if (parse_arguments(argc, argv, &port) < 0)
     {
-        fprintf(stderr, "Usage: %s <port>\n", argv[0]);
+        fprintf(stderr, "Usage: %s [-r reactors] [-b backlog] [-e epoll_batch] [-i epoll|uring] [-s rollback|safe|normal|fast] [-k retention_days] [-S sqlite|segment] [-a analysis_batch] [-w samples|<seconds>s] [-E sensor_idle_seconds] [-j spill_mib] [-t thresholds_file] <port>\n", argv[0]);
         return EXIT_FAILURE;
     }
 
-    int port = atoi(argv[1]);
-
     register_signal_handlers();
-    start_background_threads();
     start_log_process();
     initialize_system(port);
     handle_user_input();
@@ -0,0 +1,918 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "partition.h"
+#include "../rollup/rollup.h"
+#include "../gorilla/gorilla.h"
+/******************************************************************************/
+/*                     LOCAL TYPES and DEFINITIONS                            */
+/******************************************************************************/
+// a decoded reading waiting in the merge heap of partition_read_page()
+typedef struct
+{
+    int timestamp;
+    int sensor_id;
+    float temperature;
+    long id;
+} ChunkReading;
+
+typedef struct
+{
+    ChunkReading *items;
+    int count;
+    int capacity;
+} ChunkHeap;
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns the partition (UTC day) a reading belongs to.
+ *
+ * \param timestamp Epoch seconds of the reading.
+ *
+ * \return int Days since the epoch, rounded down.
+ */
+int partition_day(int timestamp)
+{
+    int day = timestamp / STORAGE_PARTITION_SECONDS;
+    if (timestamp < 0 && timestamp % STORAGE_PARTITION_SECONDS != 0)
+        day--;
+    return day;
+}
+/**
+ * \brief Formats the table name of a day partition, e.g. `sensor_data_20250430`.
+ *
+ * \param day Days since the epoch.
+ * \param name Output buffer.
+ * \param size Size of the buffer, at least STORAGE_PARTITION_NAME_SIZE.
+ */
+void partition_table_name(int day, char *name, size_t size)
+{
+    time_t start = (time_t)day * STORAGE_PARTITION_SECONDS;
+    struct tm tm;
+    gmtime_r(&start, &tm);
+    strftime(name, size, "sensor_data_%Y%m%d", &tm);
+}
+/**
+ * \brief Creates the partition catalog if it does not exist.
+ *
+ * \param db The writer's database handle.
+ *
+ * \return bool true on success, false otherwise.
+ *
+ * \note The catalog holds one row per day partition with its row count and time range, so queries
+ *       can skip partitions outside their range and the retention policy never scans a partition.
+ */
+bool partition_init_catalog(sqlite3 *db)
+{
+    const char *create_catalog_sql = "CREATE TABLE IF NOT EXISTS sensor_partitions "
+                                     "(day INTEGER PRIMARY KEY, table_name TEXT NOT NULL, "
+                                     "rows INTEGER NOT NULL DEFAULT 0, min_timestamp INTEGER, max_timestamp INTEGER)";
+    return sqlite3_exec(db, create_catalog_sql, NULL, NULL, NULL) == SQLITE_OK;
+}
+/**
+ * \brief Initializes an empty writer cache.
+ *
+ * \param cache The cache.
+ */
+void partition_cache_init(PartitionWriterCache *cache)
+{
+    for (int i = 0; i < STORAGE_PARTITION_CACHE; i++)
+    {
+        cache->writers[i].day = -1;
+        cache->writers[i].insert_stmt = NULL;
+        cache->writers[i].minute_stmt = NULL;
+        cache->writers[i].rows = 0;
+    }
+    cache->catalog_stmt = NULL;
+    cache->clock = 0;
+    cache->compact_window = LLONG_MIN;
+    cache->written_window = LLONG_MAX;
+    atomic_init(&cache->encoded_readings, 0);
+    atomic_init(&cache->encoded_bytes, 0);
+    atomic_init(&cache->compacted_chunks, 0);
+}
+/**
+ * \brief Prepares the catalog statement of the cache on a new connection.
+ *
+ * \param cache The cache, initialized and empty.
+ * \param db The writer's database handle.
+ *
+ * \return bool true on success, false otherwise.
+ */
+bool partition_cache_open(PartitionWriterCache *cache, sqlite3 *db)
+{
+    const char *upsert_sql = "INSERT INTO sensor_partitions (day, table_name, rows, min_timestamp, max_timestamp) "
+                             "VALUES (?, ?, ?, ?, ?) ON CONFLICT(day) DO UPDATE SET "
+                             "rows = rows + excluded.rows, "
+                             "min_timestamp = MIN(min_timestamp, excluded.min_timestamp), "
+                             "max_timestamp = MAX(max_timestamp, excluded.max_timestamp)";
+    return sqlite3_prepare_v2(db, upsert_sql, -1, &cache->catalog_stmt, NULL) == SQLITE_OK;
+}
+/**
+ * \brief Forgets every partition writer, discarding counts not yet flushed to the catalog.
+ *
+ * \param cache The cache.
+ *
+ * \note Called after a rollback (a partition created by it no longer exists) and before partitions
+ *       are dropped. The catalog statement is kept.
+ */
+void partition_cache_reset(PartitionWriterCache *cache)
+{
+    for (int i = 0; i < STORAGE_PARTITION_CACHE; i++)
+    {
+        sqlite3_finalize(cache->writers[i].insert_stmt);
+        sqlite3_finalize(cache->writers[i].minute_stmt);
+        cache->writers[i].insert_stmt = NULL;
+        cache->writers[i].minute_stmt = NULL;
+        cache->writers[i].day = -1;
+        cache->writers[i].rows = 0;
+    }
+}
+/**
+ * \brief Finalizes every statement of the cache.
+ *
+ * \param cache The cache.
+ */
+void partition_cache_close(PartitionWriterCache *cache)
+{
+    partition_cache_reset(cache);
+    sqlite3_finalize(cache->catalog_stmt);
+    cache->catalog_stmt = NULL;
+}
+/**
+ * \brief Adds the rows a writer inserted in the current transaction to the catalog.
+ *
+ * \param cache The cache.
+ * \param writer The partition writer.
+ *
+ * \return bool true on success, false otherwise.
+ */
+static bool flush_writer(PartitionWriterCache *cache, PartitionWriter *writer)
+{
+    if (writer->rows == 0)
+        return true;
+
+    char name[STORAGE_PARTITION_NAME_SIZE];
+    partition_table_name(writer->day, name, sizeof(name));
+
+    sqlite3_stmt *stmt = cache->catalog_stmt;
+    sqlite3_reset(stmt);
+    sqlite3_bind_int(stmt, 1, writer->day);
+    sqlite3_bind_text(stmt, 2, name, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, writer->rows);
+    sqlite3_bind_int(stmt, 4, writer->min_timestamp);
+    sqlite3_bind_int(stmt, 5, writer->max_timestamp);
+    if (sqlite3_step(stmt) != SQLITE_DONE)
+        return false;
+
+    writer->rows = 0;
+    return true;
+}
+/**
+ * \brief Flushes the row counts and time ranges of every partition written by the current transaction.
+ *
+ * \param cache The cache.
+ *
+ * \return bool true on success, false otherwise.
+ *
+ * \note Must run inside the transaction that inserted the rows, so the catalog never disagrees with the data.
+ */
+bool partition_flush_catalog(PartitionWriterCache *cache)
+{
+    for (int i = 0; i < STORAGE_PARTITION_CACHE; i++)
+    {
+        if (cache->writers[i].day >= 0 && !flush_writer(cache, &cache->writers[i]))
+            return false;
+    }
+    return true;
+}
+/**
+ * \brief Creates a day partition, its indexes and its minute rollup if needed and prepares their statements.
+ *
+ * \param db The writer's database handle.
+ * \param day The partition's day.
+ * \param writer Output: receives the INSERT and minute rollup statements.
+ *
+ * \return bool true on success, false otherwise (no statement is left open).
+ *
+ * \note A partition holds compressed chunks, not one row per reading: each row is up to
+ *       STORAGE_CHUNK_MAX_READINGS readings of one sensor within one STORAGE_CHUNK_WINDOW_SECONDS window,
+ *       Gorilla-encoded in `data`; `sensor_id` is the sensor's reported port, the same across its reconnects.
+ *       `<name>_sensor` (sensor_id, start_ts) serves per-sensor pages and
+ *       `<name>_time` (start_ts) pages over every sensor. The minute rollup `<name>_minute` lives and is
+ *       dropped with its partition.
+ */
+static bool open_partition(sqlite3 *db, int day, PartitionWriter *writer)
+{
+    char name[STORAGE_PARTITION_NAME_SIZE];
+    char minute_table[STORAGE_PARTITION_NAME_SIZE + 8];
+    char sql[512];
+
+    partition_table_name(day, name, sizeof(name));
+    snprintf(sql, sizeof(sql), "CREATE TABLE IF NOT EXISTS %s (id INTEGER PRIMARY KEY, sensor_id INTEGER, "
+                               "start_ts INTEGER, end_ts INTEGER, count INTEGER, data BLOB); "
+                               "CREATE INDEX IF NOT EXISTS %s_sensor ON %s (sensor_id, start_ts); "
+                               "CREATE INDEX IF NOT EXISTS %s_time ON %s (start_ts);",
+             name, name, name, name, name);
+    if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+        return false;
+
+    snprintf(minute_table, sizeof(minute_table), "%s_minute", name);
+    if (!rollup_create_table(db, minute_table))
+        return false;
+
+    snprintf(sql, sizeof(sql), "INSERT INTO %s (sensor_id, start_ts, end_ts, count, data) VALUES (?, ?, ?, ?, ?)", name);
+    if (sqlite3_prepare_v2(db, sql, -1, &writer->insert_stmt, NULL) != SQLITE_OK)
+        return false;
+
+    writer->minute_stmt = rollup_prepare_upsert(db, minute_table);
+    if (writer->minute_stmt == NULL)
+    {
+        sqlite3_finalize(writer->insert_stmt);
+        writer->insert_stmt = NULL;
+        return false;
+    }
+    return true;
+}
+/**
+ * \brief Returns the writer of a day partition, opening it in place of the least recently used one.
+ *
+ * \param cache The cache.
+ * \param db The writer's database handle.
+ * \param day The partition's day.
+ *
+ * \return PartitionWriter* The writer, or NULL on failure.
+ *
+ * \note Readings arrive in time order, so in practice only the current day (and the previous one
+ *       around midnight) is open; late or skewed readings evict at most the least recently used entry.
+ */
+static PartitionWriter *writer_for_day(PartitionWriterCache *cache, sqlite3 *db, int day)
+{
+    PartitionWriter *victim = &cache->writers[0];
+
+    for (int i = 0; i < STORAGE_PARTITION_CACHE; i++)
+    {
+        PartitionWriter *writer = &cache->writers[i];
+        if (writer->day == day)
+        {
+            writer->last_used = ++cache->clock;
+            return writer;
+        }
+        if (writer->day < 0 || (victim->day >= 0 && writer->last_used < victim->last_used))
+            victim = writer;
+    }
+
+    if (victim->day >= 0 && !flush_writer(cache, victim))
+        return NULL;
+    sqlite3_finalize(victim->insert_stmt);
+    sqlite3_finalize(victim->minute_stmt);
+    victim->insert_stmt = NULL;
+    victim->minute_stmt = NULL;
+    victim->day = -1;
+
+    if (!open_partition(db, day, victim))
+        return NULL;
+    victim->day = day;
+    victim->rows = 0;
+    victim->last_used = ++cache->clock;
+    return victim;
+}
+/**
+ * \brief Returns the minute rollup UPSERT of a day partition, opening the partition if needed.
+ *
+ * \param cache The cache.
+ * \param db The writer's database handle.
+ * \param day The partition's day.
+ *
+ * \return sqlite3_stmt* The statement, or NULL on failure.
+ */
+sqlite3_stmt *partition_minute_rollup(PartitionWriterCache *cache, sqlite3 *db, int day)
+{
+    PartitionWriter *writer = writer_for_day(cache, db, day);
+    return writer ? writer->minute_stmt : NULL;
+}
+/**
+ * \brief Returns the chunk window a reading belongs to.
+ *
+ * \return long long First epoch second of the window.
+ */
+static long long chunk_window(int timestamp)
+{
+    long long start = timestamp - (long long)timestamp % STORAGE_CHUNK_WINDOW_SECONDS;
+    return start > timestamp ? start - STORAGE_CHUNK_WINDOW_SECONDS : start;
+}
+/**
+ * \brief Encodes readings of one sensor and one window and inserts them as one chunk.
+ *
+ * \param stmt INSERT statement of the chunk's partition.
+ * \param cache The cache, whose compression counters are updated.
+ * \param readings The readings, in time order.
+ * \param count Number of readings, at most STORAGE_CHUNK_MAX_READINGS.
+ *
+ * \return bool true on success, false otherwise.
+ */
+static bool insert_chunk(sqlite3_stmt *stmt, PartitionWriterCache *cache, const SensorData *readings, int count)
+{
+    unsigned char data[GORILLA_MAX_BYTES(STORAGE_CHUNK_MAX_READINGS)];
+    GorillaEncoder encoder;
+
+    gorilla_encoder_init(&encoder, data, sizeof(data));
+    for (int i = 0; i < count; i++)
+        gorilla_encode(&encoder, readings[i].timestamp, readings[i].temperature);
+    size_t size = gorilla_finish(&encoder);
+
+    sqlite3_reset(stmt);
+    sqlite3_bind_int(stmt, 1, readings[0].sensor_id);
+    sqlite3_bind_int(stmt, 2, readings[0].timestamp);
+    sqlite3_bind_int(stmt, 3, readings[count - 1].timestamp);
+    sqlite3_bind_int(stmt, 4, count);
+    sqlite3_bind_blob(stmt, 5, data, (int)size, SQLITE_STATIC);
+    bool inserted = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_clear_bindings(stmt);
+
+    if (inserted)
+    {
+        atomic_fetch_add(&cache->encoded_readings, count);
+        atomic_fetch_add(&cache->encoded_bytes, size);
+    }
+    return inserted;
+}
+/**
+ * \brief Inserts a batch into the day partitions as compressed chunks.
+ *
+ * \param cache The cache.
+ * \param db The writer's database handle.
+ * \param batch The readings, sorted by (sensor_id, timestamp) (see rollup_sort_batch()).
+ * \param count Number of readings in `batch`.
+ * \param first_kept_day Readings of days before this one are skipped (retention).
+ *
+ * \return int Number of readings skipped by the retention, -1 on failure.
+ *
+ * \note Must run inside a transaction that ends with partition_flush_catalog(). Each run of readings of one
+ *       sensor in one window becomes one chunk; the compaction later merges the small chunks of a window.
+ */
+int partition_insert_batch(PartitionWriterCache *cache, sqlite3 *db, const SensorData *batch, int count,
+                           int first_kept_day)
+{
+    int expired = 0;
+
+    for (int i = 0; i < count;)
+    {
+        long long window = chunk_window(batch[i].timestamp);
+        int end = i + 1;
+        while (end < count && end - i < STORAGE_CHUNK_MAX_READINGS && batch[end].sensor_id == batch[i].sensor_id &&
+               chunk_window(batch[end].timestamp) == window)
+            end++;
+
+        int day = partition_day(batch[i].timestamp); // a window never spans two days
+        if (day < first_kept_day)
+        {
+            expired += end - i;
+            i = end;
+            continue;
+        }
+
+        PartitionWriter *writer = writer_for_day(cache, db, day);
+        if (writer == NULL || !insert_chunk(writer->insert_stmt, cache, &batch[i], end - i))
+            return -1;
+
+        if (writer->rows == 0 || batch[i].timestamp < writer->min_timestamp)
+            writer->min_timestamp = batch[i].timestamp;
+        if (writer->rows == 0 || batch[end - 1].timestamp > writer->max_timestamp)
+            writer->max_timestamp = batch[end - 1].timestamp;
+        writer->rows += end - i;
+        if (window < cache->written_window)
+            cache->written_window = window;
+        i = end;
+    }
+    return expired;
+}
+/**
+ * \brief Adds a reading to the merge heap, ordered by (timestamp, id).
+ *
+ * \return bool true on success, false if the heap could not grow.
+ */
+static bool heap_push(ChunkHeap *heap, const ChunkReading *reading)
+{
+    if (heap->count == heap->capacity)
+    {
+        int capacity = heap->capacity > 0 ? heap->capacity * 2 : STORAGE_CHUNK_MAX_READINGS;
+        ChunkReading *items = realloc(heap->items, capacity * sizeof(ChunkReading));
+        if (items == NULL)
+            return false;
+        heap->items = items;
+        heap->capacity = capacity;
+    }
+
+    int i = heap->count++;
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        const ChunkReading *p = &heap->items[parent];
+        if (p->timestamp < reading->timestamp || (p->timestamp == reading->timestamp && p->id < reading->id))
+            break;
+        heap->items[i] = *p;
+        i = parent;
+    }
+    heap->items[i] = *reading;
+    return true;
+}
+/**
+ * \brief Removes the smallest reading of the merge heap.
+ */
+static ChunkReading heap_pop(ChunkHeap *heap)
+{
+    ChunkReading top = heap->items[0];
+    ChunkReading last = heap->items[--heap->count];
+
+    int i = 0;
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= heap->count)
+            break;
+        const ChunkReading *c = &heap->items[child];
+        if (child + 1 < heap->count)
+        {
+            const ChunkReading *r = &heap->items[child + 1];
+            if (r->timestamp < c->timestamp || (r->timestamp == c->timestamp && r->id < c->id))
+                c = r, child++;
+        }
+        if (last.timestamp < c->timestamp || (last.timestamp == c->timestamp && last.id < c->id))
+            break;
+        heap->items[i] = *c;
+        i = child;
+    }
+    if (heap->count > 0)
+        heap->items[i] = last;
+    return top;
+}
+/**
+ * \brief Visits a reading taken from the merge heap and moves the cursor to it.
+ */
+static void visit_reading(const ChunkReading *reading, ReadingCursor *after, ReadingVisitor visit, void *arg)
+{
+    SensorData data = {
+        .timestamp = reading->timestamp,
+        .sensor_id = reading->sensor_id,
+        .temperature = reading->temperature,
+        .is_valid = true,
+    };
+    after->timestamp = reading->timestamp;
+    after->id = reading->id;
+    visit(&data, reading->id, arg);
+}
+/**
+ * \brief Visits the readings of a query from one partition, in (timestamp, id) order.
+ *
+ * \param db A connection to the database.
+ * \param table The partition.
+ * \param query Sensor and time range; `query->from` is ignored, the cursor gives the start.
+ * \param after Output/input: readings after this position are visited; updated to the last visited one.
+ * \param max Maximum number of readings to visit.
+ * \param visit Called for every reading.
+ * \param arg Passed to `visit`.
+ *
+ * \return int Number of readings visited, -1 on failure.
+ *
+ * \note The id of a reading is `chunk id * STORAGE_CHUNK_MAX_READINGS + index`. Chunks are read in start
+ *       order and decoded into a heap; a reading is final, and visited, once the next chunk starts after it.
+ *       Since no chunk spans more than one window, only chunks starting up to a window before the cursor
+ *       are read, so a page costs about the same wherever it starts.
+ */
+int partition_read_page(sqlite3 *db, const char *table, const ReadingQuery *query, ReadingCursor *after, int max,
+                        ReadingVisitor visit, void *arg)
+{
+    char sql[256];
+    sqlite3_stmt *stmt;
+
+    snprintf(sql, sizeof(sql),
+             "SELECT id, sensor_id, start_ts, count, data FROM %s "
+             "WHERE %s start_ts >= ?2 AND start_ts <= ?3 AND end_ts >= ?4 ORDER BY start_ts, id",
+             table, query->sensor_id >= 0 ? "sensor_id = ?1 AND" : "");
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+        return -1;
+    if (query->sensor_id >= 0)
+        sqlite3_bind_int(stmt, 1, query->sensor_id);
+    sqlite3_bind_int64(stmt, 2, (long long)after->timestamp - STORAGE_CHUNK_WINDOW_SECONDS + 1);
+    sqlite3_bind_int(stmt, 3, query->to);
+    sqlite3_bind_int(stmt, 4, after->timestamp);
+
+    ChunkHeap heap = {NULL, 0, 0};
+    ReadingCursor start = *after;
+    int visited = 0;
+    int rc = SQLITE_DONE;
+    bool failed = false;
+    while (visited < max && (rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        long chunk_id = (long)sqlite3_column_int64(stmt, 0);
+        int sensor_id = sqlite3_column_int(stmt, 1);
+        int start_ts = sqlite3_column_int(stmt, 2);
+
+        while (heap.count > 0 && heap.items[0].timestamp < start_ts && visited < max)
+        {
+            ChunkReading reading = heap_pop(&heap);
+            visit_reading(&reading, after, visit, arg);
+            visited++;
+        }
+        if (visited == max)
+            break;
+
+        GorillaDecoder decoder;
+        ChunkReading reading = {.sensor_id = sensor_id};
+        gorilla_decoder_init(&decoder, sqlite3_column_blob(stmt, 4), sqlite3_column_bytes(stmt, 4),
+                             sqlite3_column_int(stmt, 3));
+        for (long index = 0; gorilla_decode(&decoder, &reading.timestamp, &reading.temperature); index++)
+        {
+            reading.id = chunk_id * STORAGE_CHUNK_MAX_READINGS + index;
+            if (reading.timestamp > query->to || reading.timestamp < start.timestamp ||
+                (reading.timestamp == start.timestamp && reading.id <= start.id))
+                continue;
+            if (!heap_push(&heap, &reading))
+            {
+                failed = true;
+                break;
+            }
+        }
+        if (failed)
+            break;
+    }
+
+    while (!failed && heap.count > 0 && visited < max)
+    {
+        ChunkReading reading = heap_pop(&heap);
+        visit_reading(&reading, after, visit, arg);
+        visited++;
+    }
+
+    free(heap.items);
+    sqlite3_finalize(stmt);
+    return failed || (visited < max && rc != SQLITE_DONE) ? -1 : visited;
+}
+/**
+ * \brief Orders decoded readings by timestamp.
+ */
+static int compare_timestamp(const void *a, const void *b)
+{
+    const SensorData *x = a, *y = b;
+    return (x->timestamp > y->timestamp) - (x->timestamp < y->timestamp);
+}
+/**
+ * \brief Merges the partial chunks one sensor has in a window into as few chunks as possible.
+ *
+ * \param db The writer's database handle.
+ * \param table The partition.
+ * \param sensor_id The sensor.
+ * \param window First epoch second of the window.
+ * \param cache The cache, whose compression counters are updated.
+ *
+ * \return int Number of chunks replaced, -1 on failure.
+ *
+ * \note Full chunks are left alone, so readings arriving late into a compacted window only rewrite the partial
+ *       chunk left by the last merge. The chunks are only deleted once every one of them has been read and
+ *       fully decoded: a read error or a chunk decoding to fewer readings than it holds fails the merge and
+ *       leaves the window as it is.
+ */
+static int compact_sensor(sqlite3 *db, const char *table, int sensor_id, long long window, PartitionWriterCache *cache)
+{
+    char sql[256];
+    sqlite3_stmt *stmt;
+    SensorData *readings = NULL;
+    int count = 0;
+    int capacity = 0;
+    int chunks = 0;
+    int rc;
+
+    snprintf(sql, sizeof(sql),
+             "SELECT count, data FROM %s WHERE sensor_id = ? AND start_ts >= ? AND start_ts < ? AND count < %d", table,
+             STORAGE_CHUNK_MAX_READINGS);
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+        return -1;
+    sqlite3_bind_int(stmt, 1, sensor_id);
+    sqlite3_bind_int64(stmt, 2, window);
+    sqlite3_bind_int64(stmt, 3, window + STORAGE_CHUNK_WINDOW_SECONDS);
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        int chunk_count = sqlite3_column_int(stmt, 0);
+        if (chunk_count < 1 || chunk_count > STORAGE_CHUNK_MAX_READINGS)
+            goto fail;
+        if (count + chunk_count > capacity)
+        {
+            capacity = (count + chunk_count) * 2;
+            SensorData *grown = realloc(readings, capacity * sizeof(SensorData));
+            if (grown == NULL)
+                goto fail;
+            readings = grown;
+        }
+
+        GorillaDecoder decoder;
+        int decoded = 0;
+        gorilla_decoder_init(&decoder, sqlite3_column_blob(stmt, 1), sqlite3_column_bytes(stmt, 1), chunk_count);
+        while (decoded < chunk_count &&
+               gorilla_decode(&decoder, &readings[count + decoded].timestamp, &readings[count + decoded].temperature))
+        {
+            readings[count + decoded].sensor_id = sensor_id;
+            readings[count + decoded].is_valid = true;
+            decoded++;
+        }
+        if (decoded != chunk_count)
+            goto fail; // truncated or corrupt chunk: rewriting the window would lose readings
+        count += decoded;
+        chunks++;
+    }
+    if (rc != SQLITE_DONE)
+        goto fail;
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    qsort(readings, count, sizeof(SensorData), compare_timestamp);
+
+    snprintf(sql, sizeof(sql),
+             "DELETE FROM %s WHERE sensor_id = %d AND start_ts >= %lld AND start_ts < %lld AND count < %d", table,
+             sensor_id, window, window + STORAGE_CHUNK_WINDOW_SECONDS, STORAGE_CHUNK_MAX_READINGS);
+    if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+        goto fail;
+
+    snprintf(sql, sizeof(sql), "INSERT INTO %s (sensor_id, start_ts, end_ts, count, data) VALUES (?, ?, ?, ?, ?)",
+             table);
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+        goto fail;
+    for (int i = 0; i < count; i += STORAGE_CHUNK_MAX_READINGS)
+    {
+        int size = count - i < STORAGE_CHUNK_MAX_READINGS ? count - i : STORAGE_CHUNK_MAX_READINGS;
+        if (!insert_chunk(stmt, cache, &readings[i], size))
+            goto fail;
+    }
+    sqlite3_finalize(stmt);
+    free(readings);
+    return chunks;
+
+fail:
+    sqlite3_finalize(stmt);
+    free(readings);
+    return -1;
+}
+/**
+ * \brief Merges the small chunks of some sensors of one window, within a budget of readings.
+ *
+ * \param cache The cache, whose compression counters are updated.
+ * \param db The writer's database handle.
+ * \param window First epoch second of the window.
+ * \param done Output: true once no sensor of the window has chunks left to merge.
+ *
+ * \return int Number of chunks replaced, 0 if there was nothing to merge, -1 on failure.
+ *
+ * \note Only sensors with more partial chunks than their readings need are rewritten, so a compacted window
+ *       costs one index scan. Sensors are merged until STORAGE_COMPACTION_STEP_READINGS readings were rewritten (at least
+ *       one sensor), in one transaction. The ids of the merged readings change: a readdb cursor taken before
+ *       resumes at the right time, possibly repeating or skipping readings of that same second.
+ */
+static int compact_window(PartitionWriterCache *cache, sqlite3 *db, long long window, bool *done)
+{
+    char table[STORAGE_PARTITION_NAME_SIZE];
+    char sql[320];
+    sqlite3_stmt *stmt;
+    int sensors[64];
+    int count = 0;
+    int candidates = 0;
+    int replaced = 0;
+    long long budget = STORAGE_COMPACTION_STEP_READINGS;
+    int rc;
+
+    *done = true;
+
+    int day = partition_day((int)window);
+    partition_table_name(day, table, sizeof(table));
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sensor_partitions WHERE day = ?", -1, &stmt, NULL) != SQLITE_OK)
+        return -1;
+    sqlite3_bind_int(stmt, 1, day);
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    if (!exists)
+        return 0;
+
+    snprintf(sql, sizeof(sql),
+             "SELECT sensor_id, SUM(count) FROM %s WHERE start_ts >= ?1 AND start_ts < ?2 AND count < %d "
+             "GROUP BY sensor_id HAVING COUNT(*) > (SUM(count) + %d) / %d LIMIT 64",
+             table, STORAGE_CHUNK_MAX_READINGS, STORAGE_CHUNK_MAX_READINGS - 1, STORAGE_CHUNK_MAX_READINGS);
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+        return -1;
+    sqlite3_bind_int64(stmt, 1, window);
+    sqlite3_bind_int64(stmt, 2, window + STORAGE_CHUNK_WINDOW_SECONDS);
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        candidates++;
+        if (budget > 0)
+        {
+            sensors[count++] = sqlite3_column_int(stmt, 0);
+            budget -= sqlite3_column_int64(stmt, 1);
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE)
+        return -1;
+    *done = count == candidates && candidates < 64;
+    if (count == 0)
+        return 0;
+
+    if (sqlite3_exec(db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK)
+        return -1;
+    for (int i = 0; i < count; i++)
+    {
+        int chunks = compact_sensor(db, table, sensors[i], window, cache);
+        if (chunks < 0)
+        {
+            sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+            return -1;
+        }
+        replaced += chunks;
+    }
+    if (sqlite3_exec(db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK)
+    {
+        sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+        return -1;
+    }
+
+    atomic_fetch_add(&cache->compacted_chunks, replaced);
+    return replaced;
+}
+/**
+ * \brief Finds the window of the first chunk starting at or after a time.
+ *
+ * \param db The writer's database handle.
+ * \param from Epoch second.
+ * \param window Output: first epoch second of the window, LLONG_MAX if there is no such chunk.
+ *
+ * \return bool true on success, false otherwise.
+ *
+ * \note Walks the catalog, so days and hours without readings are skipped at once.
+ */
+static bool next_chunk_window(sqlite3 *db, long long from, long long *window)
+{
+    sqlite3_stmt *stmt;
+    int rc;
+
+    *window = LLONG_MAX;
+    if (sqlite3_prepare_v2(db, "SELECT table_name FROM sensor_partitions WHERE max_timestamp >= ? ORDER BY day",
+                           -1, &stmt, NULL) != SQLITE_OK)
+        return false;
+    sqlite3_bind_int64(stmt, 1, from);
+    while (*window == LLONG_MAX && (rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        char sql[128];
+        sqlite3_stmt *first;
+        snprintf(sql, sizeof(sql), "SELECT MIN(start_ts) FROM %s WHERE start_ts >= ?", sqlite3_column_text(stmt, 0));
+        if (sqlite3_prepare_v2(db, sql, -1, &first, NULL) != SQLITE_OK)
+            break;
+        sqlite3_bind_int64(first, 1, from);
+        if (sqlite3_step(first) == SQLITE_ROW && sqlite3_column_type(first, 0) != SQLITE_NULL)
+            *window = chunk_window(sqlite3_column_int(first, 0));
+        sqlite3_finalize(first);
+    }
+    sqlite3_finalize(stmt);
+    return *window != LLONG_MAX || rc == SQLITE_DONE;
+}
+/**
+ * \brief Compaction step: merges small chunks written batch by batch in the oldest window that is over
+ *        and not compacted yet.
+ *
+ * \param cache The cache; it keeps track of the windows compacted.
+ * \param db The writer's database handle.
+ * \param now Current epoch second.
+ *
+ * \return int Number of chunks replaced, 0 if there was nothing to merge, -1 on failure.
+ *
+ * \note A batch holds only what each sensor sent in the last STORAGE_BATCH_MAX_LATENCY_MS, so its chunks are
+ *       small and their per-chunk overhead dominates. Once their window is over, the chunks of each sensor are
+ *       decoded and rewritten as full chunks. The storage thread runs one step after every commit, so a busy
+ *       gateway compacts as it writes; a step rewrites at most STORAGE_COMPACTION_STEP_READINGS readings of one
+ *       window, so the writer is never held up long, and the next step resumes the same window until it is
+ *       done. Windows without chunks are skipped. Readings written late into a window already
+ *       compacted bring the compaction back to it. A window whose merge fails (e.g. an unreadable chunk) is
+ *       left as written and skipped, so one bad chunk does not stop the compaction of the later windows.
+ */
+int partition_compact_next(PartitionWriterCache *cache, sqlite3 *db, int now)
+{
+    long long window;
+
+    if (cache->written_window < cache->compact_window)
+        cache->compact_window = cache->written_window;
+    cache->written_window = LLONG_MAX;
+
+    if (cache->compact_window > (long long)now - STORAGE_CHUNK_WINDOW_SECONDS)
+        return 0;
+    if (!next_chunk_window(db, cache->compact_window, &window))
+        return -1;
+    if (window > (long long)now - STORAGE_CHUNK_WINDOW_SECONDS)
+    {
+        cache->compact_window = window; // not over yet
+        return 0;
+    }
+
+    bool done;
+    int replaced = compact_window(cache, db, window, &done);
+    cache->compact_window = done || replaced < 0 ? window + STORAGE_CHUNK_WINDOW_SECONDS : window;
+    return replaced;
+}
+/**
+ * \brief Lists the partitions holding readings in a time range, oldest first.
+ *
+ * \param db A connection to the database.
+ * \param from First epoch second of the range.
+ * \param to Last epoch second of the range.
+ * \param out Output array.
+ * \param max Capacity of `out`.
+ *
+ * \return int Number of partitions listed, -1 on error.
+ *
+ * \note Partition pruning: only the catalog is read, partitions outside the range are never opened.
+ */
+int partition_list(sqlite3 *db, int from, int to, PartitionInfo *out, int max)
+{
+    const char *list_sql = "SELECT day, table_name, rows, min_timestamp, max_timestamp FROM sensor_partitions "
+                           "WHERE max_timestamp >= ? AND min_timestamp <= ? ORDER BY day LIMIT ?";
+    sqlite3_stmt *stmt;
+    int count = 0;
+
+    if (sqlite3_prepare_v2(db, list_sql, -1, &stmt, NULL) != SQLITE_OK)
+        return -1;
+    sqlite3_bind_int(stmt, 1, from);
+    sqlite3_bind_int(stmt, 2, to);
+    sqlite3_bind_int(stmt, 3, max);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        PartitionInfo *info = &out[count++];
+        info->day = sqlite3_column_int(stmt, 0);
+        snprintf(info->table_name, sizeof(info->table_name), "%s", (const char *)sqlite3_column_text(stmt, 1));
+        info->rows = (long)sqlite3_column_int64(stmt, 2);
+        info->min_timestamp = sqlite3_column_int(stmt, 3);
+        info->max_timestamp = sqlite3_column_int(stmt, 4);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? count : -1;
+}
+/**
+ * \brief Drops one partition, its minute rollup and its catalog row in a single transaction.
+ *
+ * \param db The writer's database handle.
+ * \param day The partition's day.
+ *
+ * \return bool true on success, false otherwise.
+ */
+static bool drop_partition(sqlite3 *db, int day)
+{
+    char name[STORAGE_PARTITION_NAME_SIZE];
+    char sql[256];
+
+    partition_table_name(day, name, sizeof(name));
+    snprintf(sql, sizeof(sql),
+             "BEGIN; DROP TABLE IF EXISTS %s; DROP TABLE IF EXISTS %s_minute; "
+             "DELETE FROM sensor_partitions WHERE day = %d; COMMIT;",
+             name, name, day);
+    if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+    {
+        sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+        return false;
+    }
+    return true;
+}
+/**
+ * \brief Retention: drops every partition older than a given day.
+ *
+ * \param db The writer's database handle.
+ * \param first_kept_day Oldest day to keep.
+ *
+ * \return int Number of partitions dropped, -1 if one could not be dropped.
+ *
+ * \note Expiring a day costs one DROP TABLE, whatever the number of rows, instead of a DELETE that
+ *       rewrites every page and index entry. Writer caches must be reset before calling this.
+ */
+int partition_drop_before(sqlite3 *db, int first_kept_day)
+{
+    sqlite3_stmt *stmt;
+    int days[64];
+    int count = 0;
+    int dropped = 0;
+
+    do
+    {
+        if (sqlite3_prepare_v2(db, "SELECT day FROM sensor_partitions WHERE day < ? ORDER BY day LIMIT 64",
+                               -1, &stmt, NULL) != SQLITE_OK)
+            return -1;
+        sqlite3_bind_int(stmt, 1, first_kept_day);
+        count = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+            days[count++] = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+
+        for (int i = 0; i < count; i++)
+        {
+            if (!drop_partition(db, days[i]))
+                return -1;
+            dropped++;
+        }
+    } while (count == 64);
+    return dropped;
+}
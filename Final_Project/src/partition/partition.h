@@ -0,0 +1,29 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+int partition_day(int timestamp);
+void partition_table_name(int day, char *name, size_t size);
+bool partition_init_catalog(sqlite3 *db);
+
+void partition_cache_init(PartitionWriterCache *cache);
+bool partition_cache_open(PartitionWriterCache *cache, sqlite3 *db);
+void partition_cache_reset(PartitionWriterCache *cache);
+void partition_cache_close(PartitionWriterCache *cache);
+int partition_insert_batch(PartitionWriterCache *cache, sqlite3 *db, const SensorData *batch, int count,
+                           int first_kept_day);
+sqlite3_stmt *partition_minute_rollup(PartitionWriterCache *cache, sqlite3 *db, int day);
+bool partition_flush_catalog(PartitionWriterCache *cache);
+
+int partition_compact_next(PartitionWriterCache *cache, sqlite3 *db, int now);
+
+int partition_list(sqlite3 *db, int from, int to, PartitionInfo *out, int max);
+int partition_read_page(sqlite3 *db, const char *table, const ReadingQuery *query, ReadingCursor *after, int max,
+                        ReadingVisitor visit, void *arg);
+int partition_drop_before(sqlite3 *db, int first_kept_day);
+#endif // PARTITION_H
@@ -0,0 +1,180 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "pool.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns the slot at `index`, or NULL if its chunk was never allocated.
+ *
+ * \param pool The pool.
+ * \param index Slot index (0 .. 2^HANDLE_SLOT_BITS - 1).
+ *
+ * \return ConnectionSlot* The slot, or NULL.
+ *
+ * \note Safe without the owner's lock: chunks are published once and never move.
+ */
+static ConnectionSlot *slot_at(ConnectionPool *pool, int index)
+{
+    ConnectionSlot *chunk = atomic_load_explicit(&pool->chunks[index / POOL_CHUNK_SLOTS], memory_order_acquire);
+    return chunk ? &chunk[index % POOL_CHUNK_SLOTS] : NULL;
+}
+/**
+ * \brief Allocates one more chunk of slots and threads them onto the free list.
+ *
+ * \param pool The pool.
+ *
+ * \return bool true on success, false if the pool is at its maximum size or out of memory.
+ */
+static bool grow_pool(ConnectionPool *pool)
+{
+    if (pool->chunk_count >= POOL_MAX_CHUNKS)
+        return false;
+
+    ConnectionSlot *chunk = calloc(POOL_CHUNK_SLOTS, sizeof(ConnectionSlot));
+    if (!chunk)
+        return false;
+
+    int base = pool->chunk_count * POOL_CHUNK_SLOTS;
+    for (int i = POOL_CHUNK_SLOTS - 1; i >= 0; i--)
+    {
+        chunk[i].index = base + i;
+        atomic_init(&chunk[i].handle, -1);
+        chunk[i].next_free = pool->free_head;
+        pool->free_head = base + i;
+    }
+
+    atomic_store_explicit(&pool->chunks[pool->chunk_count], chunk, memory_order_release);
+    pool->chunk_count++;
+    return true;
+}
+/**
+ * \brief Initializes an empty connection pool.
+ *
+ * \param pool The pool to initialize.
+ * \param owner_index Index of the owning shard, encoded in every handle the pool publishes.
+ *
+ * \note Slots are allocated POOL_CHUNK_SLOTS at a time on first use.
+ */
+void connection_pool_init(ConnectionPool *pool, int owner_index)
+{
+    for (int i = 0; i < POOL_MAX_CHUNKS; i++)
+        atomic_init(&pool->chunks[i], NULL);
+    pool->chunk_count = 0;
+    pool->free_head = -1;
+    pool->used = 0;
+    pool->owner_index = owner_index;
+}
+/**
+ * \brief Frees every chunk and receive buffer of the pool.
+ *
+ * \param pool The pool. Nodes acquired from it must no longer be used.
+ */
+void connection_pool_destroy(ConnectionPool *pool)
+{
+    for (int c = 0; c < pool->chunk_count; c++)
+    {
+        ConnectionSlot *chunk = atomic_load(&pool->chunks[c]);
+        for (int i = 0; i < POOL_CHUNK_SLOTS; i++)
+            free(chunk[i].rx_buffer);
+        free(chunk);
+        atomic_store(&pool->chunks[c], NULL);
+    }
+    pool->chunk_count = 0;
+    pool->free_head = -1;
+    pool->used = 0;
+}
+/**
+ * \brief Takes a free slot and returns its zeroed node.
+ *
+ * \param pool The pool (owner's lock held).
+ *
+ * \return ConnectionNode* The node, with `connection.rx_buffer` pointing at the slot's
+ *         CONNECTION_RX_BUFFER_SIZE buffer, or NULL if the pool cannot grow.
+ *
+ * \note Released slots are reused first (LIFO), so a flapping sensor costs no allocation.
+ */
+ConnectionNode *connection_pool_acquire(ConnectionPool *pool)
+{
+    if (pool->free_head < 0 && !grow_pool(pool))
+        return NULL;
+
+    ConnectionSlot *slot = slot_at(pool, pool->free_head);
+    if (!slot->rx_buffer && !(slot->rx_buffer = malloc(CONNECTION_RX_BUFFER_SIZE)))
+        return NULL;
+
+    pool->free_head = slot->next_free;
+    slot->next_free = -1;
+    pool->used++;
+
+    memset(&slot->node, 0, sizeof(slot->node));
+    slot->node.connection.rx_buffer = slot->rx_buffer;
+    slot->node.connection.sensor_id = -1;
+    return &slot->node;
+}
+/**
+ * \brief Returns a node to the pool and invalidates its handle.
+ *
+ * \param pool The pool (owner's lock held).
+ * \param node A node obtained from connection_pool_acquire().
+ */
+void connection_pool_release(ConnectionPool *pool, ConnectionNode *node)
+{
+    ConnectionSlot *slot = (ConnectionSlot *)node;
+
+    atomic_store_explicit(&slot->handle, -1, memory_order_release);
+    slot->generation = (slot->generation + 1) & ((1u << HANDLE_GENERATION_BITS) - 1);
+    slot->next_free = pool->free_head;
+    pool->free_head = slot->index;
+    pool->used--;
+}
+/**
+ * \brief Makes a node reachable by handle and returns that handle.
+ *
+ * \param pool The pool (owner's lock held).
+ * \param node A node obtained from connection_pool_acquire().
+ *
+ * \return int The handle: (generation, slot index, owner index) packed in a non-negative int.
+ */
+int connection_pool_publish(ConnectionPool *pool, ConnectionNode *node)
+{
+    ConnectionSlot *slot = (ConnectionSlot *)node;
+    int handle = (int)((slot->generation << (HANDLE_SHARD_BITS + HANDLE_SLOT_BITS)) |
+                       ((uint32_t)slot->index << HANDLE_SHARD_BITS) | (uint32_t)pool->owner_index);
+
+    atomic_store_explicit(&slot->handle, handle, memory_order_release);
+    return handle;
+}
+/**
+ * \brief Finds the node a handle refers to.
+ *
+ * \param pool The pool (owner's lock held while the node is used).
+ * \param handle A sensor handle.
+ *
+ * \return ConnectionNode* The node, or NULL if the handle is stale or invalid.
+ */
+ConnectionNode *connection_pool_lookup(ConnectionPool *pool, int handle)
+{
+    if (handle < 0 || HANDLE_SHARD(handle) != pool->owner_index)
+        return NULL;
+
+    ConnectionSlot *slot = slot_at(pool, HANDLE_SLOT(handle));
+    if (!slot || atomic_load_explicit(&slot->handle, memory_order_acquire) != handle)
+        return NULL;
+    return &slot->node;
+}
+/**
+ * \brief Tells whether a handle still refers to a live connection.
+ *
+ * \param pool The pool.
+ * \param handle A sensor handle.
+ *
+ * \return bool true if the connection is established and has not been released since.
+ *
+ * \note Lock-free: one atomic load of the slot's current handle, usable from any thread.
+ */
+bool connection_pool_is_live(ConnectionPool *pool, int handle)
+{
+    return connection_pool_lookup(pool, handle) != NULL;
+}
@@ -0,0 +1,23 @@
+#ifndef POOL_H
+#define POOL_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                     EXPORTED TYPES and DEFINITIONS                         */
+/******************************************************************************/
+#define HANDLE_SHARD(handle) ((handle) & ((1 << HANDLE_SHARD_BITS) - 1))
+#define HANDLE_SLOT(handle) (((handle) >> HANDLE_SHARD_BITS) & ((1 << HANDLE_SLOT_BITS) - 1))
+#define HANDLE_GENERATION(handle) ((handle) >> (HANDLE_SHARD_BITS + HANDLE_SLOT_BITS))
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+void connection_pool_init(ConnectionPool *pool, int owner_index);
+void connection_pool_destroy(ConnectionPool *pool);
+ConnectionNode *connection_pool_acquire(ConnectionPool *pool);
+void connection_pool_release(ConnectionPool *pool, ConnectionNode *node);
+int connection_pool_publish(ConnectionPool *pool, ConnectionNode *node);
+ConnectionNode *connection_pool_lookup(ConnectionPool *pool, int handle);
+bool connection_pool_is_live(ConnectionPool *pool, int handle);
+#endif // POOL_H
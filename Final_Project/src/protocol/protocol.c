@@ -0,0 +1,136 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "protocol.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/*---------------Big-endian field helpers---------------------------------------------------*/
+/**
+ * \brief Reads a big-endian 16-bit field.
+ */
+static uint16_t read_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+/**
+ * \brief Reads a big-endian 32-bit field.
+ */
+static uint32_t read_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+/**
+ * \brief Writes a big-endian 16-bit field.
+ */
+static void write_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+/**
+ * \brief Writes a big-endian 32-bit field.
+ */
+static void write_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+/*-----------------------------------------------------------------------------------------*/
+/**
+ * \brief Returns the total size of the frame that starts at `buffer`.
+ *
+ * \param buffer Bytes received so far for the frame.
+ * \param available Number of bytes in `buffer`.
+ *
+ * \return int Total frame size including the length prefix, 0 if the prefix is not complete yet,
+ *         -1 if the announced length can never be a valid frame.
+ */
+int protocol_frame_size(const uint8_t *buffer, size_t available)
+{
+    if (available < PROTOCOL_LENGTH_FIELD_SIZE)
+        return 0;
+
+    size_t total = PROTOCOL_LENGTH_FIELD_SIZE + read_u16(buffer);
+    if (total < PROTOCOL_HEADER_SIZE + PROTOCOL_READING_SIZE || total > PROTOCOL_MAX_FRAME_SIZE ||
+        (total - PROTOCOL_HEADER_SIZE) % PROTOCOL_READING_SIZE != 0)
+        return -1;
+
+    return (int)total;
+}
+/**
+ * \brief Decodes one measurement frame.
+ *
+ * \param buffer Bytes starting at the frame's length prefix.
+ * \param length Number of bytes available in `buffer`.
+ * \param frame Output: the decoded frame.
+ *
+ * \return int Number of bytes consumed, 0 if the frame is not complete yet,
+ *         -1 if the frame is malformed (the stream can no longer be trusted).
+ *
+ * \note The reading count must agree with the length prefix and the version must be PROTOCOL_VERSION.
+ */
+int protocol_decode_frame(const uint8_t *buffer, size_t length, MeasurementFrame *frame)
+{
+    int total = protocol_frame_size(buffer, length);
+    if (total <= 0)
+        return total;
+    if (length < (size_t)total)
+        return 0;
+
+    frame->version = buffer[2];
+    frame->count = buffer[3];
+    frame->sequence = read_u32(buffer + 4);
+    frame->base_timestamp = read_u32(buffer + 8);
+
+    if (frame->version != PROTOCOL_VERSION || frame->count == 0 || frame->count > PROTOCOL_MAX_READINGS ||
+        PROTOCOL_HEADER_SIZE + frame->count * PROTOCOL_READING_SIZE != total)
+        return -1;
+
+    const uint8_t *p = buffer + PROTOCOL_HEADER_SIZE;
+    for (int i = 0; i < frame->count; i++, p += PROTOCOL_READING_SIZE)
+    {
+        uint32_t bits = read_u32(p + 2);
+        frame->readings[i].offset = read_u16(p);
+        memcpy(&frame->readings[i].temperature, &bits, sizeof(float));
+    }
+
+    return total;
+}
+/**
+ * \brief Encodes a measurement frame into its wire format.
+ *
+ * \param frame The frame to encode (count must be 1..PROTOCOL_MAX_READINGS).
+ * \param buffer Output buffer.
+ * \param buffer_size Size of `buffer`.
+ *
+ * \return size_t Number of bytes written, 0 if the frame is invalid or does not fit.
+ */
+size_t protocol_encode_frame(const MeasurementFrame *frame, uint8_t *buffer, size_t buffer_size)
+{
+    if (frame->count == 0 || frame->count > PROTOCOL_MAX_READINGS)
+        return 0;
+
+    size_t total = PROTOCOL_HEADER_SIZE + (size_t)frame->count * PROTOCOL_READING_SIZE;
+    if (total > buffer_size)
+        return 0;
+
+    write_u16(buffer, (uint16_t)(total - PROTOCOL_LENGTH_FIELD_SIZE));
+    buffer[2] = PROTOCOL_VERSION;
+    buffer[3] = frame->count;
+    write_u32(buffer + 4, frame->sequence);
+    write_u32(buffer + 8, frame->base_timestamp);
+
+    uint8_t *p = buffer + PROTOCOL_HEADER_SIZE;
+    for (int i = 0; i < frame->count; i++, p += PROTOCOL_READING_SIZE)
+    {
+        uint32_t bits;
+        memcpy(&bits, &frame->readings[i].temperature, sizeof(float));
+        write_u16(p, frame->readings[i].offset);
+        write_u32(p + 2, bits);
+    }
+
+    return total;
+}
@@ -0,0 +1,13 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+int protocol_frame_size(const uint8_t *buffer, size_t available);
+int protocol_decode_frame(const uint8_t *buffer, size_t length, MeasurementFrame *frame);
+size_t protocol_encode_frame(const MeasurementFrame *frame, uint8_t *buffer, size_t buffer_size);
+#endif // PROTOCOL_H
@@ -0,0 +1,164 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "ring.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Raises the ring's high-water mark to `occupancy` if it is higher.
+ *
+ * \param ring The ring.
+ * \param occupancy Number of readings queued right after a push.
+ */
+static void update_high_water_mark(ReadingRing *ring, size_t occupancy)
+{
+    size_t seen = atomic_load_explicit(&ring->high_water_mark, memory_order_relaxed);
+    while (occupancy > seen &&
+           !atomic_compare_exchange_weak_explicit(&ring->high_water_mark, &seen, occupancy,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+/**
+ * \brief Initializes an empty ring.
+ *
+ * \param ring The ring to initialize.
+ * \param capacity Number of cells, must be a power of two.
+ *
+ * \return bool true on success, false if the capacity is invalid or out of memory.
+ */
+bool ring_init(ReadingRing *ring, size_t capacity)
+{
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+        return false;
+
+    ring->cells = calloc(capacity, sizeof(ReadingRingCell));
+    if (!ring->cells)
+        return false;
+
+    for (size_t i = 0; i < capacity; i++)
+        atomic_init(&ring->cells[i].sequence, i);
+
+    ring->mask = capacity - 1;
+    atomic_init(&ring->enqueue_pos, 0);
+    atomic_init(&ring->dequeue_pos, 0);
+    atomic_init(&ring->high_water_mark, 0);
+    atomic_init(&ring->overflows, 0);
+    return true;
+}
+/**
+ * \brief Frees the ring's cells. Readings still queued are discarded.
+ *
+ * \param ring The ring.
+ */
+void ring_destroy(ReadingRing *ring)
+{
+    free(ring->cells);
+    ring->cells = NULL;
+    ring->mask = 0;
+}
+/**
+ * \brief Queues a reading. Safe to call from any number of threads at once.
+ *
+ * \param ring The ring.
+ * \param data The reading to copy into the ring.
+ *
+ * \return size_t Number of readings queued after this one was added (1..capacity), or 0 if the ring was full.
+ *
+ * \note Never blocks: when the ring is full the reading is dropped and counted in `overflows`.
+ *       The occupancy is read after the cell is published, so the consumer may already have taken this
+ *       reading and later ones; it is then clamped to 1, never reported as 0 (full) or wrapped around.
+ */
+size_t ring_push(ReadingRing *ring, const SensorData *data)
+{
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    ReadingRingCell *cell;
+
+    for (;;)
+    {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            atomic_fetch_add_explicit(&ring->overflows, 1, memory_order_relaxed);
+            return 0;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    cell->data = *data;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+
+    intptr_t queued = (intptr_t)(pos + 1 - atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed));
+    size_t occupancy = queued < 1 ? 1 : (size_t)queued;
+    if (occupancy > ring->mask + 1)
+        occupancy = ring->mask + 1;
+    update_high_water_mark(ring, occupancy);
+    return occupancy;
+}
+/**
+ * \brief Takes up to `max` readings from the front of the ring.
+ *
+ * \param ring The ring.
+ * \param out Destination array of at least `max` readings.
+ * \param max Maximum number of readings to take.
+ *
+ * \return size_t Number of readings copied to `out`.
+ *
+ * \note Single consumer only. Stops early at a cell a producer has claimed but not yet filled.
+ */
+size_t ring_pop_batch(ReadingRing *ring, SensorData *out, size_t max)
+{
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    size_t n = 0;
+
+    while (n < max)
+    {
+        ReadingRingCell *cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        if (seq != pos + 1)
+            break;
+
+        out[n++] = cell->data;
+        atomic_store_explicit(&cell->sequence, pos + ring->mask + 1, memory_order_release);
+        pos++;
+    }
+
+    atomic_store_explicit(&ring->dequeue_pos, pos, memory_order_relaxed);
+    return n;
+}
+/**
+ * \brief Returns the number of readings currently queued.
+ *
+ * \param ring The ring.
+ *
+ * \return size_t Queued readings (a snapshot; producers may be adding more).
+ */
+size_t ring_size(ReadingRing *ring)
+{
+    size_t dequeue = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    size_t enqueue = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+}
+/**
+ * \brief Returns the number of cells of the ring.
+ *
+ * \param ring The ring.
+ *
+ * \return size_t Capacity.
+ */
+size_t ring_capacity(const ReadingRing *ring)
+{
+    return ring->mask + 1;
+}
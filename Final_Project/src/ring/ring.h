@@ -0,0 +1,16 @@
+#ifndef RING_H
+#define RING_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+bool ring_init(ReadingRing *ring, size_t capacity);
+void ring_destroy(ReadingRing *ring);
+size_t ring_push(ReadingRing *ring, const SensorData *data);
+size_t ring_pop_batch(ReadingRing *ring, SensorData *out, size_t max);
+size_t ring_size(ReadingRing *ring);
+size_t ring_capacity(const ReadingRing *ring);
+#endif // RING_H
@@ -0,0 +1,414 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "rollup.h"
+#include "../partition/partition.h"
+/******************************************************************************/
+/*                     LOCAL TYPES and DEFINITIONS                            */
+/******************************************************************************/
+// aggregate of one sensor over one bucket, built while scanning a sorted batch
+typedef struct
+{
+    int sensor_id;
+    int bucket; // first second of the bucket, meaningful once aggregate.count > 0
+    RollupAggregate aggregate;
+} RollupBucket;
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns the first second of the bucket of `width` seconds containing a timestamp.
+ *
+ * \param timestamp Epoch seconds, may be negative.
+ * \param width Bucket width in seconds.
+ *
+ * \return long long The bucket start, rounded towards minus infinity.
+ */
+static long long bucket_floor(long long timestamp, long long width)
+{
+    long long bucket = timestamp / width;
+    if (timestamp < 0 && timestamp % width != 0)
+        bucket--;
+    return bucket * width;
+}
+/**
+ * \brief Returns the first bucket boundary at or after a timestamp.
+ *
+ * \param timestamp Epoch seconds, may be negative.
+ * \param width Bucket width in seconds.
+ *
+ * \return long long The boundary.
+ */
+static long long bucket_ceil(long long timestamp, long long width)
+{
+    long long floor = bucket_floor(timestamp, width);
+    return floor == timestamp ? floor : floor + width;
+}
+/**
+ * \brief Creates a rollup table if it does not exist.
+ *
+ * \param db The writer's database handle.
+ * \param table The table name: `sensor_rollup_hour` or the `<partition>_minute` of a day partition.
+ *
+ * \return bool true on success, false otherwise.
+ *
+ * \note One row per (sensor, bucket) keyed WITHOUT ROWID, so a range of buckets of one sensor is a
+ *       single primary key range scan. The sensor is its reported port, so a series continues across
+ *       reconnects. `last_timestamp` decides which `last` wins when rows of a bucket arrive out of order
+ *       or across batches.
+ */
+bool rollup_create_table(sqlite3 *db, const char *table)
+{
+    char sql[320];
+    snprintf(sql, sizeof(sql), "CREATE TABLE IF NOT EXISTS %s "
+                               "(sensor_id INTEGER NOT NULL, bucket INTEGER NOT NULL, count INTEGER NOT NULL, "
+                               "sum REAL NOT NULL, min REAL NOT NULL, max REAL NOT NULL, last REAL NOT NULL, "
+                               "last_timestamp INTEGER NOT NULL, PRIMARY KEY (sensor_id, bucket)) WITHOUT ROWID",
+             table);
+    return sqlite3_exec(db, sql, NULL, NULL, NULL) == SQLITE_OK;
+}
+/**
+ * \brief Prepares the statement merging one bucket aggregate into a rollup table.
+ *
+ * \param db The writer's database handle.
+ * \param table The rollup table.
+ *
+ * \return sqlite3_stmt* The statement, or NULL on failure.
+ *
+ * \note Parameters: sensor_id, bucket, count, sum, min, max, last, last_timestamp.
+ */
+sqlite3_stmt *rollup_prepare_upsert(sqlite3 *db, const char *table)
+{
+    char sql[512];
+    sqlite3_stmt *stmt;
+
+    snprintf(sql, sizeof(sql), "INSERT INTO %s (sensor_id, bucket, count, sum, min, max, last, last_timestamp) "
+                               "VALUES (?, ?, ?, ?, ?, ?, ?, ?) ON CONFLICT(sensor_id, bucket) DO UPDATE SET "
+                               "count = count + excluded.count, sum = sum + excluded.sum, "
+                               "min = MIN(min, excluded.min), max = MAX(max, excluded.max), "
+                               "last = CASE WHEN excluded.last_timestamp >= last_timestamp "
+                               "THEN excluded.last ELSE last END, "
+                               "last_timestamp = MAX(last_timestamp, excluded.last_timestamp)",
+             table);
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+        return NULL;
+    return stmt;
+}
+/**
+ * \brief Orders readings by sensor, then time.
+ */
+static int compare_readings(const void *a, const void *b)
+{
+    const SensorData *left = a;
+    const SensorData *right = b;
+
+    if (left->sensor_id != right->sensor_id)
+        return left->sensor_id < right->sensor_id ? -1 : 1;
+    if (left->timestamp != right->timestamp)
+        return left->timestamp < right->timestamp ? -1 : 1;
+    return 0;
+}
+/**
+ * \brief Sorts a batch by sensor and time so each bucket of each sensor is one contiguous run.
+ *
+ * \param batch The readings.
+ * \param count Number of readings in `batch`.
+ *
+ * \note Rows are then also inserted in (sensor_id, timestamp) order, the order of the per-sensor index.
+ */
+void rollup_sort_batch(SensorData *batch, int count)
+{
+    qsort(batch, count, sizeof(SensorData), compare_readings);
+}
+/**
+ * \brief Adds one value observed at `timestamp` to an aggregate.
+ */
+static void aggregate_add(RollupAggregate *aggregate, double value, int timestamp)
+{
+    if (aggregate->count == 0 || value < aggregate->min)
+        aggregate->min = value;
+    if (aggregate->count == 0 || value > aggregate->max)
+        aggregate->max = value;
+    if (aggregate->count == 0 || timestamp >= aggregate->last_timestamp)
+    {
+        aggregate->last = value;
+        aggregate->last_timestamp = timestamp;
+    }
+    aggregate->count++;
+    aggregate->sum += value;
+}
+/**
+ * \brief Merges an aggregate into another one.
+ */
+static void aggregate_merge(RollupAggregate *into, const RollupAggregate *from)
+{
+    if (from->count == 0)
+        return;
+    if (into->count == 0 || from->min < into->min)
+        into->min = from->min;
+    if (into->count == 0 || from->max > into->max)
+        into->max = from->max;
+    if (into->count == 0 || from->last_timestamp >= into->last_timestamp)
+    {
+        into->last = from->last;
+        into->last_timestamp = from->last_timestamp;
+    }
+    into->count += from->count;
+    into->sum += from->sum;
+}
+/**
+ * \brief Writes an accumulated bucket through a rollup UPSERT and empties it.
+ *
+ * \param stmt The UPSERT of the bucket's table.
+ * \param bucket The accumulated bucket; nothing is written if it is empty.
+ *
+ * \return bool true on success, false otherwise.
+ */
+static bool flush_bucket(sqlite3_stmt *stmt, RollupBucket *bucket)
+{
+    if (bucket->aggregate.count == 0)
+        return true;
+
+    const RollupAggregate *aggregate = &bucket->aggregate;
+    sqlite3_reset(stmt);
+    sqlite3_bind_int(stmt, 1, bucket->sensor_id);
+    sqlite3_bind_int(stmt, 2, bucket->bucket);
+    sqlite3_bind_int64(stmt, 3, aggregate->count);
+    sqlite3_bind_double(stmt, 4, aggregate->sum);
+    sqlite3_bind_double(stmt, 5, aggregate->min);
+    sqlite3_bind_double(stmt, 6, aggregate->max);
+    sqlite3_bind_double(stmt, 7, aggregate->last);
+    sqlite3_bind_int(stmt, 8, aggregate->last_timestamp);
+    bool written = sqlite3_step(stmt) == SQLITE_DONE;
+
+    memset(bucket, 0, sizeof(*bucket));
+    return written;
+}
+/**
+ * \brief Folds a committed batch into the minute and hour rollups.
+ *
+ * \param partitions The writer's partition cache, which owns the minute rollup statements.
+ * \param hour_stmt The UPSERT of sensor_rollup_hour.
+ * \param db The writer's database handle.
+ * \param batch The readings, sorted with rollup_sort_batch().
+ * \param count Number of readings in `batch`.
+ * \param first_kept_day Readings of older days are outside the retention window and skipped.
+ *
+ * \return bool true on success, false otherwise.
+ *
+ * \note Must run inside the transaction that inserts the batch, so rollups never disagree with the raw
+ *       rows. One pass over the batch: each (sensor, minute) and (sensor, hour) run becomes one UPSERT,
+ *       so a batch of N readings from S sensors costs about S * minutes + S * hours writes, not N.
+ */
+bool rollup_apply_batch(PartitionWriterCache *partitions, sqlite3_stmt *hour_stmt, sqlite3 *db,
+                        const SensorData *batch, int count, int first_kept_day)
+{
+    RollupBucket minute = {0};
+    RollupBucket hour = {0};
+    sqlite3_stmt *minute_stmt = NULL;
+
+    for (int i = 0; i < count; i++)
+    {
+        const SensorData *data = &batch[i];
+        if (partition_day(data->timestamp) < first_kept_day)
+            continue;
+
+        int minute_bucket = (int)bucket_floor(data->timestamp, ROLLUP_MINUTE_SECONDS);
+        int hour_bucket = (int)bucket_floor(data->timestamp, ROLLUP_HOUR_SECONDS);
+
+        if (minute.aggregate.count > 0 && (minute.sensor_id != data->sensor_id || minute.bucket != minute_bucket))
+        {
+            if (!flush_bucket(minute_stmt, &minute))
+                return false;
+        }
+        if (hour.aggregate.count > 0 && (hour.sensor_id != data->sensor_id || hour.bucket != hour_bucket))
+        {
+            if (!flush_bucket(hour_stmt, &hour))
+                return false;
+        }
+
+        if (minute.aggregate.count == 0)
+        {
+            // the statement belongs to this minute's partition; look it up once per run
+            minute_stmt = partition_minute_rollup(partitions, db, partition_day(data->timestamp));
+            if (minute_stmt == NULL)
+                return false;
+            minute.sensor_id = data->sensor_id;
+            minute.bucket = minute_bucket;
+        }
+        if (hour.aggregate.count == 0)
+        {
+            hour.sensor_id = data->sensor_id;
+            hour.bucket = hour_bucket;
+        }
+        aggregate_add(&minute.aggregate, data->temperature, data->timestamp);
+        aggregate_add(&hour.aggregate, data->temperature, data->timestamp);
+    }
+
+    if (minute.aggregate.count > 0 && !flush_bucket(minute_stmt, &minute))
+        return false;
+    return hour.aggregate.count == 0 || flush_bucket(hour_stmt, &hour);
+}
+/**
+ * \brief Tells whether a table exists.
+ *
+ * \param db A database handle.
+ * \param table The table name.
+ *
+ * \return bool true if the table exists.
+ */
+static bool table_exists(sqlite3 *db, const char *table)
+{
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?",
+                           -1, &stmt, NULL) != SQLITE_OK)
+        return false;
+    sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+    bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return exists;
+}
+/**
+ * \brief Merges the buckets [from, to) of one sensor from a rollup table.
+ *
+ * \param db The reader's database handle.
+ * \param table The rollup table; a missing table holds no rows.
+ * \param sensor_id The sensor.
+ * \param from First bucket, inclusive.
+ * \param to Last bucket, exclusive.
+ * \param aggregate Output: the rows are merged into it.
+ * \param rows Output: incremented by the number of rows read.
+ *
+ * \return bool true on success, false otherwise.
+ */
+static bool read_rollup(sqlite3 *db, const char *table, int sensor_id, long long from, long long to,
+                        RollupAggregate *aggregate, int *rows)
+{
+    char sql[256];
+    sqlite3_stmt *stmt;
+
+    if (from >= to || !table_exists(db, table))
+        return true;
+
+    snprintf(sql, sizeof(sql), "SELECT count, sum, min, max, last, last_timestamp FROM %s "
+                               "WHERE sensor_id = ? AND bucket >= ? AND bucket < ?",
+             table);
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+        return false;
+    sqlite3_bind_int(stmt, 1, sensor_id);
+    sqlite3_bind_int64(stmt, 2, from);
+    sqlite3_bind_int64(stmt, 3, to);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        RollupAggregate bucket = {
+            .count = (long)sqlite3_column_int64(stmt, 0),
+            .sum = sqlite3_column_double(stmt, 1),
+            .min = sqlite3_column_double(stmt, 2),
+            .max = sqlite3_column_double(stmt, 3),
+            .last = sqlite3_column_double(stmt, 4),
+            .last_timestamp = sqlite3_column_int(stmt, 5),
+        };
+        aggregate_merge(aggregate, &bucket);
+        (*rows)++;
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+/**
+ * \brief Adds one decoded reading to an aggregate (ReadingVisitor).
+ */
+static void add_raw_reading(const SensorData *data, long id, void *arg)
+{
+    (void)id;
+    aggregate_add(arg, data->temperature, data->timestamp);
+}
+/**
+ * \brief Aggregates the raw readings of one sensor over [from, to), a range inside one day partition.
+ *
+ * \return bool true on success, false otherwise.
+ *
+ * \note Only ever asked for less than a minute at each end of a query; only the chunks of the sensor
+ *       overlapping the range are decoded.
+ */
+static bool read_raw(sqlite3 *db, int sensor_id, long long from, long long to,
+                     RollupAggregate *aggregate, int *rows)
+{
+    char table[STORAGE_PARTITION_NAME_SIZE];
+
+    if (from >= to)
+        return true;
+    partition_table_name(partition_day((int)from), table, sizeof(table));
+    if (!table_exists(db, table))
+        return true;
+
+    ReadingQuery query = {.sensor_id = sensor_id, .from = (int)from, .to = (int)(to - 1)};
+    ReadingCursor after = {(int)from, -1};
+    int read = partition_read_page(db, table, &query, &after, INT_MAX, add_raw_reading, aggregate);
+    if (read < 0)
+        return false;
+    *rows += read;
+    return true;
+}
+/**
+ * \brief Aggregates [from, to), a range inside one hour, from the minute rollup and the raw rows.
+ *
+ * \return bool true on success, false otherwise.
+ */
+static bool query_minutes(sqlite3 *db, int sensor_id, long long from, long long to,
+                          RollupAggregate *aggregate, RollupQueryStats *stats)
+{
+    if (from >= to)
+        return true;
+
+    long long first = bucket_ceil(from, ROLLUP_MINUTE_SECONDS);
+    long long last = bucket_floor(to, ROLLUP_MINUTE_SECONDS);
+    if (first >= last) // no whole minute: at most one boundary splits the range
+        first = last = first < to ? first : to;
+
+    char partition[STORAGE_PARTITION_NAME_SIZE];
+    char table[STORAGE_PARTITION_NAME_SIZE + 8];
+    partition_table_name(partition_day((int)from), partition, sizeof(partition));
+    snprintf(table, sizeof(table), "%s_minute", partition);
+
+    return read_raw(db, sensor_id, from, first, aggregate, &stats->raw_rows) &&
+           read_rollup(db, table, sensor_id, first, last, aggregate, &stats->minute_rows) &&
+           read_raw(db, sensor_id, last, to, aggregate, &stats->raw_rows);
+}
+/**
+ * \brief Aggregates the readings of one sensor over a time range at the coarsest resolution that fits.
+ *
+ * \param db The reader's database handle.
+ * \param sensor_id The sensor.
+ * \param from Start of the range, inclusive.
+ * \param to End of the range, inclusive.
+ * \param aggregate Output: count, sum, min, max and last value; count is 0 if there is no reading.
+ * \param stats Output: rows read at each resolution.
+ *
+ * \return bool true on success, false otherwise.
+ *
+ * \note Whole hours come from sensor_rollup_hour, the whole minutes left at each end from the minute
+ *       rollup of their partition, and only the seconds left before the first and after the last whole
+ *       minute from raw rows. A query over a month reads ~720 hour rows plus at most ~120 minute rows
+ *       and two minutes of readings, whatever the sampling rate. Hour rollups are not dropped by the
+ *       retention policy, so whole hours stay answerable after their raw partition is gone.
+ */
+bool rollup_query(sqlite3 *db, int sensor_id, int from, int to, RollupAggregate *aggregate, RollupQueryStats *stats)
+{
+    memset(aggregate, 0, sizeof(*aggregate));
+    memset(stats, 0, sizeof(*stats));
+    if (from > to)
+        return true;
+
+    long long start = from;
+    long long end = (long long)to + 1; // half-open from here on
+    long long first = bucket_ceil(start, ROLLUP_HOUR_SECONDS);
+    long long last = bucket_floor(end, ROLLUP_HOUR_SECONDS);
+    if (first >= last) // no whole hour: at most one boundary splits the range
+        first = last = first < end ? first : end;
+
+    return query_minutes(db, sensor_id, start, first, aggregate, stats) &&
+           read_rollup(db, ROLLUP_HOUR_TABLE, sensor_id, first, last, aggregate, &stats->hour_rows) &&
+           query_minutes(db, sensor_id, last, end, aggregate, stats);
+}
@@ -0,0 +1,22 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                     EXPORTED TYPES and DEFINITIONS                         */
+/******************************************************************************/
+#define ROLLUP_HOUR_TABLE "sensor_rollup_hour"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+bool rollup_create_table(sqlite3 *db, const char *table);
+sqlite3_stmt *rollup_prepare_upsert(sqlite3 *db, const char *table);
+
+void rollup_sort_batch(SensorData *batch, int count);
+bool rollup_apply_batch(PartitionWriterCache *partitions, sqlite3_stmt *hour_stmt, sqlite3 *db,
+                        const SensorData *batch, int count, int first_kept_day);
+
+bool rollup_query(sqlite3 *db, int sensor_id, int from, int to, RollupAggregate *aggregate, RollupQueryStats *stats);
+#endif // ROLLUP_H
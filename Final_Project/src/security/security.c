@@ -15,7 +15,8 @@
  * \param data Data to be sent over the connection.
  * \param len Length of the data to send.
  *
- * \return The number of bytes written on success, -1 on failure.
+ * \return The number of bytes written on success, SECURE_IO_WANT_READ/SECURE_IO_WANT_WRITE
+ *         when a non-blocking socket is not ready, -1 on failure.
  */
 static int ssl_send(void *self, const char *data, size_t len)
 {
@@ -24,6 +25,10 @@ static int ssl_send(void *self, const char *data, size_t len)
     if (ret <= 0)
     {
         int err = SSL_get_error(conn->ssl, ret);
+        if (err == SSL_ERROR_WANT_READ)
+            return SECURE_IO_WANT_READ;
+        if (err == SSL_ERROR_WANT_WRITE)
+            return SECURE_IO_WANT_WRITE;
         fprintf(stderr, "SSL_write failed: %d\n", err);
         ERR_print_errors_fp(stderr);
         return -1;
@@ -40,7 +45,9 @@ static int ssl_send(void *self, const char *data, size_t len)
  * \param buffer Buffer to store the received data.
  * \param len Maximum length of data to receive.
  *
- * \return The number of bytes read on success, -1 on failure.
+ * \return The number of bytes read on success, 0 if the peer closed the session,
+ *         SECURE_IO_WANT_READ/SECURE_IO_WANT_WRITE when a non-blocking socket is not ready,
+ *         -1 on failure.
  */
 static int ssl_recv(void *self, char *buffer, size_t len)
 {
@@ -49,12 +56,50 @@ static int ssl_recv(void *self, char *buffer, size_t len)
     if (ret <= 0)
     {
         int err = SSL_get_error(conn->ssl, ret);
+        if (err == SSL_ERROR_WANT_READ)
+            return SECURE_IO_WANT_READ;
+        if (err == SSL_ERROR_WANT_WRITE)
+            return SECURE_IO_WANT_WRITE;
+        if (err == SSL_ERROR_ZERO_RETURN)
+            return 0; // peer sent close_notify
         fprintf(stderr, "SSL_read failed: %d\n", err);
         ERR_print_errors_fp(stderr);
         return -1;
     }
     return ret;
 }
+/**
+ * \brief Runs (or resumes) the TLS handshake of an SSL connection.
+ *
+ * On a non-blocking socket this returns as soon as OpenSSL needs more data from
+ * the peer or room in the send buffer, so the caller can wait for the matching
+ * epoll event and call it again.
+ *
+ * \param self Pointer to the SSLConnection instance.
+ *
+ * \return 0 when the handshake is complete, SECURE_IO_WANT_READ/SECURE_IO_WANT_WRITE
+ *         when it must be resumed later, -1 on failure.
+ */
+static int ssl_handshake(void *self)
+{
+    SSLConnection *conn = (SSLConnection *)self;
+    int ret = SSL_do_handshake(conn->ssl);
+    if (ret == 1)
+    {
+        printf("[SSL %s] Handshake success\n", SSL_is_server(conn->ssl) ? "SERVER" : "CLIENT");
+        return 0;
+    }
+
+    int err = SSL_get_error(conn->ssl, ret);
+    if (err == SSL_ERROR_WANT_READ)
+        return SECURE_IO_WANT_READ;
+    if (err == SSL_ERROR_WANT_WRITE)
+        return SECURE_IO_WANT_WRITE;
+
+    fprintf(stderr, "SSL handshake failed: %d\n", err);
+    ERR_print_errors_fp(stderr); // In chi tiết lỗi SSL
+    return -1;
+}
 /**
  * \brief Closes an SSL connection and frees associated resources.
  *
@@ -70,8 +115,8 @@ void ssl_close(void *impl)
     SSLConnection *ssl_conn = (SSLConnection *)impl;
     if (ssl_conn)
     {
-        // call SSL_shutdown make sure SSL close
-        int shutdown_ret = SSL_shutdown(ssl_conn->ssl);
+        // call SSL_shutdown make sure SSL close (not allowed before the handshake finished)
+        int shutdown_ret = SSL_is_init_finished(ssl_conn->ssl) ? SSL_shutdown(ssl_conn->ssl) : 1;
         if (shutdown_ret == 0)
         {
             SSL_shutdown(ssl_conn->ssl);
@@ -79,8 +124,12 @@ void ssl_close(void *impl)
         else if (shutdown_ret < 0)
         {
             int err = SSL_get_error(ssl_conn->ssl, shutdown_ret);
-            fprintf(stderr, "SSL_shutdown failed: %d\n", err);
-            ERR_print_errors_fp(stderr);
+            if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE)
+            {
+                fprintf(stderr, "SSL_shutdown failed: %d\n", err);
+                ERR_print_errors_fp(stderr);
+            }
+            ERR_clear_error();
         }
 
         SSL_free(ssl_conn->ssl); // free ssl
@@ -98,7 +147,8 @@ void ssl_close(void *impl)
  * \param data Data to be sent.
  * \param len Length of the data.
  *
- * \return The number of bytes written on success, -1 on failure.
+ * \return The number of bytes written on success, SECURE_IO_WANT_WRITE if a non-blocking
+ *         socket is full, -1 on failure.
  */
 static int plain_send(void *self, const char *data, size_t len)
 {
@@ -106,6 +156,8 @@ static int plain_send(void *self, const char *data, size_t len)
     ssize_t ret = write(conn->fd, data, len);
     if (ret < 0)
     {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return SECURE_IO_WANT_WRITE;
         perror("write failed");
         return -1;
     }
@@ -121,7 +173,8 @@ static int plain_send(void *self, const char *data, size_t len)
  * \param buffer Buffer to store received data.
  * \param len Maximum length of data to receive.
  *
- * \return The number of bytes read on success, -1 on failure.
+ * \return The number of bytes read on success, SECURE_IO_WANT_READ if a non-blocking
+ *         socket has no data, -1 on failure.
  */
 static int plain_recv(void *self, char *buffer, size_t len)
 {
@@ -129,11 +182,25 @@ static int plain_recv(void *self, char *buffer, size_t len)
     ssize_t ret = read(conn->fd, buffer, len);
     if (ret < 0)
     {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return SECURE_IO_WANT_READ;
         perror("read failed");
         return -1;
     }
     return ret;
 }
+/**
+ * \brief Handshake of a plain (non-SSL) connection: there is nothing to negotiate.
+ *
+ * \param self Pointer to the PlainConnection instance (unused).
+ *
+ * \return Always 0.
+ */
+static int plain_handshake(void *self)
+{
+    (void)self;
+    return 0;
+}
 /**
  * \brief Closes a plain (non-SSL) connection and frees associated resources.
  *
@@ -153,18 +220,18 @@ static void plain_close(void *impl)
     }
 }
 /**
- * \brief Creates an SSL server connection.
+ * \brief Creates an SSL connection object without running the handshake.
  *
- * This function initializes a new SSL connection on the server side, performing
- * the SSL handshake using SSL_accept. It returns a pointer to the SSLConnection
- * instance on success, or NULL if the handshake fails.
+ * The SSL object is put in accept (server) or connect (client) state; the
+ * handshake itself is driven by ssl_handshake().
  *
- * \param fd The file descriptor for the server socket.
- * \param ctx The SSL context for the server.
+ * \param fd The file descriptor of the connected socket.
+ * \param ctx The SSL context (server or client).
+ * \param mode SECURE_SSL_SERVER or SECURE_SSL_CLIENT.
  *
  * \return Pointer to an SSLConnection instance or NULL on failure.
  */
-static SSLConnection *ssl_connection_create_server(int fd, SSL_CTX *ctx)
+static SSLConnection *ssl_connection_create(int fd, SSL_CTX *ctx, SecureMode mode)
 {
     SSLConnection *conn = malloc(sizeof(SSLConnection));
     if (!conn)
@@ -173,62 +240,42 @@ static SSLConnection *ssl_connection_create_server(int fd, SSL_CTX *ctx)
     conn->ssl = SSL_new(ctx);
     conn->ctx = ctx;
     conn->fd = fd;
-
-    SSL_set_fd(conn->ssl, fd);
-    printf("[SSL SERVER] Waiting for SSL_accept...\n");
-
-    int ret = SSL_accept(conn->ssl);
-    if (ret <= 0)
+    if (!conn->ssl)
     {
-        int err = SSL_get_error(conn->ssl, ret);
-        fprintf(stderr, "SSL_accept failed: %d\n", err);
-        ERR_print_errors_fp(stderr); // In chi tiết lỗi SSL
-        SSL_free(conn->ssl);
+        ERR_print_errors_fp(stderr);
         free(conn);
         return NULL;
     }
 
-    printf("[SSL SERVER] Handshake success\n");
+    SSL_set_fd(conn->ssl, fd);
+    if (mode == SECURE_SSL_SERVER)
+        SSL_set_accept_state(conn->ssl);
+    else
+        SSL_set_connect_state(conn->ssl);
+
     return conn;
 }
 /**
- * \brief Creates an SSL client connection.
- *
- * This function initializes a new SSL connection on the client side, performing
- * the SSL handshake using SSL_connect. It returns a pointer to the SSLConnection
- * instance on success, or NULL if the handshake fails.
+ * \brief Frees a secure connection whose handshake failed, leaving the socket open.
  *
- * \param fd The file descriptor for the client socket.
- * \param ctx The SSL context for the client.
+ * \param comm Pointer to the SecureCommunication instance.
+ * \param mode The mode it was created with.
  *
- * \return Pointer to an SSLConnection instance or NULL on failure.
+ * \return void
  */
-static SSLConnection *ssl_connection_create_client(int fd, SSL_CTX *ctx)
+static void discard_secure_connection(SecureCommunication *comm, SecureMode mode)
 {
-    SSLConnection *conn = malloc(sizeof(SSLConnection));
-    if (!conn)
-        return NULL;
-
-    conn->ssl = SSL_new(ctx);
-    conn->ctx = ctx;
-    conn->fd = fd;
-
-    SSL_set_fd(conn->ssl, fd);
-    printf("[SSL CLIENT] Attempting SSL_connect...\n");
-
-    int ret = SSL_connect(conn->ssl);
-    if (ret <= 0)
+    if (mode == SECURE_PLAIN)
     {
-        int err = SSL_get_error(conn->ssl, ret);
-        fprintf(stderr, "SSL_connect failed: %d\n", err);
-        ERR_print_errors_fp(stderr); // In chi tiết lỗi SSL
+        free(comm->impl);
+    }
+    else
+    {
+        SSLConnection *conn = (SSLConnection *)comm->impl;
         SSL_free(conn->ssl);
         free(conn);
-        return NULL;
     }
-
-    printf("[SSL CLIENT] Handshake success\n");
-    return conn;
+    free(comm);
 }
 
 /**
@@ -250,17 +297,17 @@ void destroy_secure_connection(SecureCommunication *comm)
     free(comm);
 }
 /**
- * \brief Creates a secure connection (SSL or plain).
+ * \brief Creates a secure connection (SSL or plain) without performing the handshake.
  *
- * This function creates a secure communication instance based on the specified mode (SSL or plain).
- * It returns a pointer to the SecureCommunication instance or NULL on failure.
+ * Used for non-blocking sockets: the caller drives interface.handshake() from its
+ * event loop until it returns 0.
  *
  * \param fd The file descriptor for the connection.
  * \param mode The security mode (SSL or plain).
  *
  * \return Pointer to a SecureCommunication instance or NULL on failure.
  */
-SecureCommunication *create_secure_connection(int fd, SecureMode mode)
+SecureCommunication *create_secure_connection_deferred(int fd, SecureMode mode)
 {
     SecureCommunication *comm = malloc(sizeof(SecureCommunication));
     if (!comm)
@@ -269,11 +316,11 @@ SecureCommunication *create_secure_connection(int fd, SecureMode mode)
     switch (mode)
     {
     case SECURE_SSL_SERVER:
-        comm->impl = ssl_connection_create_server(fd, system_manager.ssl_server_context);
+        comm->impl = ssl_connection_create(fd, system_manager.ssl_server_context, mode);
         break;
 
     case SECURE_SSL_CLIENT:
-        comm->impl = ssl_connection_create_client(fd, system_manager.ssl_client_context);
+        comm->impl = ssl_connection_create(fd, system_manager.ssl_client_context, mode);
         break;
 
     case SECURE_PLAIN:
@@ -281,6 +328,11 @@ SecureCommunication *create_secure_connection(int fd, SecureMode mode)
         if (comm->impl)
             ((PlainConnection *)comm->impl)->fd = fd;
         break;
+
+    default:
+        fprintf(stderr, "Unknown secure connection mode %d\n", (int)mode);
+        comm->impl = NULL;
+        break;
     }
 
     if (!comm->impl)
@@ -291,10 +343,38 @@ SecureCommunication *create_secure_connection(int fd, SecureMode mode)
 
     comm->interface.send = (mode == SECURE_PLAIN) ? plain_send : ssl_send;
     comm->interface.recv = (mode == SECURE_PLAIN) ? plain_recv : ssl_recv;
+    comm->interface.handshake = (mode == SECURE_PLAIN) ? plain_handshake : ssl_handshake;
     comm->interface.close = (mode == SECURE_PLAIN) ? plain_close : ssl_close;
 
     return comm;
 }
+/**
+ * \brief Creates a secure connection (SSL or plain) on a blocking socket.
+ *
+ * This function creates a secure communication instance based on the specified mode (SSL or plain)
+ * and completes the handshake before returning. On failure the socket is left open for the caller.
+ *
+ * \param fd The file descriptor for the connection.
+ * \param mode The security mode (SSL or plain).
+ *
+ * \return Pointer to a SecureCommunication instance or NULL on failure.
+ */
+SecureCommunication *create_secure_connection(int fd, SecureMode mode)
+{
+    SecureCommunication *comm = create_secure_connection_deferred(fd, mode);
+    if (!comm)
+        return NULL;
+
+    if (mode != SECURE_PLAIN)
+        printf("[SSL %s] Starting handshake...\n", mode == SECURE_SSL_SERVER ? "SERVER" : "CLIENT");
+
+    if (comm->interface.handshake(comm->impl) != 0)
+    {
+        discard_secure_connection(comm, mode);
+        return NULL;
+    }
+    return comm;
+}
 /**
  * \brief Initializes the SSL contexts for both server and client.
  *
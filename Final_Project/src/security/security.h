@@ -8,6 +8,7 @@
 /*                            FUNCTIONS PROTOTYPES                             */
 /******************************************************************************/
 SecureCommunication *create_secure_connection(int fd, SecureMode mode);
+SecureCommunication *create_secure_connection_deferred(int fd, SecureMode mode);
 void destroy_secure_connection(SecureCommunication *comm);
 void init_ssl_context();
 void cleanup_ssl_context();
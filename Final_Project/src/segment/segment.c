@@ -0,0 +1,558 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "segment.h"
+#include "../partition/partition.h"
+#include <dirent.h>
+#include <sys/mman.h>
+/******************************************************************************/
+/*                     LOCAL TYPES and DEFINITIONS                            */
+/******************************************************************************/
+#define SEGMENT_FILE_BYTES (SEGMENT_HEADER_BYTES + (off_t)SEGMENT_RECORDS * (off_t)sizeof(SegmentRecord))
+#define SEGMENT_BLOCKS (SEGMENT_RECORDS / SEGMENT_BLOCK_RECORDS)
+
+_Static_assert(sizeof(SegmentHeader) <= SEGMENT_HEADER_BYTES, "segment header does not fit its page");
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Formats the path of a segment file, e.g. `sensor_segments/segment_00000001.seg`.
+ */
+static void segment_path(const SegmentStore *store, uint32_t sequence, char *path, size_t size)
+{
+    snprintf(path, size, "%s/segment_%08u.seg", store->directory, sequence);
+}
+/**
+ * \brief Records the reason of a failure, returned by segment_last_error().
+ */
+static void set_error(SegmentStore *store, const char *action, uint32_t sequence)
+{
+    snprintf(store->error, sizeof(store->error), "Segment %08u: %s failed: %s", sequence, action, strerror(errno));
+}
+/**
+ * \brief Returns the header of the segment being written.
+ */
+static SegmentHeader *active_header(SegmentStore *store)
+{
+    return (SegmentHeader *)store->active;
+}
+/**
+ * \brief Returns the records of a mapped segment.
+ */
+static SegmentRecord *segment_records(unsigned char *mapping)
+{
+    return (SegmentRecord *)(mapping + SEGMENT_HEADER_BYTES);
+}
+/**
+ * \brief Adds a segment to the catalog.
+ *
+ * \return bool true on success, false if the catalog could not grow.
+ */
+static bool catalog_add(SegmentStore *store, const SegmentInfo *info)
+{
+    bool added = true;
+
+    pthread_mutex_lock(&store->mutex);
+    if (store->segment_count == store->segment_capacity)
+    {
+        int capacity = store->segment_capacity > 0 ? store->segment_capacity * 2 : 16;
+        SegmentInfo *segments = realloc(store->segments, capacity * sizeof(SegmentInfo));
+        if (segments == NULL)
+            added = false;
+        else
+        {
+            store->segments = segments;
+            store->segment_capacity = capacity;
+        }
+    }
+    if (added)
+        store->segments[store->segment_count++] = *info;
+    pthread_mutex_unlock(&store->mutex);
+    return added;
+}
+/**
+ * \brief Copies the catalog, so readers never hold the mutex while they scan.
+ *
+ * \param count Output: number of segments copied.
+ *
+ * \return SegmentInfo* The copy, to free(), or NULL if there is no segment or no memory.
+ */
+static SegmentInfo *catalog_copy(SegmentStore *store, int *count)
+{
+    SegmentInfo *copy = NULL;
+
+    pthread_mutex_lock(&store->mutex);
+    *count = store->segment_count;
+    if (*count > 0 && (copy = malloc(*count * sizeof(SegmentInfo))) != NULL)
+        memcpy(copy, store->segments, *count * sizeof(SegmentInfo));
+    pthread_mutex_unlock(&store->mutex);
+    return copy;
+}
+/**
+ * \brief Unmaps and closes the segment being written, syncing it first.
+ */
+static void release_active(SegmentStore *store)
+{
+    if (store->active == NULL)
+        return;
+    if (store->dirty && msync(store->active, SEGMENT_FILE_BYTES, MS_SYNC) == 0)
+        atomic_fetch_add(&store->syncs, 1);
+    munmap(store->active, SEGMENT_FILE_BYTES);
+    close(store->active_fd);
+    store->active = NULL;
+    store->active_fd = -1;
+    store->dirty = false;
+}
+/**
+ * \brief Maps a segment for writing.
+ *
+ * \param store The store.
+ * \param sequence Sequence of the segment.
+ * \param create Whether to create the file; it must not exist yet.
+ *
+ * \return bool true on success, false otherwise (see store->error).
+ *
+ * \note The whole file is reserved with posix_fallocate() when it is created: writing through a mapping
+ *       to space the disk does not have raises SIGBUS, a failed allocation is just an error.
+ */
+static bool map_active(SegmentStore *store, uint32_t sequence, bool create)
+{
+    char path[PATH_MAX];
+    segment_path(store, sequence, path, sizeof(path));
+
+    int fd = open(path, O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0644);
+    if (fd < 0)
+    {
+        set_error(store, "open", sequence);
+        return false;
+    }
+    int rc = create ? posix_fallocate(fd, 0, SEGMENT_FILE_BYTES) : 0;
+    if (rc != 0)
+    {
+        errno = rc;
+        set_error(store, "allocation", sequence);
+        close(fd);
+        unlink(path);
+        return false;
+    }
+
+    unsigned char *mapping = mmap(NULL, SEGMENT_FILE_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        set_error(store, "mmap", sequence);
+        close(fd);
+        if (create)
+            unlink(path);
+        return false;
+    }
+    store->active = mapping;
+    store->active_fd = fd;
+    return true;
+}
+/**
+ * \brief Seals the segment being written and starts the next one.
+ *
+ * \return bool true on success, false otherwise (see store->error).
+ */
+static bool start_segment(SegmentStore *store)
+{
+    uint32_t sequence = 1;
+
+    pthread_mutex_lock(&store->mutex);
+    if (store->segment_count > 0)
+        sequence = store->segments[store->segment_count - 1].sequence + 1;
+    pthread_mutex_unlock(&store->mutex);
+
+    release_active(store);
+    if (!map_active(store, sequence, true))
+        return false;
+
+    SegmentHeader *header = active_header(store);
+    header->magic = SEGMENT_MAGIC;
+    header->record_size = sizeof(SegmentRecord);
+    header->sequence = sequence;
+    header->count = 0;
+    header->min_timestamp = INT_MAX;
+    header->max_timestamp = INT_MIN;
+
+    SegmentInfo info = {sequence, 0, INT_MAX, INT_MIN};
+    if (!catalog_add(store, &info))
+    {
+        errno = ENOMEM;
+        set_error(store, "catalog", sequence);
+        return false;
+    }
+    return true;
+}
+/**
+ * \brief Orders readings by timestamp, so that each block of a segment covers a narrow time range.
+ */
+static int compare_timestamp(const void *a, const void *b)
+{
+    const SensorData *x = a, *y = b;
+    return (x->timestamp > y->timestamp) - (x->timestamp < y->timestamp);
+}
+/**
+ * \brief Reads the headers of the segments a previous run left and maps the last one if it is not full.
+ *
+ * \note StorageBackendInterface::open. Files whose header does not match are ignored.
+ */
+static bool segment_open(void *self)
+{
+    SegmentStore *store = self;
+
+    if (mkdir(store->directory, 0755) != 0 && errno != EEXIST)
+    {
+        set_error(store, "mkdir", 0);
+        return false;
+    }
+    DIR *dir = opendir(store->directory);
+    if (dir == NULL)
+    {
+        set_error(store, "opendir", 0);
+        return false;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    store->segment_count = 0;
+    pthread_mutex_unlock(&store->mutex);
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        unsigned int sequence;
+        char path[PATH_MAX];
+        SegmentHeader header;
+
+        if (sscanf(entry->d_name, "segment_%08u.seg", &sequence) != 1)
+            continue;
+        segment_path(store, sequence, path, sizeof(path));
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        bool valid = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                     header.magic == SEGMENT_MAGIC && header.record_size == sizeof(SegmentRecord) &&
+                     header.sequence == sequence && header.count <= SEGMENT_RECORDS;
+        close(fd);
+
+        SegmentInfo info = {sequence, header.count, header.min_timestamp, header.max_timestamp};
+        if (valid && !catalog_add(store, &info))
+        {
+            closedir(dir);
+            errno = ENOMEM;
+            set_error(store, "catalog", sequence);
+            return false;
+        }
+    }
+    closedir(dir);
+
+    pthread_mutex_lock(&store->mutex);
+    for (int i = 1; i < store->segment_count; i++) // insertion sort: few segments, mostly in order
+    {
+        SegmentInfo info = store->segments[i];
+        int j = i;
+        for (; j > 0 && store->segments[j - 1].sequence > info.sequence; j--)
+            store->segments[j] = store->segments[j - 1];
+        store->segments[j] = info;
+    }
+    SegmentInfo last = store->segment_count > 0 ? store->segments[store->segment_count - 1] : (SegmentInfo){0};
+    pthread_mutex_unlock(&store->mutex);
+
+    if (last.sequence > 0 && last.count < SEGMENT_RECORDS)
+        return map_active(store, last.sequence, false);
+    return true;
+}
+/**
+ * \brief Appends a batch to the segment being written (StorageBackendInterface::append_batch).
+ *
+ * \note The batch is sorted by timestamp, so each block of the sparse index covers a narrow time range.
+ *       A batch never straddles two segments: when it does not fit, the segment is sealed and the next one
+ *       started. The records and the header are written first and the catalog updated last, under the
+ *       mutex, so a reader never sees a record that is not completely written.
+ */
+static bool segment_append_batch(void *self, SensorData *batch, int count, int first_kept_day, int *expired)
+{
+    SegmentStore *store = self;
+
+    *expired = 0;
+    if (store->active == NULL || active_header(store)->count + (uint32_t)count > SEGMENT_RECORDS)
+    {
+        if (!start_segment(store))
+            return false;
+    }
+
+    qsort(batch, count, sizeof(SensorData), compare_timestamp);
+
+    SegmentHeader *header = active_header(store);
+    SegmentRecord *records = segment_records(store->active);
+    uint32_t written = header->count;
+    for (int i = 0; i < count; i++)
+    {
+        if (partition_day(batch[i].timestamp) < first_kept_day)
+        {
+            (*expired)++;
+            continue;
+        }
+
+        records[written].timestamp = batch[i].timestamp;
+        records[written].sensor_id = batch[i].sensor_id;
+        records[written].temperature = batch[i].temperature;
+
+        SegmentIndexEntry *block = &header->index[written / SEGMENT_BLOCK_RECORDS];
+        if (written % SEGMENT_BLOCK_RECORDS == 0)
+            block->min_timestamp = block->max_timestamp = batch[i].timestamp;
+        else
+        {
+            if (batch[i].timestamp < block->min_timestamp)
+                block->min_timestamp = batch[i].timestamp;
+            if (batch[i].timestamp > block->max_timestamp)
+                block->max_timestamp = batch[i].timestamp;
+        }
+        if (batch[i].timestamp < header->min_timestamp)
+            header->min_timestamp = batch[i].timestamp;
+        if (batch[i].timestamp > header->max_timestamp)
+            header->max_timestamp = batch[i].timestamp;
+        written++;
+    }
+    header->count = written;
+    store->dirty = true;
+
+    if (store->sync_each_batch)
+    {
+        if (msync(store->active, SEGMENT_FILE_BYTES, MS_SYNC) != 0)
+        {
+            set_error(store, "msync", header->sequence);
+            return false;
+        }
+        atomic_fetch_add(&store->syncs, 1);
+        store->dirty = false;
+    }
+
+    pthread_mutex_lock(&store->mutex);
+    SegmentInfo *info = &store->segments[store->segment_count - 1];
+    info->count = header->count;
+    info->min_timestamp = header->min_timestamp;
+    info->max_timestamp = header->max_timestamp;
+    pthread_mutex_unlock(&store->mutex);
+    return true;
+}
+/**
+ * \brief Visits the readings of a query in storage order (StorageBackendInterface::query_range).
+ *
+ * \note The id of a reading is its position in the store (sequence * SEGMENT_RECORDS + index), and pages
+ *       resume after `after->id`. Segments whose time range misses the query are not opened, and blocks of
+ *       SEGMENT_BLOCK_RECORDS readings whose index entry misses it are not read. Each segment is mapped
+ *       read-only for the scan, so the writer is never blocked.
+ */
+static int segment_query_range(void *self, const ReadingQuery *query, ReadingCursor *after, int max,
+                               ReadingVisitor visit, void *arg)
+{
+    SegmentStore *store = self;
+    int count;
+    int visited = 0;
+
+    SegmentInfo *segments = catalog_copy(store, &count);
+    if (segments == NULL)
+        return count > 0 ? -1 : 0;
+
+    for (int i = 0; i < count && visited < max; i++)
+    {
+        const SegmentInfo *info = &segments[i];
+        long first_id = (long)info->sequence * SEGMENT_RECORDS;
+        if (info->count == 0 || first_id + info->count - 1 <= after->id ||
+            info->max_timestamp < query->from || info->min_timestamp > query->to)
+            continue;
+
+        char path[PATH_MAX];
+        segment_path(store, info->sequence, path, sizeof(path));
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == ENOENT) // dropped by the retention policy since the catalog was copied
+                continue;
+            visited = -1;
+            break;
+        }
+        unsigned char *mapping = mmap(NULL, SEGMENT_FILE_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            visited = -1;
+            break;
+        }
+
+        const SegmentHeader *header = (const SegmentHeader *)mapping;
+        const SegmentRecord *records = segment_records(mapping);
+        uint32_t index = after->id >= first_id ? (uint32_t)(after->id - first_id + 1) : 0;
+        while (index < info->count && visited < max)
+        {
+            const SegmentIndexEntry *block = &header->index[index / SEGMENT_BLOCK_RECORDS];
+            uint32_t block_end = (index / SEGMENT_BLOCK_RECORDS + 1) * SEGMENT_BLOCK_RECORDS;
+            if (block_end > info->count)
+                block_end = info->count;
+            if (block->max_timestamp < query->from || block->min_timestamp > query->to)
+            {
+                index = block_end;
+                continue;
+            }
+
+            for (; index < block_end && visited < max; index++)
+            {
+                const SegmentRecord *record = &records[index];
+                if (record->timestamp < query->from || record->timestamp > query->to ||
+                    (query->sensor_id >= 0 && record->sensor_id != query->sensor_id))
+                    continue;
+
+                SensorData data = {
+                    .timestamp = record->timestamp,
+                    .sensor_id = record->sensor_id,
+                    .temperature = record->temperature,
+                    .is_valid = true,
+                };
+                after->timestamp = data.timestamp;
+                after->id = first_id + index;
+                visit(&data, after->id, arg);
+                visited++;
+            }
+        }
+        munmap(mapping, SEGMENT_FILE_BYTES);
+    }
+
+    free(segments);
+    return visited;
+}
+/**
+ * \brief Unlinks the sealed segments holding only readings of days before `first_kept_day`
+ *        (StorageBackendInterface::drop_before).
+ *
+ * \note Like dropping a day partition, the cost does not depend on how many readings the segment held.
+ *       The segment being written is kept even if all its readings are old.
+ */
+static int segment_drop_before(void *self, int first_kept_day)
+{
+    SegmentStore *store = self;
+    int dropped = 0;
+    int failed = 0;
+
+    pthread_mutex_lock(&store->mutex);
+    int kept = 0;
+    for (int i = 0; i < store->segment_count; i++)
+    {
+        SegmentInfo *info = &store->segments[i];
+        bool sealed = i < store->segment_count - 1 || store->active == NULL;
+        if (sealed && (info->count == 0 || partition_day(info->max_timestamp) < first_kept_day))
+        {
+            char path[PATH_MAX];
+            segment_path(store, info->sequence, path, sizeof(path));
+            if (unlink(path) == 0 || errno == ENOENT)
+            {
+                dropped++;
+                continue;
+            }
+            set_error(store, "unlink", info->sequence);
+            failed++;
+        }
+        store->segments[kept++] = *info;
+    }
+    store->segment_count = kept;
+    pthread_mutex_unlock(&store->mutex);
+
+    return failed > 0 && dropped == 0 ? -1 : dropped;
+}
+/**
+ * \brief Writes the segment being written back to disk (StorageBackendInterface::flush).
+ */
+static void segment_flush(void *self)
+{
+    SegmentStore *store = self;
+
+    if (store->active == NULL || !store->dirty)
+        return;
+    if (msync(store->active, SEGMENT_FILE_BYTES, MS_SYNC) == 0)
+    {
+        atomic_fetch_add(&store->syncs, 1);
+        store->dirty = false;
+    }
+}
+/**
+ * \brief Prints the size of the store (StorageBackendInterface::display_stats).
+ */
+static void segment_display_stats(void *self)
+{
+    SegmentStore *store = self;
+    unsigned long readings = 0;
+
+    pthread_mutex_lock(&store->mutex);
+    int count = store->segment_count;
+    for (int i = 0; i < count; i++)
+        readings += store->segments[i].count;
+    pthread_mutex_unlock(&store->mutex);
+
+    printf(" Segment store           : %s/, %d segment(s), %.2f MiB, %lu readings, %s\n",
+           store->directory, count, count * (double)SEGMENT_FILE_BYTES / 1048576.0, readings,
+           store->sync_each_batch ? "synced every batch" : "synced when idle");
+    printf(" Storage writes          : %.2f MiB records, %lu syncs\n",
+           readings * (double)sizeof(SegmentRecord) / 1048576.0, atomic_load(&store->syncs));
+}
+/**
+ * \brief Returns the reason of the last failure (StorageBackendInterface::last_error).
+ */
+static const char *segment_last_error(void *self)
+{
+    SegmentStore *store = self;
+    return store->error;
+}
+/**
+ * \brief Syncs and unmaps the segment being written, and empties the catalog (StorageBackendInterface::close).
+ */
+static void segment_close(void *self)
+{
+    SegmentStore *store = self;
+
+    release_active(store);
+    pthread_mutex_lock(&store->mutex);
+    free(store->segments);
+    store->segments = NULL;
+    store->segment_count = 0;
+    store->segment_capacity = 0;
+    pthread_mutex_unlock(&store->mutex);
+}
+/**
+ * \brief Sets up the segment backend: append-only, fixed-size segment files of SEGMENT_RECORDS readings.
+ *
+ * \param backend Output: the backend, not opened yet.
+ * \param store State of the backend.
+ * \param directory Directory of the segment files; must outlive the backend.
+ * \param sync_each_batch Whether every batch is synced to disk before it is acknowledged.
+ *
+ * \note Each segment file is a header page (sequence, count, time range, and a sparse index giving the
+ *       time range of every block of SEGMENT_BLOCK_RECORDS readings) followed by fixed-size records.
+ *       The file is allocated once and written through a shared mapping, so an append is a memory copy.
+ *       There is no rollup: aggregates are computed by scanning query_range.
+ */
+void segment_backend_create(StorageBackend *backend, SegmentStore *store, const char *directory, bool sync_each_batch)
+{
+    store->directory = directory;
+    pthread_mutex_init(&store->mutex, NULL);
+    store->segments = NULL;
+    store->segment_count = 0;
+    store->segment_capacity = 0;
+    store->active_fd = -1;
+    store->active = NULL;
+    store->dirty = false;
+    store->sync_each_batch = sync_each_batch;
+    atomic_init(&store->syncs, 0);
+    store->error[0] = '\0';
+
+    backend->impl = store;
+    backend->type = STORAGE_BACKEND_SEGMENT;
+    backend->interface.open = segment_open;
+    backend->interface.append_batch = segment_append_batch;
+    backend->interface.query_range = segment_query_range;
+    backend->interface.aggregate = NULL;
+    backend->interface.drop_before = segment_drop_before;
+    backend->interface.flush = segment_flush;
+    backend->interface.display_stats = segment_display_stats;
+    backend->interface.last_error = segment_last_error;
+    backend->interface.close = segment_close;
+}
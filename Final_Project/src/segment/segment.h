@@ -0,0 +1,11 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+void segment_backend_create(StorageBackend *backend, SegmentStore *store, const char *directory, bool sync_each_batch);
+#endif // SEGMENT_H
@@ -1,41 +1,11 @@
 /******************************************************************************/
 /*                              INCLUDE FILES                                 */
 /******************************************************************************/
+#define _GNU_SOURCE // accept4()
 #include "socket.h"
 /******************************************************************************/
 /*                            FUNCTIONS                              */
 /******************************************************************************/
-/**
- * \brief Sets up the epoll instance and adds the server socket to the epoll set for monitoring incoming events.
- *
- * \param server_fd The file descriptor for the server socket.
- *
- * \return int The epoll file descriptor that can be used to wait for events.
- *
- * \note This function initializes an epoll instance using epoll_create1, then adds the server socket to the epoll set.
- * It ensures proper error handling in case of failure.
- */
-int setup_epoll(int server_fd)
-{
-    int epoll_fd = epoll_create1(0);
-    if (epoll_fd == -1)
-    {
-        perror("epoll_create1");
-        exit(EXIT_FAILURE);
-    }
-
-    struct epoll_event ev;
-    ev.events = EPOLLIN;
-    ev.data.fd = server_fd;
-
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_fd, &ev) == -1)
-    {
-        perror("epoll_ctl: server_fd");
-        exit(EXIT_FAILURE);
-    }
-
-    return epoll_fd;
-}
 /**
  * \brief Creates and binds a socket to the specified port.
  *
@@ -44,6 +14,9 @@ int setup_epoll(int server_fd)
  * \return int The file descriptor of the server socket.
  *
  * \note This function creates a TCP socket, sets up the server address, and binds it to the specified port.
+ * SO_REUSEPORT is set so every reactor thread can bind its own listener on the same port and let the
+ * kernel balance incoming connections between them. The listener is non-blocking so the accept queue
+ * can be drained until EAGAIN.
  * It handles errors and terminates the process if any operation fails.
  */
 int create_and_bind_socket(const int port)
@@ -51,12 +24,20 @@ int create_and_bind_socket(const int port)
     int server_fd;
     struct sockaddr_in server_addr = {0};
 
-    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    if ((server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0)
     {
         perror("socket failed");
         exit(EXIT_FAILURE);
     }
 
+    int enable = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) < 0 ||
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0)
+    {
+        perror("setsockopt SO_REUSEPORT failed");
+        exit(EXIT_FAILURE);
+    }
+
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(port);
@@ -73,19 +54,19 @@ int create_and_bind_socket(const int port)
 /**
  * \brief Accepts a new incoming client connection on the server socket.
  *
- * \param server_fd The file descriptor of the server socket.
+ * \param server_fd The file descriptor of the (non-blocking) server socket.
  * \param client_addr A pointer to a sockaddr_in structure to store the client's address information.
  * \param client_len A pointer to the length of the client's address structure.
  *
- * \return int The file descriptor of the accepted client socket.
+ * \return int The file descriptor of the accepted client socket, or -1 with errno set.
  *
- * \note This function accepts a client connection and returns the file descriptor for the client.
- * It reports an error if the accept operation fails.
+ * \note The client socket is created non-blocking and close-on-exec in the same call (accept4).
+ * EAGAIN means the accept queue is empty and is not reported as an error.
  */
 int accept_client(int server_fd, struct sockaddr_in *client_addr, socklen_t *client_len)
 {
-    int client_fd = accept(server_fd, (struct sockaddr *)client_addr, client_len);
-    if (client_fd < 0)
+    int client_fd = accept4(server_fd, (struct sockaddr *)client_addr, client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
     {
         perror("accept failed");
     }
@@ -156,7 +137,30 @@ bool add_client_fd_to_epoll(int epoll_fd, int client_fd)
     }
     return true;
 }
+/**
+ * \brief Changes the events an already registered client socket is monitored for.
+ *
+ * \param epoll_fd The epoll file descriptor.
+ * \param client_fd The file descriptor of the client socket.
+ * \param events The new epoll event mask (e.g. EPOLLOUT | EPOLLET while a TLS write is pending).
+ *
+ * \return bool Returns true on success, false otherwise.
+ */
+bool modify_client_fd_in_epoll(int epoll_fd, int client_fd, uint32_t events)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(struct epoll_event));
 
+    event.events = events;
+    event.data.fd = client_fd;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client_fd, &event) == -1)
+    {
+        handle_error("epoll_ctl mod client");
+        return false;
+    }
+    return true;
+}
 /**
  * \brief Creates a new socket.
  *
@@ -186,7 +190,7 @@ int create_socket()
  * \note This function configures the server address and attempts to establish a TCP connection.
  * It handles errors if the connection attempt fails.
  */
-static bool connect_to_server(int sock_fd, const char *ip, int port)
+bool connect_to_server(int sock_fd, const char *ip, int port)
 {
     struct sockaddr_in server_addr = {0};
     server_addr.sin_family = AF_INET;
@@ -217,7 +221,7 @@ static bool connect_to_server(int sock_fd, const char *ip, int port)
  * \note This function uses getsockname() to obtain the client's local address and port number.
  * It converts the address to a string and returns the client's port number.
  */
-static int get_port(int sock_fd, char *ip_buffer)
+int get_port(int sock_fd, char *ip_buffer)
 {
     struct sockaddr_in client_addr;
     socklen_t len = sizeof(client_addr);
@@ -260,6 +264,67 @@ static int get_port(int sock_fd, char *ip_buffer)
 
 //     return true;
 // }
+/**
+ * \brief Sends a whole buffer over a secure channel.
+ *
+ * \param secure_comm The (blocking) secure channel.
+ * \param data The bytes to send.
+ * \param len Number of bytes to send.
+ *
+ * \return bool Returns true if every byte was sent, false otherwise.
+ */
+bool send_all(SecureCommunication *secure_comm, const uint8_t *data, size_t len)
+{
+    size_t sent = 0;
+    while (sent < len)
+    {
+        int ret = secure_comm->interface.send(secure_comm->impl, (const char *)data + sent, len - sent);
+        if (ret == SECURE_IO_WANT_READ || ret == SECURE_IO_WANT_WRITE)
+            continue;
+        if (ret <= 0)
+            return false;
+        sent += ret;
+    }
+    return true;
+}
+/**
+ * \brief Acts as a temperature sensor on an established gateway connection.
+ *
+ * \param secure_comm The secure channel to the gateway (client info already sent).
+ * \param seed Seed of the per-thread random generator.
+ *
+ * \note A reading is sampled every SENSOR_SAMPLE_INTERVAL_SECONDS and every SENSOR_SAMPLES_PER_FRAME
+ * readings are pushed as one measurement frame. Runs until a stop is requested or the gateway goes away.
+ */
+static void run_simulated_sensor(SecureCommunication *secure_comm, unsigned int seed)
+{
+    MeasurementFrame frame = {.version = PROTOCOL_VERSION};
+    uint8_t buffer[PROTOCOL_MAX_FRAME_SIZE];
+    uint32_t sequence = 0;
+
+    while (!stop_requested)
+    {
+        frame.sequence = sequence++;
+        frame.base_timestamp = (uint32_t)time(NULL);
+        frame.count = 0;
+
+        while (frame.count < SENSOR_SAMPLES_PER_FRAME && !stop_requested)
+        {
+            MeasurementReading *reading = &frame.readings[frame.count++];
+            reading->offset = (uint16_t)((uint32_t)time(NULL) - frame.base_timestamp);
+            // create random temperature (0-50°C)
+            reading->temperature = (float)(rand_r(&seed) % 50);
+            sleep(SENSOR_SAMPLE_INTERVAL_SECONDS);
+        }
+
+        size_t len = protocol_encode_frame(&frame, buffer, sizeof(buffer));
+        if (len == 0 || !send_all(secure_comm, buffer, len))
+        {
+            handle_error("Failed to send measurement frame");
+            return;
+        }
+    }
+}
 /**
  * \brief The main function for the client thread that connects to a server, sends client information, and handles communication.
  *
@@ -268,7 +333,8 @@ static int get_port(int sock_fd, char *ip_buffer)
  * \return void* Always returns NULL.
  *
  * \note This function runs in a separate thread, where it connects to the server, retrieves client information,
- * sends it to the server, and manages the socket lifecycle. It handles errors in the process and ensures the socket is properly closed.
+ * sends it to the server, then pushes simulated measurement frames until stopped. It handles errors in the process
+ * and ensures the socket is properly closed.
  */
 void *client_thread_main(void *arg)
 {
@@ -326,14 +392,16 @@ void *client_thread_main(void *arg)
     info.port = system_manager.connection_manager.running_port;
 
     // send data with SSL
-    if (secure_comm->interface.send(secure_comm->impl, (const char *)&info, sizeof(info)) <= 0)
+    if (!send_all(secure_comm, (const uint8_t *)&info, sizeof(info)))
     {
         handle_error("Failed to send client info securely");
-        destroy_secure_connection(secure_comm);
-        close(sock_fd);
-        return NULL;
+    }
+    else
+    {
+        run_simulated_sensor(secure_comm, (unsigned int)time(NULL) ^ (unsigned int)client_port);
     }
 
+    destroy_secure_connection(secure_comm); // also closes sock_fd
     free(server_ip);
     free(args);
     return NULL;
@@ -6,6 +6,7 @@
 #include "../../include/shared_data.h"
 #include "../utils/utils.h"
 #include "../security/security.h"
+#include "../protocol/protocol.h"
 
 /******************************************************************************/
 /*                              PRIVATE DATA                                  */
@@ -17,19 +18,14 @@ typedef struct
     int local_port;
 } ConnectArgs;
 
-typedef struct
-{
-    int sock_fd;
-    char ip_address[INET_ADDRSTRLEN];
-    int port;
-} ClientInfoPacket;
-
 /******************************************************************************/
 /*                            FUNCTIONS PROTOTYPES                             */
 /******************************************************************************/
-int setup_epoll(int server_fd);
-void handle_new_connection(int epoll_fd, int server_fd);
+void handle_new_connection(ConnectionShard *shard);
 int create_socket();
+bool connect_to_server(int sock_fd, const char *ip, int port);
+int get_port(int sock_fd, char *ip_buffer);
+bool send_all(SecureCommunication *secure_comm, const uint8_t *data, size_t len);
 int create_and_bind_socket(const int port);
 void *client_thread_main(void *arg);
 void start_client_connection(char *ip_address, const int port_connect);
@@ -37,5 +33,6 @@ int accept_client(int server_fd, struct sockaddr_in *client_addr, socklen_t *cli
 bool read_client_info(int client_fd, ClientInfoPacket *packet);
 void warn_if_ip_mismatch(const char *actual_ip, const char *reported_ip);
 bool add_client_fd_to_epoll(int epoll_fd, int client_fd);
+bool modify_client_fd_in_epoll(int epoll_fd, int client_fd, uint32_t events);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,348 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#define _GNU_SOURCE // fallocate()
+#include "spill.h"
+#include <sys/mman.h>
+/******************************************************************************/
+/*                     LOCAL TYPES and DEFINITIONS                            */
+/******************************************************************************/
+#define RECORD_SIZE ((off_t)sizeof(SpillRecord))
+
+static uint32_t crc_table[256];
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Fills the CRC-32 (IEEE 802.3, reflected) lookup table.
+ */
+static void crc32_init()
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        crc_table[i] = crc;
+    }
+}
+/**
+ * \brief Returns the CRC-32 of the payload of a record (every field after `crc`).
+ *
+ * \note An all-zero record, which is what the unwritten tail of the file holds, never matches.
+ */
+static uint32_t record_crc(const SpillRecord *record)
+{
+    const unsigned char *bytes = (const unsigned char *)record + sizeof(record->crc);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < sizeof(SpillRecord) - sizeof(record->crc); i++)
+        crc = crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+/**
+ * \brief Unmaps the current window, if any.
+ */
+static void unmap_window(SpillJournal *journal)
+{
+    if (journal->window == NULL)
+        return;
+    munmap(journal->window, SPILL_WINDOW_BYTES);
+    journal->window = NULL;
+}
+/**
+ * \brief Returns the file offset of the window holding a record offset.
+ */
+static off_t window_start(off_t offset)
+{
+    return SPILL_HEADER_BYTES + (offset - SPILL_HEADER_BYTES) / SPILL_WINDOW_BYTES * SPILL_WINDOW_BYTES;
+}
+/**
+ * \brief Maps the window holding a file offset.
+ *
+ * \param journal The journal.
+ * \param offset A record offset, at least SPILL_HEADER_BYTES.
+ * \param grow Whether the file may be extended to hold the window.
+ *
+ * \return bool true if `offset` is now inside the mapped window, false otherwise.
+ *
+ * \note Space is reserved with posix_fallocate() before it is mapped: writing through a mapping to a
+ *       hole the disk has no room for raises SIGBUS, a failed allocation is just an error. Windows are
+ *       SPILL_WINDOW_BYTES, a multiple of the record size, so a record never straddles two of them.
+ *       The cap counts the windows not replayed yet, not the file size: replayed windows are given back
+ *       (see spill_consume()), so a database that keeps failing and recovering never exhausts it.
+ */
+static bool map_window(SpillJournal *journal, off_t offset, bool grow)
+{
+    off_t start = window_start(offset);
+    if (journal->window != NULL && journal->window_offset == start)
+        return true;
+
+    unmap_window(journal);
+    if (journal->file_size < start + SPILL_WINDOW_BYTES)
+    {
+        bool over_cap = journal->max_bytes > 0 && start + SPILL_WINDOW_BYTES - journal->live_offset > journal->max_bytes;
+        if (!grow || over_cap ||
+            posix_fallocate(journal->fd, journal->file_size, start + SPILL_WINDOW_BYTES - journal->file_size) != 0)
+            return false;
+        journal->file_size = start + SPILL_WINDOW_BYTES;
+    }
+
+    void *window = mmap(NULL, SPILL_WINDOW_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, journal->fd, start);
+    if (window == MAP_FAILED)
+        return false;
+    journal->window = window;
+    journal->window_offset = start;
+    return true;
+}
+/**
+ * \brief Returns the record at a file offset, mapping its window if needed.
+ *
+ * \return SpillRecord* The record, or NULL if its window could not be mapped.
+ */
+static SpillRecord *record_at(SpillJournal *journal, off_t offset, bool grow)
+{
+    if (!map_window(journal, offset, grow))
+        return NULL;
+    return (SpillRecord *)(journal->window + (offset - journal->window_offset));
+}
+/**
+ * \brief Empties the journal: the file shrinks back to its header.
+ */
+static void reset_journal(SpillJournal *journal)
+{
+    unmap_window(journal);
+    if (ftruncate(journal->fd, SPILL_HEADER_BYTES) == 0)
+        journal->file_size = SPILL_HEADER_BYTES;
+    journal->header->replay_offset = SPILL_HEADER_BYTES;
+    journal->write_offset = SPILL_HEADER_BYTES;
+    journal->live_offset = SPILL_HEADER_BYTES;
+    atomic_store(&journal->pending, 0);
+}
+/**
+ * \brief Opens the spill journal, creating it if needed, and recovers the records a previous run left.
+ *
+ * \param journal The journal.
+ * \param path Path of the journal file; must outlive the journal.
+ * \param max_mib Cap on the readings waiting to be replayed, in MiB (rounded up to whole windows);
+ *        0 leaves only the free disk space as a limit.
+ *
+ * \return bool true on success, false otherwise (the journal is then disabled and drops what it is given).
+ *
+ * \note Recovery walks the records after the replay offset and stops at the first one whose CRC does not
+ *       match: the tail torn by a crash, or the zeroed space allocated ahead of the writer.
+ */
+bool spill_open(SpillJournal *journal, const char *path, long max_mib)
+{
+    struct stat st;
+
+    crc32_init();
+    journal->path = path;
+    journal->max_bytes = (off_t)max_mib << 20;
+    journal->header = NULL;
+    journal->window = NULL;
+    atomic_init(&journal->pending, 0);
+    atomic_init(&journal->spilled, 0);
+    atomic_init(&journal->replayed, 0);
+    atomic_init(&journal->dropped, 0);
+
+    journal->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (journal->fd < 0)
+        return false;
+    if (fstat(journal->fd, &st) != 0 ||
+        (st.st_size < SPILL_HEADER_BYTES && posix_fallocate(journal->fd, 0, SPILL_HEADER_BYTES) != 0))
+        goto fail;
+
+    journal->header = mmap(NULL, SPILL_HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, journal->fd, 0);
+    if (journal->header == MAP_FAILED)
+    {
+        journal->header = NULL;
+        goto fail;
+    }
+
+    SpillHeader *header = journal->header;
+    journal->file_size = st.st_size < SPILL_HEADER_BYTES ? SPILL_HEADER_BYTES : st.st_size;
+    if (header->magic != SPILL_MAGIC || header->record_size != sizeof(SpillRecord) ||
+        header->replay_offset < SPILL_HEADER_BYTES || (off_t)header->replay_offset > journal->file_size ||
+        (header->replay_offset - SPILL_HEADER_BYTES) % sizeof(SpillRecord) != 0)
+    {
+        header->magic = SPILL_MAGIC;
+        header->record_size = sizeof(SpillRecord);
+        reset_journal(journal);
+        return true;
+    }
+
+    // only whole windows are ever mapped
+    off_t windows = (journal->file_size - SPILL_HEADER_BYTES + SPILL_WINDOW_BYTES - 1) / SPILL_WINDOW_BYTES;
+    off_t aligned = SPILL_HEADER_BYTES + windows * SPILL_WINDOW_BYTES;
+    if (aligned != journal->file_size)
+    {
+        if (posix_fallocate(journal->fd, journal->file_size, aligned - journal->file_size) != 0)
+            goto fail;
+        journal->file_size = aligned;
+    }
+
+    journal->live_offset = window_start(header->replay_offset);
+    off_t offset = header->replay_offset;
+    SpillRecord *record;
+    while (offset < journal->file_size && (record = record_at(journal, offset, false)) != NULL &&
+           record->crc == record_crc(record))
+        offset += RECORD_SIZE;
+    journal->write_offset = offset;
+
+    if (offset == (off_t)header->replay_offset)
+        reset_journal(journal);
+    else
+        atomic_store(&journal->pending, (offset - header->replay_offset) / RECORD_SIZE);
+    return true;
+
+fail:
+    if (journal->header != NULL)
+        munmap(journal->header, SPILL_HEADER_BYTES);
+    journal->header = NULL;
+    close(journal->fd);
+    journal->fd = -1;
+    return false;
+}
+/**
+ * \brief Flushes and closes the journal; an empty journal file is removed.
+ *
+ * \param journal The journal.
+ */
+void spill_close(SpillJournal *journal)
+{
+    if (journal->fd < 0)
+        return;
+
+    if (journal->window != NULL)
+        msync(journal->window, SPILL_WINDOW_BYTES, MS_SYNC);
+    unmap_window(journal);
+    msync(journal->header, SPILL_HEADER_BYTES, MS_SYNC);
+    munmap(journal->header, SPILL_HEADER_BYTES);
+    journal->header = NULL;
+
+    if (atomic_load(&journal->pending) == 0)
+        unlink(journal->path);
+    else if (ftruncate(journal->fd, journal->write_offset) == 0) // give back the space allocated ahead
+        fsync(journal->fd);
+    close(journal->fd);
+    journal->fd = -1;
+}
+/**
+ * \brief Appends readings to the journal.
+ *
+ * \param journal The journal.
+ * \param data The readings.
+ * \param count Number of readings.
+ *
+ * \return int Number of readings appended; the others are counted as dropped (journal at its cap, disk
+ *         full or journal failed).
+ *
+ * \note Storage thread only. Records are written straight into the shared mapping, so once this returns
+ *       they survive a crash of the process; the kernel writes them back to disk on its own schedule.
+ *       Only one SPILL_WINDOW_BYTES window is mapped at a time, whatever the size of the journal.
+ */
+int spill_append(SpillJournal *journal, const SensorData *data, int count)
+{
+    int appended = 0;
+
+    if (journal->fd >= 0)
+    {
+        for (; appended < count; appended++)
+        {
+            SpillRecord *record = record_at(journal, journal->write_offset, true);
+            if (record == NULL)
+                break;
+            record->timestamp = data[appended].timestamp;
+            record->sensor_id = data[appended].sensor_id;
+            record->temperature = data[appended].temperature;
+            record->crc = record_crc(record);
+            journal->write_offset += RECORD_SIZE;
+        }
+    }
+
+    atomic_fetch_add(&journal->pending, appended);
+    atomic_fetch_add(&journal->spilled, appended);
+    atomic_fetch_add(&journal->dropped, count - appended);
+    return appended;
+}
+/**
+ * \brief Reads the oldest records not replayed yet, without consuming them.
+ *
+ * \param journal The journal.
+ * \param out Output: the readings.
+ * \param max Maximum number of records to read.
+ * \param consumed Output: number of records read, to pass to spill_consume() once they are stored.
+ *
+ * \return int Number of readings in `out`; lower than `consumed` if records were found corrupted
+ *             (they are skipped and counted as dropped).
+ */
+int spill_read(SpillJournal *journal, SensorData *out, int max, int *consumed)
+{
+    int count = 0;
+    off_t offset = journal->fd >= 0 ? (off_t)journal->header->replay_offset : 0;
+
+    *consumed = 0;
+    while (journal->fd >= 0 && *consumed < max && offset < journal->write_offset)
+    {
+        SpillRecord *record = record_at(journal, offset, false);
+        if (record == NULL)
+            break;
+        if (record->crc == record_crc(record))
+        {
+            out[count].timestamp = record->timestamp;
+            out[count].sensor_id = record->sensor_id;
+            out[count].temperature = record->temperature;
+            out[count].is_valid = true;
+            count++;
+        }
+        offset += RECORD_SIZE;
+        (*consumed)++;
+    }
+    return count;
+}
+/**
+ * \brief Marks records returned by spill_read() as stored in the database.
+ *
+ * \param journal The journal.
+ * \param consumed Records consumed, as returned by spill_read().
+ * \param replayed Readings among them that were written to the database.
+ *
+ * \note The replay offset lives in the mapped header, so a restart resumes after the last stored batch
+ *       (a crash between the commit and this call replays that batch again). Windows the replay has moved
+ *       past are punched out of the file, which gives their disk space back and frees room under the cap
+ *       while records are still being appended; once everything is replayed the file is truncated back to
+ *       its header.
+ */
+void spill_consume(SpillJournal *journal, int consumed, int replayed)
+{
+    if (journal->fd < 0 || consumed == 0)
+        return;
+
+    journal->header->replay_offset += (uint64_t)consumed * RECORD_SIZE;
+    atomic_fetch_sub(&journal->pending, consumed);
+    atomic_fetch_add(&journal->replayed, replayed);
+    atomic_fetch_add(&journal->dropped, consumed - replayed);
+
+    if ((off_t)journal->header->replay_offset >= journal->write_offset)
+    {
+        reset_journal(journal);
+        return;
+    }
+
+    off_t replayed_end = window_start(journal->header->replay_offset);
+    if (replayed_end > journal->live_offset &&
+        fallocate(journal->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, journal->live_offset,
+                  replayed_end - journal->live_offset) == 0)
+        journal->live_offset = replayed_end;
+}
+/**
+ * \brief Returns the number of records waiting to be replayed.
+ *
+ * \param journal The journal.
+ *
+ * \return unsigned long The record count; safe to call from any thread.
+ */
+unsigned long spill_pending(SpillJournal *journal)
+{
+    return atomic_load(&journal->pending);
+}
@@ -0,0 +1,16 @@
+#ifndef SPILL_H
+#define SPILL_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+bool spill_open(SpillJournal *journal, const char *path, long max_mib);
+void spill_close(SpillJournal *journal);
+int spill_append(SpillJournal *journal, const SensorData *data, int count);
+int spill_read(SpillJournal *journal, SensorData *out, int max, int *consumed);
+void spill_consume(SpillJournal *journal, int consumed, int replayed);
+unsigned long spill_pending(SpillJournal *journal);
+#endif // SPILL_H
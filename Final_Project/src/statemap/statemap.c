@@ -0,0 +1,191 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "statemap.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns the home slot of a sensor ID (Fibonacci hashing, so consecutive handles spread out).
+ */
+static inline size_t home_slot(const SensorStateMap *map, int sensor_id)
+{
+    return (size_t)(((uint32_t)sensor_id * 2654435769u) >> (32 - __builtin_ctzl(map->capacity)));
+}
+/**
+ * \brief Allocates a table of free slots.
+ *
+ * \param capacity Number of slots.
+ *
+ * \return SensorState* The table, NULL if memory allocation fails.
+ */
+static SensorState *alloc_slots(size_t capacity)
+{
+    SensorState *slots = calloc(capacity, sizeof(SensorState));
+    if (!slots)
+        return NULL;
+    for (size_t i = 0; i < capacity; i++)
+        slots[i].sensor_id = -1;
+    return slots;
+}
+/**
+ * \brief Moves every state into a table of a new capacity.
+ *
+ * \param map The map.
+ * \param capacity The new capacity, a power of two holding every state.
+ *
+ * \return bool true on success, false if memory allocation fails (the map is unchanged).
+ *
+ * \note States are moved, not copied: their statistics keep their buffers.
+ */
+static bool resize(SensorStateMap *map, size_t capacity)
+{
+    SensorState *slots = alloc_slots(capacity);
+    if (!slots)
+        return false;
+
+    SensorState *old = map->slots;
+    size_t old_capacity = map->capacity;
+    map->slots = slots;
+    map->capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old[i].sensor_id < 0)
+            continue;
+        size_t slot = home_slot(map, old[i].sensor_id);
+        while (slots[slot].sensor_id >= 0)
+            slot = (slot + 1) & (capacity - 1);
+        slots[slot] = old[i];
+    }
+    free(old);
+    return true;
+}
+/**
+ * \brief Initializes an empty map of STATEMAP_MIN_CAPACITY slots.
+ *
+ * \param map The map.
+ *
+ * \return bool true on success, false if memory allocation fails.
+ */
+bool statemap_init(SensorStateMap *map)
+{
+    map->capacity = STATEMAP_MIN_CAPACITY;
+    map->count = 0;
+    map->slots = alloc_slots(map->capacity);
+    return map->slots != NULL;
+}
+/**
+ * \brief Frees every state and the table.
+ *
+ * \param map The map.
+ */
+void statemap_destroy(SensorStateMap *map)
+{
+    for (size_t i = 0; i < map->capacity && map->slots; i++)
+    {
+        if (map->slots[i].sensor_id >= 0)
+            stats_reset(&map->slots[i].stats);
+    }
+    free(map->slots);
+    map->slots = NULL;
+    map->capacity = 0;
+    map->count = 0;
+}
+/**
+ * \brief Looks up the state of a sensor.
+ *
+ * \param map The map.
+ * \param sensor_id The sensor ID.
+ *
+ * \return SensorState* The state, NULL if the sensor has none.
+ */
+SensorState *statemap_find(const SensorStateMap *map, int sensor_id)
+{
+    if (sensor_id < 0)
+        return NULL;
+    for (size_t slot = home_slot(map, sensor_id);; slot = (slot + 1) & (map->capacity - 1))
+    {
+        if (map->slots[slot].sensor_id == sensor_id)
+            return &map->slots[slot];
+        if (map->slots[slot].sensor_id < 0)
+            return NULL;
+    }
+}
+/**
+ * \brief Returns the state of a sensor, creating an empty one on its first reading.
+ *
+ * \param map The map.
+ * \param sensor_id The sensor ID.
+ *
+ * \return SensorState* The state, NULL for a negative ID or if the map cannot grow.
+ *
+ * \note The map doubles when it would become more than 3/4 full, so probe sequences stay short.
+ *       The pointer is valid until the next call that adds or removes states.
+ */
+SensorState *statemap_get(SensorStateMap *map, int sensor_id)
+{
+    SensorState *state = statemap_find(map, sensor_id);
+    if (state || sensor_id < 0)
+        return state;
+
+    if ((map->count + 1) * 4 > map->capacity * 3 && !resize(map, map->capacity * 2))
+        return NULL;
+
+    size_t slot = home_slot(map, sensor_id);
+    while (map->slots[slot].sensor_id >= 0)
+        slot = (slot + 1) & (map->capacity - 1);
+    state = &map->slots[slot];
+    memset(state, 0, sizeof(*state));
+    state->sensor_id = sensor_id;
+    map->count++;
+    return state;
+}
+/**
+ * \brief Frees the state of the sensors not heard from since a time.
+ *
+ * \param map The map.
+ * \param idle_before States whose last reading is older than this CLOCK_MONOTONIC second are removed.
+ *
+ * \return size_t Number of states removed.
+ *
+ * \note Removal shifts the following entries of the probe run back (backward-shift deletion), so the map
+ *       needs no tombstones and lookups never slow down after churn. The map halves while it is less than
+ *       1/8 full, so its memory follows the number of active sensors.
+ */
+size_t statemap_expire(SensorStateMap *map, long idle_before)
+{
+    size_t removed = 0;
+    size_t mask = map->capacity - 1;
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        // an entry shifted into slot i is checked again before moving on
+        while (map->slots[i].sensor_id >= 0 && map->slots[i].last_seen < idle_before)
+        {
+            stats_reset(&map->slots[i].stats);
+            map->slots[i].sensor_id = -1;
+            map->count--;
+            removed++;
+
+            size_t hole = i;
+            for (size_t next = (hole + 1) & mask; map->slots[next].sensor_id >= 0; next = (next + 1) & mask)
+            {
+                // an entry may fill the hole if its home slot is not cyclically in (hole, next]
+                size_t home = home_slot(map, map->slots[next].sensor_id);
+                if (((next - home) & mask) >= ((next - hole) & mask))
+                {
+                    map->slots[hole] = map->slots[next];
+                    map->slots[next].sensor_id = -1;
+                    hole = next;
+                }
+            }
+        }
+    }
+
+    size_t capacity = map->capacity;
+    while (capacity > STATEMAP_MIN_CAPACITY && map->count * 8 < capacity)
+        capacity /= 2;
+    if (capacity != map->capacity)
+        resize(map, capacity); // on failure the map just stays larger
+    return removed;
+}
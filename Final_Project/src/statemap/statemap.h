@@ -0,0 +1,16 @@
+#ifndef STATEMAP_H
+#define STATEMAP_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+#include "../stats/stats.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+bool statemap_init(SensorStateMap *map);
+void statemap_destroy(SensorStateMap *map);
+SensorState *statemap_find(const SensorStateMap *map, int sensor_id);
+SensorState *statemap_get(SensorStateMap *map, int sensor_id);
+size_t statemap_expire(SensorStateMap *map, long idle_before);
+#endif // STATEMAP_H
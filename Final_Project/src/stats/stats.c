@@ -0,0 +1,197 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "stats.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns the sample with a sequence number still in the window.
+ */
+static inline const StatsSample *sample_at(const SensorStats *stats, unsigned long seq)
+{
+    return &stats->samples[seq & (stats->capacity - 1)];
+}
+/**
+ * \brief Doubles the capacity of the window ring and of the two deques.
+ *
+ * \param stats The statistics.
+ *
+ * \return bool true on success, false if memory allocation fails (nothing changes then).
+ *
+ * \note Every element keeps its sequence number, so it is copied to its index in the larger rings.
+ */
+static bool grow(SensorStats *stats)
+{
+    size_t capacity = stats->capacity ? stats->capacity * 2 : STATS_INITIAL_CAPACITY;
+    StatsSample *samples = malloc(capacity * sizeof(StatsSample));
+    unsigned long *min_seq = malloc(capacity * sizeof(unsigned long));
+    unsigned long *max_seq = malloc(capacity * sizeof(unsigned long));
+    if (!samples || !min_seq || !max_seq)
+    {
+        free(samples);
+        free(min_seq);
+        free(max_seq);
+        return false;
+    }
+
+    size_t old_mask = stats->capacity - 1, mask = capacity - 1;
+    for (unsigned long seq = stats->head; seq != stats->tail; seq++)
+        samples[seq & mask] = stats->samples[seq & old_mask];
+    for (unsigned long i = stats->min_head; i != stats->min_tail; i++)
+        min_seq[i & mask] = stats->min_seq[i & old_mask];
+    for (unsigned long i = stats->max_head; i != stats->max_tail; i++)
+        max_seq[i & mask] = stats->max_seq[i & old_mask];
+
+    free(stats->samples);
+    free(stats->min_seq);
+    free(stats->max_seq);
+    stats->samples = samples;
+    stats->min_seq = min_seq;
+    stats->max_seq = max_seq;
+    stats->capacity = capacity;
+    return true;
+}
+/**
+ * \brief Removes the oldest sample from the window.
+ *
+ * \note The sum and the Welford mean/M2 are updated by subtraction; a deque front leaves with its sample.
+ */
+static void evict_oldest(SensorStats *stats)
+{
+    double value = sample_at(stats, stats->head)->value;
+    unsigned long count = stats->tail - stats->head - 1; // after the removal
+
+    stats->sum -= value;
+    if (count == 0)
+    {
+        stats->sum = stats->mean = stats->m2 = 0.0;
+    }
+    else
+    {
+        double delta = value - stats->mean;
+        stats->mean -= delta / count;
+        stats->m2 -= delta * (value - stats->mean);
+        if (stats->m2 < 0.0) // rounding
+            stats->m2 = 0.0;
+    }
+
+    if (stats->min_head != stats->min_tail && stats->min_seq[stats->min_head & (stats->capacity - 1)] == stats->head)
+        stats->min_head++;
+    if (stats->max_head != stats->max_tail && stats->max_seq[stats->max_head & (stats->capacity - 1)] == stats->head)
+        stats->max_head++;
+    stats->head++;
+}
+/**
+ * \brief Adds a reading to a sensor's window and evicts the readings that fall out of it.
+ *
+ * \param stats The statistics of the sensor.
+ * \param window The window length, in samples or in seconds.
+ * \param timestamp Epoch seconds of the reading.
+ * \param value The reading.
+ *
+ * \return bool true on success, false if the window could not grow (the reading is not added).
+ *
+ * \note Constant time per reading, amortized over the evictions and the rare growths: the sum and the Welford
+ *       mean/M2 are updated by addition and subtraction, the EWMA by one multiply-add, and the minimum and the
+ *       maximum are the fronts of monotonic deques whose backs drop the samples the new one dominates.
+ *       A window in seconds is relative to the newest reading and holds at most STATS_MAX_WINDOW_SAMPLES.
+ */
+bool stats_add(SensorStats *stats, const StatsWindow *window, int timestamp, float value)
+{
+    size_t limit = window->samples > 0 ? (size_t)window->samples : STATS_MAX_WINDOW_SAMPLES;
+    if (stats->tail - stats->head == limit)
+        evict_oldest(stats);
+    if (stats->tail - stats->head == stats->capacity && !grow(stats))
+        return false;
+
+    size_t mask = stats->capacity - 1;
+    unsigned long seq = stats->tail++;
+    stats->samples[seq & mask] = (StatsSample){timestamp, value};
+
+    unsigned long count = stats->tail - stats->head;
+    double delta = value - stats->mean;
+    stats->sum += value;
+    stats->mean += delta / count;
+    stats->m2 += delta * (value - stats->mean);
+    stats->ewma = stats->total++ == 0 ? value : stats->ewma + STATS_EWMA_ALPHA * (value - stats->ewma);
+
+    while (stats->min_tail != stats->min_head && sample_at(stats, stats->min_seq[(stats->min_tail - 1) & mask])->value >= value)
+        stats->min_tail--;
+    stats->min_seq[stats->min_tail++ & mask] = seq;
+    while (stats->max_tail != stats->max_head && sample_at(stats, stats->max_seq[(stats->max_tail - 1) & mask])->value <= value)
+        stats->max_tail--;
+    stats->max_seq[stats->max_tail++ & mask] = seq;
+
+    if (window->seconds > 0)
+    {
+        while (stats->tail - stats->head > 1 && sample_at(stats, stats->head)->timestamp <= timestamp - window->seconds)
+            evict_oldest(stats);
+    }
+    return true;
+}
+/**
+ * \brief Reads the statistics of a sensor's window.
+ *
+ * \param stats The statistics.
+ * \param snapshot Output: count, mean, EWMA, minimum, maximum and standard deviation (all 0 for an empty window).
+ */
+void stats_snapshot(const SensorStats *stats, StatsSnapshot *snapshot)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->count = (long)(stats->tail - stats->head);
+    if (snapshot->count == 0)
+        return;
+
+    size_t mask = stats->capacity - 1;
+    snapshot->mean = stats->sum / snapshot->count;
+    snapshot->ewma = stats->ewma;
+    snapshot->min = sample_at(stats, stats->min_seq[stats->min_head & mask])->value;
+    snapshot->max = sample_at(stats, stats->max_seq[stats->max_head & mask])->value;
+    snapshot->stddev = snapshot->count > 1 ? sqrt(stats->m2 / (snapshot->count - 1)) : 0.0;
+}
+/**
+ * \brief Frees a sensor's window and clears its statistics.
+ *
+ * \param stats The statistics.
+ */
+void stats_reset(SensorStats *stats)
+{
+    free(stats->samples);
+    free(stats->min_seq);
+    free(stats->max_seq);
+    memset(stats, 0, sizeof(*stats));
+}
+/**
+ * \brief Parses a window length: a number of samples (`300`) or of seconds (`60s`).
+ *
+ * \param text The text to parse.
+ * \param window Output: the window.
+ *
+ * \return bool true if the text is a valid window, false otherwise.
+ */
+bool stats_window_from_text(const char *text, StatsWindow *window)
+{
+    char *end;
+    long length = strtol(text, &end, 10);
+    if (end == text || length < 1 || length > STATS_MAX_WINDOW_SAMPLES)
+        return false;
+
+    if (*end == '\0')
+        *window = (StatsWindow){(int)length, 0};
+    else if (strcmp(end, "s") == 0)
+        *window = (StatsWindow){0, (int)length};
+    else
+        return false;
+    return true;
+}
+/**
+ * \brief Describes a window length for the console, e.g. "5 samples" or "60 s".
+ */
+void stats_window_describe(const StatsWindow *window, char *buffer, size_t size)
+{
+    if (window->seconds > 0)
+        snprintf(buffer, size, "%d s", window->seconds);
+    else
+        snprintf(buffer, size, "%d samples", window->samples);
+}
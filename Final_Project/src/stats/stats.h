@@ -0,0 +1,15 @@
+#ifndef STATS_H
+#define STATS_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+bool stats_add(SensorStats *stats, const StatsWindow *window, int timestamp, float value);
+void stats_snapshot(const SensorStats *stats, StatsSnapshot *snapshot);
+void stats_reset(SensorStats *stats);
+bool stats_window_from_text(const char *text, StatsWindow *window);
+void stats_window_describe(const StatsWindow *window, char *buffer, size_t size);
+#endif // STATS_H
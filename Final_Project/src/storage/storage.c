@@ -1,26 +1,39 @@
 /******************************************************************************/
 /*                              INCLUDE FILES                                 */
 /******************************************************************************/
+#define _GNU_SOURCE // sem_clockwait()
 #include "storage.h"
+#include "../ring/ring.h"
+#include "../utils/utils.h"
+#include "../vfs/vfs.h"
+#include "../partition/partition.h"
+#include "../rollup/rollup.h"
+#include "../spill/spill.h"
+#include "../segment/segment.h"
+/******************************************************************************/
+/*                              PRIVATE DATA                                  */
+/******************************************************************************/
+static const StorageProfile storage_profiles[] = {
+    [STORAGE_PROFILE_ROLLBACK] = {"rollback", false, "FULL", 4096, 2000, 0},
+    [STORAGE_PROFILE_SAFE] = {"safe", true, "FULL", 4096, 8192, 1000},
+    [STORAGE_PROFILE_NORMAL] = {"normal", true, "NORMAL", 4096, 8192, 1000},
+    [STORAGE_PROFILE_FAST] = {"fast", true, "OFF", 8192, 32768, 4000},
+};
+
+static const char *const storage_backend_names[] = {
+    [STORAGE_BACKEND_SQLITE] = "sqlite",
+    [STORAGE_BACKEND_SEGMENT] = "segment",
+};
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+static int sqlite_query_range(void *self, const ReadingQuery *query, ReadingCursor *after, int max,
+                              ReadingVisitor visit, void *arg);
+static bool sqlite_aggregate(void *self, const ReadingQuery *query, RollupAggregate *aggregate, RollupQueryStats *stats);
+static void sqlite_display_stats(void *self);
 /******************************************************************************/
 /*                            FUNCTIONS                              */
 /******************************************************************************/
-/**
- * \brief Initializes the sensor data table in the SQL database if it does not exist.
- *
- * \param db The SQLite database handle.
- *
- * \return Returns true if the table is created successfully or already exists, false otherwise.
- *
- * \note This function creates a table named `sensor_data` with columns `id`, `timestamp`, `sensor_id`, and `temperature`.
- */
-static bool initialize_sql_table(sqlite3 *db)
-{
-    const char *create_table_sql = "CREATE TABLE IF NOT EXISTS sensor_data "
-                                   "(id INTEGER PRIMARY KEY, timestamp INTEGER, "
-                                   "sensor_id INTEGER, temperature REAL)";
-    return sqlite3_exec(db, create_table_sql, NULL, NULL, NULL) == SQLITE_OK;
-}
 /**
  * \brief Handles a successful SQL connection by updating the connection status and logging the event.
  *
@@ -33,19 +46,22 @@ static void handle_sql_connection_success(SQLConnectionInfo *sql)
 {
     strcpy(sql->status, SQL_CONNECTED);
     sql->retry_count = 0;
+
+    char log_msg[64];
+    snprintf(log_msg, sizeof(log_msg), "Connected to %s storage",
+             storage_backend_name(system_manager.storage_manager.backend.type));
     system_manager.log_manager.log(&system_manager.log_manager,
-                                   LOG_INFO, "Storage",
-                                   "Connected to SQL database");
+                                   LOG_INFO, "Storage", log_msg);
 }
 /**
- * \brief Handles a failed SQL connection by updating the connection status and retrying if the limit is not reached.
+ * \brief Handles a failed SQL connection by updating the connection status and scheduling the next attempt.
  *
  * \param sql The SQL connection information structure.
  *
- * \return Returns true if the retry limit is not reached and the connection should be retried, false otherwise.
+ * \return Always false: the connection is retried SQL_RETRY_DELAY_SEC later.
  *
- * \note This function increments the retry count and logs an error message if the maximum retry limit is reached.
- *       It sleeps for a delay before retrying.
+ * \note Never sleeps nor exits: the storage thread keeps draining the queue into the spill journal
+ *       meanwhile. The failure is logged on the first attempt and once SQL_RETRY_LIMIT is reached.
  */
 static bool handle_sql_connection_failure(SQLConnectionInfo *sql)
 {
@@ -53,104 +69,657 @@ static bool handle_sql_connection_failure(SQLConnectionInfo *sql)
     sql->retry_count++;
     sql->last_retry_time = time(NULL);
 
-    if (sql->retry_count >= SQL_RETRY_LIMIT)
+    if (sql->retry_count == 1 || sql->retry_count == SQL_RETRY_LIMIT)
     {
+        char log_msg[160];
+        snprintf(log_msg, sizeof(log_msg),
+                 "%s storage unavailable (attempt %d), readings are spilled to %s, retrying every %d s",
+                 storage_backend_name(system_manager.storage_manager.backend.type), sql->retry_count,
+                 SPILL_FILE_NAME, SQL_RETRY_DELAY_SEC);
         system_manager.log_manager.log(&system_manager.log_manager,
-                                       LOG_ERROR, "Storage",
-                                       "Max retry attempts reached. Shutting down.");
-        exit(EXIT_FAILURE);
+                                       LOG_ERROR, "Storage", log_msg);
     }
-    sleep(SQL_RETRY_DELAY_SEC);
     return false;
 }
 /**
- * \brief Attempts to connect to the SQL database with retry logic.
+ * \brief Returns the command line name of a storage backend.
  *
- * \return Returns true if the connection is successful, false if retries are exhausted.
+ * \param type The backend type.
  *
- * \note This function tries to open the database connection, creates the table, and handles any connection failures
- *       by retrying the connection process.
+ * \return const char* "sqlite" or "segment".
  */
-static bool storage_connect_with_retry()
+const char *storage_backend_name(StorageBackendType type)
+{
+    return storage_backend_names[type];
+}
+/**
+ * \brief Parses a storage backend name given on the command line.
+ *
+ * \param name "sqlite" or "segment".
+ * \param type Output: the backend type.
+ *
+ * \return bool true if the name is known, false otherwise.
+ */
+bool storage_backend_from_name(const char *name, StorageBackendType *type)
+{
+    for (size_t i = 0; i < sizeof(storage_backend_names) / sizeof(storage_backend_names[0]); i++)
+    {
+        if (strcmp(name, storage_backend_names[i]) == 0)
+        {
+            *type = (StorageBackendType)i;
+            return true;
+        }
+    }
+    return false;
+}
+/**
+ * \brief Tells whether batches should be written to the database right now.
+ *
+ * \return bool false while disconnected, and for SQL_RETRY_DELAY_SEC after a failed commit.
+ */
+static bool database_writable()
 {
     SQLConnectionInfo *sql = &system_manager.storage_manager.sql_info;
-
-    if (sqlite3_open(DB_FILE_NAME, &sql->db_handle) == SQLITE_OK)
+    if (strcmp(sql->status, SQL_CONNECTED) != 0)
+        return false;
+    return sql->retry_count == 0 || time(NULL) - sql->last_retry_time >= SQL_RETRY_DELAY_SEC;
+}
+/**
+ * \brief Tells whether the next connection attempt is due.
+ */
+static bool reconnect_due()
+{
+    SQLConnectionInfo *sql = &system_manager.storage_manager.sql_info;
+    return strcmp(sql->status, SQL_DISCONNECTED) == 0 && time(NULL) - sql->last_retry_time >= SQL_RETRY_DELAY_SEC;
+}
+/**
+ * \brief Returns the durability profile of a given type.
+ *
+ * \param type The profile type.
+ *
+ * \return const StorageProfile* The profile.
+ */
+const StorageProfile *storage_profile_get(StorageProfileType type)
+{
+    return &storage_profiles[type];
+}
+/**
+ * \brief Parses a durability profile name given on the command line.
+ *
+ * \param name "rollback", "safe", "normal" or "fast".
+ * \param type Output: the profile type.
+ *
+ * \return bool true if the name is known, false otherwise.
+ */
+bool storage_profile_from_name(const char *name, StorageProfileType *type)
+{
+    for (size_t i = 0; i < sizeof(storage_profiles) / sizeof(storage_profiles[0]); i++)
     {
-        if (initialize_sql_table(sql->db_handle))
+        if (strcmp(name, storage_profiles[i].name) == 0)
         {
-            handle_sql_connection_success(sql);
+            *type = (StorageProfileType)i;
             return true;
         }
-        sqlite3_close(sql->db_handle);
     }
-    return handle_sql_connection_failure(sql);
+    return false;
+}
+/**
+ * \brief Runs a checkpoint on the writer connection and counts it.
+ *
+ * \param db The writer's database handle.
+ * \param mode SQLITE_CHECKPOINT_PASSIVE or SQLITE_CHECKPOINT_TRUNCATE.
+ *
+ * \note A passive checkpoint never waits for readers; a truncating one returns SQLITE_BUSY
+ *       instead of waiting when a reader still uses the WAL, and is simply retried later.
+ */
+static void checkpoint_wal(sqlite3 *db, int mode)
+{
+    StorageManager *storage = &system_manager.storage_manager;
+
+    int rc = sqlite3_wal_checkpoint_v2(db, NULL, mode, NULL, NULL);
+    if (mode == SQLITE_CHECKPOINT_TRUNCATE && rc == SQLITE_OK)
+        storage->wal_pages = 0;
+
+    pthread_mutex_lock(&storage->mutex);
+    if (mode == SQLITE_CHECKPOINT_TRUNCATE)
+        storage->truncating_checkpoints += rc == SQLITE_OK;
+    else
+        storage->checkpoints++;
+    pthread_mutex_unlock(&storage->mutex);
 }
 /**
- * \brief Creates a new connection node to hold sensor data.
+ * \brief WAL hook of the writer connection: applies the profile's checkpoint policy after each commit.
  *
- * \param data The sensor data to be stored in the new node.
+ * \param arg The storage manager.
+ * \param db The writer's database handle.
+ * \param name Name of the database that was written ("main").
+ * \param pages Number of pages now in the WAL.
  *
- * \return Returns a pointer to the newly created connection node, or NULL if memory allocation fails.
+ * \return int SQLITE_OK.
  *
- * \note This function allocates memory for a new connection node and stores the provided sensor data.
+ * \note Replaces SQLite's automatic checkpoint so the threshold follows the profile and checkpoints
+ *       are counted. The WAL restarts from its beginning on the first commit after a complete checkpoint.
  */
-static ConnectionNode *create_data_node(SensorData data)
+static int wal_commit_hook(void *arg, sqlite3 *db, const char *name, int pages)
 {
-    ConnectionNode *new_node = malloc(sizeof(ConnectionNode));
-    if (new_node == NULL)
-        return NULL;
+    (void)name;
+    StorageManager *storage = arg;
 
-    new_node->latest_data = data;
-    new_node->next = NULL;
-    return new_node;
+    storage->wal_pages = pages;
+    if (pages >= storage->profile->checkpoint_pages)
+        checkpoint_wal(db, SQLITE_CHECKPOINT_PASSIVE);
+    return SQLITE_OK;
 }
 /**
- * \brief Appends a new connection node to the pending data list.
+ * \brief Applies the durability profile to the writer connection.
+ *
+ * \param db The writer's database handle.
+ * \param profile The profile to apply.
  *
- * \param new_node The new connection node to be appended.
+ * \return Returns true if every setting was accepted, false otherwise.
  *
- * \note This function traverses the pending data list and appends the new node at the end.
+ * \note The page size only takes effect while the database file is still empty, so it is set first.
+ *       Journal mode WAL is persistent: once set, readers opening the file use it as well.
  */
-static void append_to_pending_data(ConnectionNode *new_node)
+static bool configure_connection(sqlite3 *db, const StorageProfile *profile)
 {
-    if (system_manager.storage_manager.pending_data_head == NULL)
+    char pragmas[256];
+    snprintf(pragmas, sizeof(pragmas),
+             "PRAGMA page_size=%d; PRAGMA journal_mode=%s; PRAGMA synchronous=%s; PRAGMA cache_size=-%d;",
+             profile->page_size, profile->wal ? "WAL" : "DELETE", profile->synchronous, profile->cache_size_kib);
+    if (sqlite3_exec(db, pragmas, NULL, NULL, NULL) != SQLITE_OK)
+        return false;
+
+    if (profile->wal)
     {
-        system_manager.storage_manager.pending_data_head = new_node;
+        sqlite3_wal_autocheckpoint(db, 0);
+        sqlite3_wal_hook(db, wal_commit_hook, &system_manager.storage_manager);
     }
-    else
+    return true;
+}
+/**
+ * \brief Opens the read-only connection used by the user interface.
+ *
+ * \return sqlite3* The connection, or NULL if it cannot be opened.
+ *
+ * \note In WAL mode it reads a snapshot while the writer keeps committing; with the rollback
+ *       journal it waits up to STORAGE_READER_BUSY_TIMEOUT_MS for a commit to finish.
+ */
+static sqlite3 *open_reader_connection()
+{
+    sqlite3 *db;
+
+    if (sqlite3_open_v2(DB_FILE_NAME, &db, SQLITE_OPEN_READONLY, COUNTING_VFS_NAME) != SQLITE_OK)
     {
-        ConnectionNode *current = system_manager.storage_manager.pending_data_head;
-        while (current->next != NULL)
-            current = current->next;
-        current->next = new_node;
+        sqlite3_close(db);
+        return NULL;
     }
+    sqlite3_busy_timeout(db, STORAGE_READER_BUSY_TIMEOUT_MS);
+    return db;
 }
 /**
- * \brief Adds sensor data to the pending data list.
+ * \brief Opens the SQLite backend (StorageBackendInterface::open).
+ *
+ * \param self The SQL connection information structure.
+ *
+ * \return Returns true if the connection is successful, false otherwise.
+ *
+ * \note This function tries to open the database connection through the counting VFS, applies the durability
+ *       profile, creates the partition catalog and the hour rollup, and opens the reader connection.
+ */
+static bool sqlite_open(void *self)
+{
+    SQLConnectionInfo *sql = self;
+
+    if (sqlite3_open_v2(DB_FILE_NAME, &sql->db_handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                        COUNTING_VFS_NAME) == SQLITE_OK &&
+        configure_connection(sql->db_handle, system_manager.storage_manager.profile) &&
+        partition_init_catalog(sql->db_handle) &&
+        partition_cache_open(&sql->partitions, sql->db_handle) &&
+        rollup_create_table(sql->db_handle, ROLLUP_HOUR_TABLE) &&
+        (sql->hour_rollup_stmt = rollup_prepare_upsert(sql->db_handle, ROLLUP_HOUR_TABLE)) != NULL)
+    {
+        sql->read_handle = open_reader_connection();
+        return true;
+    }
+
+    // a failed open still returns a handle that must be closed
+    partition_cache_close(&sql->partitions);
+    sqlite3_close(sql->db_handle);
+    sql->db_handle = NULL;
+    return false;
+}
+/**
+ * \brief Closes the SQLite backend (StorageBackendInterface::close) and logs its write amplification.
+ *
+ * \param self The SQL connection information structure.
+ */
+static void sqlite_close(void *self)
+{
+    SQLConnectionInfo *sql = self;
+
+    sqlite3_close(sql->read_handle);
+    sql->read_handle = NULL;
+    partition_cache_close(&sql->partitions);
+    sqlite3_finalize(sql->hour_rollup_stmt);
+    sql->hour_rollup_stmt = NULL;
+    sqlite3_close(sql->db_handle); // last connection: checkpoints and removes the WAL
+    sql->db_handle = NULL;
+
+    char log_msg[160];
+    snprintf(log_msg, sizeof(log_msg), "Profile %s: %d rows, write amplification %.2fx, %lu syncs",
+             system_manager.storage_manager.profile->name,
+             system_manager.storage_manager.total_messages_received, storage_write_amplification(),
+             atomic_load(&system_manager.storage_manager.io_stats.syncs));
+    system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Storage", log_msg);
+}
+/**
+ * \brief Returns the last error of the SQLite writer connection (StorageBackendInterface::last_error).
+ */
+static const char *sqlite_last_error(void *self)
+{
+    SQLConnectionInfo *sql = self;
+    return sqlite3_errmsg(sql->db_handle);
+}
+/**
+ * \brief Connects the storage backend, or schedules the next attempt.
+ *
+ * \return Returns true if the connection is successful, false otherwise (retried SQL_RETRY_DELAY_SEC later).
+ */
+static bool storage_connect_with_retry()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+
+    if (storage->backend.interface.open(storage->backend.impl))
+    {
+        handle_sql_connection_success(&storage->sql_info);
+        return true;
+    }
+    return handle_sql_connection_failure(&storage->sql_info);
+}
+/**
+ * \brief Queues sensor data for the storage thread.
  *
  * \param data The sensor data to be added.
  *
- * \note This function locks the mutex, creates a new data node, and appends it to the pending data list.
- *       If memory allocation fails, it logs an error message.
+ * \note Lock-free and never blocks the calling reactor: the reading is copied into the pending ring.
+ *       The storage thread is woken when the ring becomes non-empty or a full batch is pending.
+ *       If the ring is full the reading is dropped and counted; drops are logged sparingly.
  */
 void storage_add_data(SensorData data)
 {
-    pthread_mutex_lock(&system_manager.storage_manager.mutex);
+    StorageManager *storage = &system_manager.storage_manager;
+    size_t occupancy = ring_push(&storage->pending, &data);
 
-    ConnectionNode *new_node = create_data_node(data);
-    if (new_node != NULL)
+    if (occupancy == 0)
     {
-        append_to_pending_data(new_node);
+        unsigned long dropped = atomic_load_explicit(&storage->pending.overflows, memory_order_relaxed);
+        if ((dropped & (dropped - 1)) == 0) // 1st, 2nd, 4th, 8th... drop
+        {
+            char log_msg[128];
+            snprintf(log_msg, sizeof(log_msg), "Storage queue full, %lu readings dropped so far", dropped);
+            system_manager.log_manager.log(&system_manager.log_manager,
+                                           LOG_ERROR, "Storage", log_msg);
+        }
+        return;
     }
-    else
+
+    if ((occupancy == 1 || occupancy >= STORAGE_BATCH_MAX_ROWS) &&
+        !atomic_exchange_explicit(&storage->wake_pending, true, memory_order_acq_rel))
+        sem_post(&storage->batch_ready);
+}
+/**
+ * \brief Writes a batch of readings in a single transaction.
+ *
+ * \param sql The SQL connection information structure.
+ * \param batch The readings to write.
+ * \param count Number of readings in `batch`.
+ * \param first_kept_day Readings of older days are outside the retention window and skipped.
+ * \param expired Output: number of readings skipped.
+ *
+ * \return Returns true if the whole batch was committed, false if it was rolled back.
+ *
+ * \note One BEGIN/COMMIT per batch means one journal sync per batch instead of one per row.
+ *       The readings of each sensor go to their day partition as compressed chunks; the minute and hour
+ *       rollups and the catalog are updated in the same transaction. `batch` is expected sorted by
+ *       rollup_sort_batch().
+ */
+static bool commit_batch(SQLConnectionInfo *sql, const SensorData *batch, int count, int first_kept_day, int *expired)
+{
+    if (sqlite3_exec(sql->db_handle, "BEGIN", NULL, NULL, NULL) != SQLITE_OK)
+        return false;
+
+    *expired = partition_insert_batch(&sql->partitions, sql->db_handle, batch, count, first_kept_day);
+    if (*expired < 0)
+        goto rollback;
+
+    if (!rollup_apply_batch(&sql->partitions, sql->hour_rollup_stmt, sql->db_handle, batch, count, first_kept_day))
+        goto rollback;
+    if (!partition_flush_catalog(&sql->partitions))
+        goto rollback;
+    if (sqlite3_exec(sql->db_handle, "COMMIT", NULL, NULL, NULL) == SQLITE_OK)
+        return true;
+
+rollback:
+    sqlite3_exec(sql->db_handle, "ROLLBACK", NULL, NULL, NULL);
+    partition_cache_reset(&sql->partitions); // partitions created by this transaction are gone
+    return false;
+}
+/**
+ * \brief Runs one chunk compaction step (see partition_compact_next()) and logs a failure.
+ */
+static void compact_chunks(SQLConnectionInfo *sql)
+{
+    if (partition_compact_next(&sql->partitions, sql->db_handle, (int)time(NULL)) < 0)
+    {
+        char log_msg[160];
+        int code = sqlite3_errcode(sql->db_handle);
+        snprintf(log_msg, sizeof(log_msg), "Chunk compaction failed, window left uncompacted: %s",
+                 code != SQLITE_OK ? sqlite3_errmsg(sql->db_handle) : "unreadable chunk");
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Storage", log_msg);
+    }
+}
+/**
+ * \brief Stores a batch in the SQLite backend (StorageBackendInterface::append_batch).
+ *
+ * \note Sorts the batch by sensor and time first, as the rollups expect. Each commit is followed by one
+ *       chunk compaction step, so chunks are merged even when the gateway is never idle.
+ */
+static bool sqlite_append_batch(void *self, SensorData *batch, int count, int first_kept_day, int *expired)
+{
+    rollup_sort_batch(batch, count);
+    if (!commit_batch(self, batch, count, first_kept_day, expired))
+        return false;
+    compact_chunks(self);
+    return true;
+}
+/**
+ * \brief Drops the day partitions older than a day (StorageBackendInterface::drop_before).
+ */
+static int sqlite_drop_before(void *self, int first_kept_day)
+{
+    SQLConnectionInfo *sql = self;
+    partition_cache_reset(&sql->partitions);
+    return partition_drop_before(sql->db_handle, first_kept_day);
+}
+/**
+ * \brief Returns the oldest day inside the retention window.
+ *
+ * \return int Days since the epoch, INT_MIN if every partition is kept.
+ */
+static int first_kept_day()
+{
+    int retention_days = system_manager.config.retention_days;
+    if (retention_days <= 0)
+        return INT_MIN;
+    return partition_day((int)time(NULL)) - retention_days + 1;
+}
+/**
+ * \brief Retention policy: once per UTC day, drops the partitions (or segments) that left the retention window.
+ *
+ * \note Runs on the storage thread between batches. Dropping a whole day is a DROP TABLE whose cost does
+ *       not depend on how many readings it held, so the writer is never stalled by a large DELETE;
+ *       the segment backend unlinks whole segment files the same way.
+ */
+static void apply_retention()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+    int today = partition_day((int)time(NULL));
+
+    if (system_manager.config.retention_days <= 0 || storage->retention_day == today || !database_writable())
+        return;
+
+    int dropped = storage->backend.interface.drop_before(storage->backend.impl, first_kept_day());
+    if (dropped < 0)
+    {
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Storage",
+                                       storage->backend.interface.last_error(storage->backend.impl));
+        return;
+    }
+    storage->retention_day = today;
+    if (dropped == 0)
+        return;
+
+    pthread_mutex_lock(&storage->mutex);
+    storage->partitions_dropped += dropped;
+    pthread_mutex_unlock(&storage->mutex);
+
+    char log_msg[128];
+    snprintf(log_msg, sizeof(log_msg), "Retention dropped %d %s(s) older than %d days", dropped,
+             storage->backend.type == STORAGE_BACKEND_SQLITE ? "partition" : "segment",
+             system_manager.config.retention_days);
+    system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Storage", log_msg);
+}
+/**
+ * \brief Writes a batch through the storage backend and accounts for it.
+ *
+ * \param batch The readings; the backend may reorder them.
+ * \param count Number of readings in `batch`.
+ *
+ * \return bool true if the batch was committed; on failure the backend is left alone for SQL_RETRY_DELAY_SEC.
+ */
+static bool store_batch(SensorData *batch, int count)
+{
+    StorageManager *storage = &system_manager.storage_manager;
+    SQLConnectionInfo *sql = &storage->sql_info;
+
+    apply_retention();
+
+    int expired;
+    if (!storage->backend.interface.append_batch(storage->backend.impl, batch, count, first_kept_day(), &expired))
     {
         system_manager.log_manager.log(&system_manager.log_manager,
                                        LOG_ERROR, "Storage",
-                                       "Failed to allocate memory for new sensor data.");
+                                       storage->backend.interface.last_error(storage->backend.impl));
+        sql->retry_count++;
+        sql->last_retry_time = time(NULL);
+        return false;
     }
+    sql->retry_count = 0;
+    clock_gettime(CLOCK_MONOTONIC, &storage->last_commit);
 
-    pthread_mutex_unlock(&system_manager.storage_manager.mutex);
+    pthread_mutex_lock(&storage->mutex);
+    storage->total_messages_received += count - expired;
+    storage->expired_readings += expired;
+    storage->batches_committed++;
+    pthread_mutex_unlock(&storage->mutex);
+    return true;
+}
+/**
+ * \brief Appends a batch the database could not take to the spill journal.
+ *
+ * \param batch The readings.
+ * \param count Number of readings in `batch`.
+ */
+static void spill_batch(const SensorData *batch, int count)
+{
+    SpillJournal *spill = &system_manager.storage_manager.spill;
+    unsigned long before = atomic_load(&spill->dropped);
+
+    if (spill_append(spill, batch, count) == count)
+        return;
+
+    unsigned long dropped = atomic_load(&spill->dropped);
+    char log_msg[192];
+    if (before == 0) // the first loss is also printed: from here on readings are gone for good
+    {
+        if (spill->fd < 0)
+            snprintf(log_msg, sizeof(log_msg), "Spill journal unavailable, readings are now LOST until SQL is back");
+        else if (spill->max_bytes > 0)
+            snprintf(log_msg, sizeof(log_msg),
+                     "Spill journal reached its %ld MiB cap (-j) or the disk is full, readings are now LOST "
+                     "until SQL is back", (long)(spill->max_bytes >> 20));
+        else
+            snprintf(log_msg, sizeof(log_msg), "Disk full, spill journal cannot grow, readings are now LOST until "
+                                               "SQL is back");
+        printf("Error: %s\n", log_msg);
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Storage", log_msg);
+    }
+    else if ((before ^ dropped) > before) // the count reached a new power of two: log sparingly
+    {
+        snprintf(log_msg, sizeof(log_msg), "Spill journal full or unavailable, %lu readings dropped so far", dropped);
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Storage", log_msg);
+    }
+}
+/**
+ * \brief Writes the next batch of pending sensor data to the database, or to the spill journal.
+ *
+ * \return int Number of readings taken from the queue, 0 if nothing was pending.
+ *
+ * \note Storage thread only. While the database is disconnected or failing, batches go to the spill
+ *       journal instead, so the queue keeps draining and memory stays bounded by the ring; they are
+ *       replayed by replay_spill() once the database takes writes again.
+ */
+static int process_pending_data()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+
+    int count = ring_pop_batch(&storage->pending, storage->batch, STORAGE_BATCH_MAX_ROWS);
+    if (count == 0)
+        return 0;
+
+    if (!database_writable() || !store_batch(storage->batch, count))
+        spill_batch(storage->batch, count);
+    return count;
+}
+/**
+ * \brief Replays the oldest batch of the spill journal into the database.
+ *
+ * \return int Number of records consumed from the journal, 0 if there was nothing to replay
+ *             or the database is not writable, -1 if the batch failed (it stays in the journal).
+ *
+ * \note Storage thread only, called between live batches. Replayed readings go through the same
+ *       commit path as live ones: partitions, rollups and retention handle their older timestamps.
+ */
+static int replay_spill()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+
+    if (spill_pending(&storage->spill) == 0 || !database_writable())
+        return 0;
+
+    int consumed;
+    int count = spill_read(&storage->spill, storage->replay_batch, STORAGE_BATCH_MAX_ROWS, &consumed);
+    if (count > 0 && !store_batch(storage->replay_batch, count))
+        return -1;
+    spill_consume(&storage->spill, consumed, count);
+
+    if (consumed > 0 && spill_pending(&storage->spill) == 0)
+    {
+        char log_msg[128];
+        snprintf(log_msg, sizeof(log_msg), "Spill journal replayed, %lu readings recovered so far",
+                 atomic_load(&storage->spill.replayed));
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Storage", log_msg);
+    }
+    return consumed;
+}
+/**
+ * \brief Compacts the chunks of past windows, then checkpoints and truncates the WAL
+ *        (StorageBackendInterface::flush).
+ *
+ * \note Keeps the WAL from staying large between bursts, and leaves the database file
+ *       self-contained while the gateway is idle.
+ */
+static void sqlite_flush(void *self)
+{
+    SQLConnectionInfo *sql = self;
+    compact_chunks(sql);
+    if (!system_manager.storage_manager.profile->wal || system_manager.storage_manager.wal_pages == 0)
+        return;
+    checkpoint_wal(sql->db_handle, SQLITE_CHECKPOINT_TRUNCATE);
+}
+/**
+ * \brief Flushes the storage backend once nothing was committed for STORAGE_IDLE_CHECKPOINT_MS.
+ */
+static void flush_when_idle()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+    if (strcmp(storage->sql_info.status, SQL_CONNECTED) != 0)
+        return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long idle_ms = (now.tv_sec - storage->last_commit.tv_sec) * 1000L +
+                   (now.tv_nsec - storage->last_commit.tv_nsec) / 1000000L;
+    if (idle_ms >= STORAGE_IDLE_CHECKPOINT_MS)
+        storage->backend.interface.flush(storage->backend.impl);
+}
+/**
+ * \brief Waits until a batch is due: STORAGE_BATCH_MAX_ROWS readings are pending, pending readings have
+ *        waited STORAGE_BATCH_MAX_LATENCY_MS, the spill journal can be replayed, a reconnection is due,
+ *        or a stop is requested.
+ *
+ * \note The latency is measured from the moment this thread first sees the ring non-empty, which is
+ *       right after the first push thanks to the wakeup on an empty-to-non-empty transition.
+ *       While idle the wait still wakes every STORAGE_BATCH_MAX_LATENCY_MS to notice a stop request,
+ *       to apply the retention policy after midnight and to flush the backend once the idle delay has passed.
+ */
+static void wait_for_batch()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+    struct timespec first_seen;
+    bool seen = false;
+
+    while (!stop_requested)
+    {
+        // clear before checking, so a push after the check posts again instead of being missed
+        atomic_store_explicit(&storage->wake_pending, false, memory_order_seq_cst);
+
+        size_t pending = ring_size(&storage->pending);
+        if (pending >= STORAGE_BATCH_MAX_ROWS)
+            return;
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        if (pending > 0)
+        {
+            if (!seen)
+            {
+                first_seen = deadline;
+                seen = true;
+            }
+            deadline = first_seen;
+        }
+
+        deadline.tv_nsec += (long)STORAGE_BATCH_MAX_LATENCY_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+
+        if (sem_clockwait(&storage->batch_ready, CLOCK_MONOTONIC, &deadline) != 0 && errno == ETIMEDOUT)
+        {
+            if (seen || reconnect_due() || (spill_pending(&storage->spill) > 0 && database_writable()))
+                return;
+            apply_retention();
+            flush_when_idle();
+        }
+    }
+}
+/**
+ * \brief Sets up the storage backend selected on the command line.
+ *
+ * \param backend Output: the backend, not opened yet.
+ * \param type The backend type.
+ */
+static void create_storage_backend(StorageBackend *backend, StorageBackendType type)
+{
+    backend->type = type;
+    if (type == STORAGE_BACKEND_SEGMENT)
+    {
+        segment_backend_create(backend, &system_manager.storage_manager.segments, SEGMENT_DIR,
+                               strcmp(system_manager.storage_manager.profile->synchronous, "OFF") != 0);
+        return;
+    }
+
+    backend->impl = &system_manager.storage_manager.sql_info;
+    backend->interface.open = sqlite_open;
+    backend->interface.append_batch = sqlite_append_batch;
+    backend->interface.query_range = sqlite_query_range;
+    backend->interface.aggregate = sqlite_aggregate;
+    backend->interface.drop_before = sqlite_drop_before;
+    backend->interface.flush = sqlite_flush;
+    backend->interface.display_stats = sqlite_display_stats;
+    backend->interface.last_error = sqlite_last_error;
+    backend->interface.close = sqlite_close;
 }
 /**
  * \brief Initializes the storage manager, including setting initial values for SQL connection information and mutex.
@@ -160,191 +729,415 @@ void storage_add_data(SensorData data)
  */
 void init_storage_manager()
 {
+    system_manager.storage_manager.batch = malloc(STORAGE_BATCH_MAX_ROWS * sizeof(SensorData));
+    system_manager.storage_manager.replay_batch = malloc(STORAGE_BATCH_MAX_ROWS * sizeof(SensorData));
+    if (system_manager.storage_manager.batch == NULL || system_manager.storage_manager.replay_batch == NULL ||
+        !ring_init(&system_manager.storage_manager.pending, RING_BUFFER_SIZE))
+    {
+        handle_error("Failed to allocate the storage queue");
+        exit(EXIT_FAILURE);
+    }
+    sem_init(&system_manager.storage_manager.batch_ready, 0, 0);
+
+    system_manager.storage_manager.profile = storage_profile_get(system_manager.config.storage_profile);
+    atomic_init(&system_manager.storage_manager.io_stats.db_bytes, 0);
+    atomic_init(&system_manager.storage_manager.io_stats.wal_bytes, 0);
+    atomic_init(&system_manager.storage_manager.io_stats.journal_bytes, 0);
+    atomic_init(&system_manager.storage_manager.io_stats.temp_bytes, 0);
+    atomic_init(&system_manager.storage_manager.io_stats.syncs, 0);
+    if (!register_counting_vfs(&system_manager.storage_manager.io_stats))
+    {
+        handle_error("Failed to register the SQLite counting VFS");
+        exit(EXIT_FAILURE);
+    }
+    system_manager.storage_manager.wal_pages = 0;
+    clock_gettime(CLOCK_MONOTONIC, &system_manager.storage_manager.last_commit);
+    atomic_init(&system_manager.storage_manager.wake_pending, false);
+
     pthread_mutex_init(&system_manager.storage_manager.mutex, NULL);
     strcpy(system_manager.storage_manager.sql_info.status, SQL_DISCONNECTED);
     system_manager.storage_manager.sql_info.retry_count = 0;
     system_manager.storage_manager.sql_info.last_retry_time = 0;
     system_manager.storage_manager.sql_info.db_handle = NULL;
-    system_manager.storage_manager.pending_data_head = NULL;
+    partition_cache_init(&system_manager.storage_manager.sql_info.partitions);
+    system_manager.storage_manager.sql_info.read_handle = NULL;
     system_manager.storage_manager.total_messages_received = 0;
+    system_manager.storage_manager.batches_committed = 0;
+    system_manager.storage_manager.checkpoints = 0;
+    system_manager.storage_manager.truncating_checkpoints = 0;
+    system_manager.storage_manager.retention_day = INT_MIN;
+    system_manager.storage_manager.partitions_dropped = 0;
+    system_manager.storage_manager.expired_readings = 0;
+
+    create_storage_backend(&system_manager.storage_manager.backend, system_manager.config.storage_backend);
+
+    if (!spill_open(&system_manager.storage_manager.spill, SPILL_FILE_NAME, system_manager.config.spill_max_mib))
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR, "Storage",
+                                       "Cannot open the spill journal, readings are lost while SQL is unavailable");
+    else if (spill_pending(&system_manager.storage_manager.spill) > 0)
+    {
+        char log_msg[128];
+        snprintf(log_msg, sizeof(log_msg), "Spill journal holds %lu readings, replaying them once SQL is connected",
+                 spill_pending(&system_manager.storage_manager.spill));
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO, "Storage", log_msg);
+    }
 }
 /**
  * \brief Cleans up resources used by the storage manager, including closing SQL connection and freeing memory.
  *
- * \note This function closes the database connection if open, frees all pending data nodes, and destroys the mutex.
+ * \note This function writes whatever readings are still pending (to the spill journal if the database is
+ *       unavailable), closes the database connection if open, closes the spill journal, frees the pending
+ *       queue, and destroys the mutex. All producers must have stopped.
  */
 void cleanup_storage_manager()
 {
-    // 1. close SQL if open
-    if (system_manager.storage_manager.sql_info.db_handle != NULL)
+    // 1. flush what is still queued
+    while (process_pending_data() > 0)
+        ;
+
+    // 2. close the backend if open
+    if (strcmp(system_manager.storage_manager.sql_info.status, SQL_CONNECTED) == 0)
     {
-        sqlite3_close(system_manager.storage_manager.sql_info.db_handle);
-        system_manager.storage_manager.sql_info.db_handle = NULL;
         strcpy(system_manager.storage_manager.sql_info.status, SQL_DISCONNECTED);
 
         // write log
         system_manager.log_manager.log(&system_manager.log_manager,
                                        LOG_INFO, "Storage",
-                                       "Closed SQL database connection");
+                                       "Closed storage backend");
+        system_manager.storage_manager.backend.interface.close(system_manager.storage_manager.backend.impl);
     }
 
-    // clean pending_data
-    pthread_mutex_lock(&system_manager.storage_manager.mutex);
-    ConnectionNode *current = system_manager.storage_manager.pending_data_head;
-    while (current != NULL)
+    // 3. keep readings not replayed yet for the next start
+    unsigned long unreplayed = spill_pending(&system_manager.storage_manager.spill);
+    spill_close(&system_manager.storage_manager.spill);
+    if (unreplayed > 0)
     {
-        ConnectionNode *next = current->next;
-        free(current);
-        current = next;
+        char log_msg[128];
+        snprintf(log_msg, sizeof(log_msg), "%lu readings left in %s, replayed on the next start",
+                 unreplayed, SPILL_FILE_NAME);
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_WARNING, "Storage", log_msg);
     }
-    system_manager.storage_manager.pending_data_head = NULL;
-    pthread_mutex_unlock(&system_manager.storage_manager.mutex);
+
+    ring_destroy(&system_manager.storage_manager.pending);
+    free(system_manager.storage_manager.batch);
+    system_manager.storage_manager.batch = NULL;
+    free(system_manager.storage_manager.replay_batch);
+    system_manager.storage_manager.replay_batch = NULL;
 
     // destroy mutex
+    sem_destroy(&system_manager.storage_manager.batch_ready);
     pthread_mutex_destroy(&system_manager.storage_manager.mutex);
 }
 /**
- * \brief Prepares an SQL statement for inserting sensor data into the database.
+ * \brief Returns the bytes SQLite wrote to disk per byte of reading payload committed so far.
+ *
+ * \return double The write amplification, 0 before the first row.
  *
- * \param db The SQLite database handle.
- * \param data The sensor data to be inserted.
+ * \note The payload of a row is STORAGE_ROW_PAYLOAD_BYTES; the disk bytes are every write of the
+ *       database, its WAL and its rollback journal, counted by the counting VFS since startup. Temporary
+ *       files (e.g. a `readdb` sort) are not caused by the writes and are left out.
+ */
+double storage_write_amplification()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+
+    pthread_mutex_lock(&storage->mutex);
+    int rows = storage->total_messages_received;
+    pthread_mutex_unlock(&storage->mutex);
+
+    if (rows == 0)
+        return 0.0;
+    unsigned long long written = atomic_load(&storage->io_stats.db_bytes) +
+                                 atomic_load(&storage->io_stats.wal_bytes) +
+                                 atomic_load(&storage->io_stats.journal_bytes);
+    return (double)written / ((double)rows * STORAGE_ROW_PAYLOAD_BYTES);
+}
+/**
+ * \brief Returns the size of a file, 0 if it does not exist.
+ */
+static long long file_size(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? (long long)st.st_size : 0;
+}
+/**
+ * \brief Returns the number of readings stored, from the partition catalog.
  *
- * \return Returns the prepared statement for insertion, or NULL if preparation fails.
+ * \param sql The SQL connection information structure; its reader connection is used.
  *
- * \note This function binds the sensor data values to the prepared SQL statement for insertion.
+ * \return long long Readings in every partition, -1 if the catalog cannot be read.
  */
-static sqlite3_stmt *prepare_insert_statement(sqlite3 *db, SensorData data)
+static long long stored_readings(SQLConnectionInfo *sql)
 {
-    const char *insert_sql = "INSERT INTO sensor_data (timestamp, sensor_id, temperature) "
-                             "VALUES (?, ?, ?)";
     sqlite3_stmt *stmt;
+    long long readings = -1;
 
-    if (sqlite3_prepare_v2(db, insert_sql, -1, &stmt, NULL) == SQLITE_OK)
-    {
-        sqlite3_bind_int(stmt, 1, data.timestamp);
-        sqlite3_bind_int(stmt, 2, data.sensor_id);
-        sqlite3_bind_double(stmt, 3, data.temperature);
-        return stmt;
-    }
-    return NULL;
+    if (sql->read_handle == NULL)
+        sql->read_handle = open_reader_connection();
+    if (sql->read_handle == NULL ||
+        sqlite3_prepare_v2(sql->read_handle, "SELECT COALESCE(SUM(rows), 0) FROM sensor_partitions", -1, &stmt,
+                           NULL) != SQLITE_OK)
+        return -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        readings = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return readings;
 }
 /**
- * \brief Removes a processed connection node from the pending data list.
- *
- * \param to_remove The connection node to be removed.
- * \param prev The previous node in the list.
+ * \brief Prints the durability profile and the write statistics of the SQLite backend
+ *        (StorageBackendInterface::display_stats).
  *
- * \note This function frees the memory used by the processed node and updates the pending data list.
+ * \note The disk usage is the size of the database and WAL files over the readings in the catalog, so it
+ *       includes the chunk rows, their indexes, the rollups and the free pages, not only the encoded chunks.
  */
-static void remove_processed_node(ConnectionNode *to_remove, ConnectionNode *prev)
+static void sqlite_display_stats(void *self)
 {
-    if (prev)
-    {
-        prev->next = to_remove->next;
-    }
+    SQLConnectionInfo *sql = self;
+    StorageManager *storage = &system_manager.storage_manager;
+    const StorageProfile *profile = storage->profile;
+
+    pthread_mutex_lock(&storage->mutex);
+    unsigned long checkpoints = storage->checkpoints;
+    unsigned long truncating = storage->truncating_checkpoints;
+    pthread_mutex_unlock(&storage->mutex);
+
+    printf(" Storage profile         : %s (%s, synchronous %s, page %d B, cache %d KiB)\n",
+           profile->name, profile->wal ? "WAL" : "rollback journal", profile->synchronous,
+           profile->page_size, profile->cache_size_kib);
+    printf(" Storage writes          : %.2f MiB db, %.2f MiB wal, %.2f MiB journal, %.2f MiB temp, %lu syncs\n",
+           atomic_load(&storage->io_stats.db_bytes) / 1048576.0,
+           atomic_load(&storage->io_stats.wal_bytes) / 1048576.0,
+           atomic_load(&storage->io_stats.journal_bytes) / 1048576.0,
+           atomic_load(&storage->io_stats.temp_bytes) / 1048576.0,
+           atomic_load(&storage->io_stats.syncs));
+    printf(" Write amplification     : %.2fx (%lu checkpoints, %lu truncated)\n",
+           storage_write_amplification(), checkpoints, truncating);
+
+    long long db = file_size(DB_FILE_NAME), wal = file_size(DB_FILE_NAME "-wal");
+    long long readings = stored_readings(sql);
+    printf(" Disk usage              : %.2f MiB db + %.2f MiB wal", db / 1048576.0, wal / 1048576.0);
+    if (readings > 0)
+        printf(" for %lld readings, %.2f B/reading on disk", readings, (double)(db + wal) / readings);
+    printf("\n");
+
+    unsigned long encoded = atomic_load(&sql->partitions.encoded_readings);
+    unsigned long bytes = atomic_load(&sql->partitions.encoded_bytes);
+    printf(" Chunk encoding          : %.2f B/reading of chunk payload (%lu readings encoded, %lu small chunks "
+           "compacted)\n",
+           encoded > 0 ? (double)bytes / encoded : 0.0, encoded, atomic_load(&sql->partitions.compacted_chunks));
+}
+/**
+ * \brief Prints the storage backend, its write statistics, the retention policy and the spill journal.
+ */
+void storage_display_stats()
+{
+    StorageManager *storage = &system_manager.storage_manager;
+
+    pthread_mutex_lock(&storage->mutex);
+    unsigned long dropped = storage->partitions_dropped;
+    unsigned long expired = storage->expired_readings;
+    pthread_mutex_unlock(&storage->mutex);
+
+    printf(" Storage backend         : %s\n", storage_backend_name(storage->backend.type));
+    storage->backend.interface.display_stats(storage->backend.impl);
+    if (system_manager.config.retention_days > 0)
+        printf(" Retention               : %d days (%lu %s dropped, %lu expired readings skipped)\n",
+               system_manager.config.retention_days, dropped,
+               storage->backend.type == STORAGE_BACKEND_SQLITE ? "partitions" : "segments", expired);
     else
+        printf(" Retention               : keep everything\n");
+    char cap[32] = "no cap";
+    if (storage->spill.max_bytes > 0)
+        snprintf(cap, sizeof(cap), "cap %ld MiB", (long)(storage->spill.max_bytes >> 20));
+    printf(" Spill journal           : %lu pending, %lu spilled, %lu replayed, %lu dropped (%s)\n",
+           spill_pending(&storage->spill), atomic_load(&storage->spill.spilled),
+           atomic_load(&storage->spill.replayed), atomic_load(&storage->spill.dropped),
+           storage->spill.fd < 0 ? "unavailable" : cap);
+}
+/**
+ * \brief Range query of the SQLite backend (StorageBackendInterface::query_range).
+ *
+ * \note Reads through the reader connection, so it never blocks the writer. The catalog prunes the
+ *       partitions outside the time range (and before the cursor); the remaining ones are read oldest
+ *       first until `max` rows were visited, in (timestamp, id) order.
+ */
+static int sqlite_query_range(void *self, const ReadingQuery *query, ReadingCursor *after, int max,
+                              ReadingVisitor visit, void *arg)
+{
+    SQLConnectionInfo *sql = self;
+
+    if (sql->read_handle == NULL)
+        sql->read_handle = open_reader_connection();
+
+    static PartitionInfo partitions[STORAGE_QUERY_MAX_PARTITIONS]; // UI thread only
+    int count = partition_list(sql->read_handle, after->timestamp, query->to, partitions, STORAGE_QUERY_MAX_PARTITIONS);
+    if (count < 0)
+        return -1;
+
+    int visited = 0;
+    for (int i = 0; i < count && visited < max; i++)
     {
-        system_manager.storage_manager.pending_data_head = to_remove->next;
+        int rows = partition_read_page(sql->read_handle, partitions[i].table_name, query, after, max - visited,
+                                       visit, arg);
+        if (rows < 0)
+            return -1;
+        visited += rows;
     }
-    free(to_remove);
-    system_manager.storage_manager.total_messages_received++;
+    return visited;
 }
 /**
- * \brief Processes all pending sensor data and inserts it into the database.
+ * \brief Aggregate query of the SQLite backend (StorageBackendInterface::aggregate).
  *
- * \note This function iterates through the pending data list, prepares insert statements,
- *       executes them, and removes processed nodes from the list. Errors are logged.
+ * \note rollup_query() answers from the coarsest rollup that fits, so the rows read grow with the
+ *       number of hours in the range, not with the readings.
  */
-static void process_pending_data()
+static bool sqlite_aggregate(void *self, const ReadingQuery *query, RollupAggregate *aggregate, RollupQueryStats *stats)
 {
-    pthread_mutex_lock(&system_manager.storage_manager.mutex);
+    SQLConnectionInfo *sql = self;
 
-    ConnectionNode *current = system_manager.storage_manager.pending_data_head;
-    ConnectionNode *prev = NULL;
-    SQLConnectionInfo *sql = &system_manager.storage_manager.sql_info;
+    if (sql->read_handle == NULL)
+        sql->read_handle = open_reader_connection();
+    return rollup_query(sql->read_handle, query->sensor_id, query->from, query->to, aggregate, stats);
+}
+/**
+ * \brief Prints one reading of a readdb page (ReadingVisitor).
+ */
+static void print_reading(const SensorData *data, long id, void *arg)
+{
+    (void)id;
+    (void)arg;
 
-    while (current != NULL)
+    // Convert timestamp -> human-readable format
+    time_t raw_time = (time_t)data->timestamp;
+    struct tm *time_info = localtime(&raw_time);
+    char time_str[20]; // Format: YYYY-MM-DD HH:MM:SS
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", time_info);
+
+    printf("%-20s %-15d %-10.2f\n", time_str, data->sensor_id, data->temperature);
+}
+/**
+ * \brief Adds one reading to an aggregate (ReadingVisitor).
+ */
+static void aggregate_reading(const SensorData *data, long id, void *arg)
+{
+    (void)id;
+    RollupAggregate *aggregate = arg;
+
+    if (aggregate->count == 0 || data->temperature < aggregate->min)
+        aggregate->min = data->temperature;
+    if (aggregate->count == 0 || data->temperature > aggregate->max)
+        aggregate->max = data->temperature;
+    if (aggregate->count == 0 || data->timestamp >= aggregate->last_timestamp)
     {
-        sqlite3_stmt *stmt = prepare_insert_statement(sql->db_handle, current->latest_data);
-        if (stmt != NULL)
-        {
-            if (sqlite3_step(stmt) == SQLITE_DONE)
-            {
-                ConnectionNode *next = current->next;
-                remove_processed_node(current, prev);
-                current = next;
-            }
-            else
-            {
-                const char *errmsg = sqlite3_errmsg(sql->db_handle);
-                system_manager.log_manager.log(&system_manager.log_manager,
-                                               LOG_ERROR, "Storage",
-                                               errmsg);
-                prev = current;
-                current = current->next;
-            }
-            sqlite3_finalize(stmt);
-        }
-        else
-        {
-            prev = current;
-            current = current->next;
-        }
+        aggregate->last = data->temperature;
+        aggregate->last_timestamp = data->timestamp;
     }
+    aggregate->count++;
+    aggregate->sum += data->temperature;
+}
+/**
+ * \brief Tells whether the backend can be queried, printing why not otherwise.
+ */
+static bool storage_readable(const char *action)
+{
+    if (strcmp(system_manager.storage_manager.sql_info.status, SQL_DISCONNECTED) != 0)
+        return true;
 
-    pthread_mutex_unlock(&system_manager.storage_manager.mutex);
+    char log_msg[64];
+    snprintf(log_msg, sizeof(log_msg), "Cannot %s. Storage not connected.", action);
+    system_manager.log_manager.log(&system_manager.log_manager, LOG_WARNING, "Storage", log_msg);
+    printf("Database not connected.\n");
+    return false;
 }
 /**
- * \brief Prints all sensor data from the database to the console.
+ * \brief Prints one page of sensor data matching a query.
+ *
+ * \param query Sensor, time range, page size and optional cursor.
  *
- * \note This function retrieves all sensor data from the database, formats the timestamp into a human-readable format,
- *       and prints the data in a table format. If the database is not connected, it logs a warning.
+ * \return ReadingPage Whether the page is full, so more rows may follow, and the cursor of the next page.
+ *
+ * \note The backend reads without blocking the writer, and the work done is bounded by the page size,
+ *       not the amount stored.
  */
-void storage_print_all_data()
+ReadingPage storage_print_readings(const ReadingQuery *query)
 {
-    SQLConnectionInfo *sql = &system_manager.storage_manager.sql_info;
+    StorageBackend *backend = &system_manager.storage_manager.backend;
+    ReadingPage page = {false, {0, -1}};
 
-    if (strcmp(sql->status, SQL_DISCONNECTED) == 0)
-    {
-        system_manager.log_manager.log(&system_manager.log_manager, LOG_WARNING,
-                                       "Storage", "Cannot print DB. SQL not connected.");
-        printf("Database not connected.\n");
-        return;
-    }
+    if (!storage_readable("print DB"))
+        return page;
 
-    const char *sql_query = "SELECT timestamp, sensor_id, temperature FROM sensor_data ORDER BY timestamp ASC";
-    sqlite3_stmt *stmt;
+    ReadingCursor after = {query->from, -1}; // ids start at 0 or 1, so the first second is included
+    if (query->has_cursor)
+        after = query->after;
 
-    int rc = sqlite3_prepare_v2(sql->db_handle, sql_query, -1, &stmt, NULL);
-    if (rc != SQLITE_OK)
+    printf("\n%-20s %-15s %-10s\n", "Timestamp", "Sensor port", "Temperature");
+    printf("-------------------------------------------------------------\n");
+
+    int printed = backend->interface.query_range(backend->impl, query, &after, query->limit, print_reading, NULL);
+    if (printed < 0)
     {
         system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR,
-                                       "Storage", "Failed to prepare SELECT statement.");
-        return;
+                                       "Storage", "Failed to read the stored readings.");
+        return page;
     }
 
-    printf("\n%-20s %-15s %-10s\n", "Timestamp", "Sensor ID", "Temperature");
-    printf("-------------------------------------------------------------\n");
+    page.more = printed == query->limit;
+    page.next = after;
+    return page;
+}
+/**
+ * \brief Prints the count, min, max, average and last value of one sensor over a time range.
+ *
+ * \param query Sensor and time range; the sensor is required, page options are ignored.
+ *
+ * \return bool true if the aggregate was printed, false otherwise.
+ *
+ * \note Uses the backend's aggregate query when it has one (the SQLite rollups); otherwise every
+ *       reading in the range is visited.
+ */
+bool storage_print_aggregate(const ReadingQuery *query)
+{
+    StorageBackend *backend = &system_manager.storage_manager.backend;
 
-    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    if (!storage_readable("aggregate"))
+        return false;
+
+    RollupAggregate aggregate = {0};
+    RollupQueryStats stats = {0};
+    struct timespec start, end;
+    bool found;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (backend->interface.aggregate != NULL)
+        found = backend->interface.aggregate(backend->impl, query, &aggregate, &stats);
+    else
     {
-        int timestamp = sqlite3_column_int(stmt, 0);
-        int sensor_id = sqlite3_column_int(stmt, 1);
-        double temperature = sqlite3_column_double(stmt, 2);
+        ReadingCursor after = {query->from, -1};
+        stats.raw_rows = backend->interface.query_range(backend->impl, query, &after, INT_MAX,
+                                                        aggregate_reading, &aggregate);
+        found = stats.raw_rows >= 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (!found)
+    {
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_ERROR,
+                                       "Storage", "Failed to aggregate the stored readings.");
+        return false;
+    }
 
-        // Convert timestamp -> human-readable format
-        time_t raw_time = (time_t)timestamp;
-        struct tm *time_info = localtime(&raw_time);
+    printf("\nSensor %d: %ld reading(s)\n", query->sensor_id, aggregate.count);
+    if (aggregate.count > 0)
+    {
+        time_t raw_time = (time_t)aggregate.last_timestamp;
         char time_str[20]; // Format: YYYY-MM-DD HH:MM:SS
-        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", time_info);
-
-        printf("%-20s %-15d %-10.2f\n", time_str, sensor_id, temperature);
+        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", localtime(&raw_time));
+        printf(" Min / Max / Avg : %.2f / %.2f / %.2f\n", aggregate.min, aggregate.max, aggregate.sum / aggregate.count);
+        printf(" Last            : %.2f at %s\n", aggregate.last, time_str);
     }
-
-    sqlite3_finalize(stmt);
-
-    system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO,
-                                   "Storage", "All sensor data printed to console");
+    printf(" Rows read       : %d hour, %d minute, %d raw in %.2f ms\n",
+           stats.hour_rows, stats.minute_rows, stats.raw_rows,
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    return true;
 }
 /**
  * \brief Main storage manager thread that handles SQL connections and processes pending data.
@@ -352,23 +1145,35 @@ void storage_print_all_data()
  * \param arg A pointer to any arguments (unused).
  *
  * \note This function runs in a loop, attempting to connect to the SQL database if disconnected,
- *       and processing any pending data every second.
+ *       and committing pending data in batches of up to STORAGE_BATCH_MAX_ROWS rows, at the latest
+ *       STORAGE_BATCH_MAX_LATENCY_MS after a reading was queued. Batches the database cannot take go to
+ *       the spill journal and are replayed between live batches once it can. Once a stop is requested
+ *       the remaining readings are flushed before the thread returns.
  */
 void *storage_manager(void *arg)
 {
-    while (!stop_requested)
+    while (1)
     {
-        // connect to SQL if not connect
-        if (strcmp(system_manager.storage_manager.sql_info.status, SQL_DISCONNECTED) == 0)
+        // connect to SQL if not connect; until then batches go to the spill journal
+        if (reconnect_due())
+            storage_connect_with_retry();
+
+        wait_for_batch();
+
+        // drain every full batch; a partial one is only written once it is due
+        int written;
+        do
         {
-            if (!storage_connect_with_retry())
-                continue;
-        }
+            written = process_pending_data();
+        } while (written == STORAGE_BATCH_MAX_ROWS || (stop_requested && written > 0));
 
-        // handle pending data
-        process_pending_data();
+        if (stop_requested)
+            break;
 
-        sleep(1);
+        // replay the spill journal in the background, one batch at a time while live readings leave room
+        while (!stop_requested && ring_size(&system_manager.storage_manager.pending) < STORAGE_BATCH_MAX_ROWS &&
+               replay_spill() > 0)
+            ;
     }
     return NULL;
 }
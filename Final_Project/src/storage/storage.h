@@ -15,7 +15,14 @@
 void init_storage_manager();
 void cleanup_storage_manager();
 void storage_add_data(SensorData data);
-void storage_print_all_data();
+ReadingPage storage_print_readings(const ReadingQuery *query);
+bool storage_print_aggregate(const ReadingQuery *query);
+void storage_display_stats();
+double storage_write_amplification();
+const StorageProfile *storage_profile_get(StorageProfileType type);
+bool storage_profile_from_name(const char *name, StorageProfileType *type);
+const char *storage_backend_name(StorageBackendType type);
+bool storage_backend_from_name(const char *name, StorageBackendType *type);
 void *storage_manager(void *arg);
 
 #endif
\ No newline at end of file
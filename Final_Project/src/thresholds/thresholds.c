@@ -0,0 +1,273 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "thresholds.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Orders profiles by their first port (qsort callback).
+ */
+static int compare_profiles(const void *a, const void *b)
+{
+    const ThresholdProfile *left = a, *right = b;
+    return (left->first_port > right->first_port) - (left->first_port < right->first_port);
+}
+/**
+ * \brief Parses a whole token as a number.
+ *
+ * \return bool true if the token is a finite number, false otherwise.
+ */
+static bool parse_float(const char *token, float *value)
+{
+    char *end;
+    *value = strtof(token, &end);
+    return end != token && *end == '\0' && isfinite(*value);
+}
+/**
+ * \brief Parses a whole token as a non-negative integer.
+ *
+ * \return bool true if the token is an integer in 0..INT_MAX, false otherwise.
+ */
+static bool parse_int(const char *token, int *value)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(token, &end, 10);
+    if (end == token || *end != '\0' || errno != 0 || parsed < 0 || parsed > INT_MAX)
+        return false;
+    *value = (int)parsed;
+    return true;
+}
+/**
+ * \brief Parses a whole token as a port number.
+ *
+ * \return bool true if the token is a valid port (1..65535), false otherwise.
+ */
+static bool parse_port(const char *token, int *port)
+{
+    return parse_int(token, port) && is_valid_port(*port);
+}
+/**
+ * \brief Parses the sensors of a profile line: `default`, a reported port (`5000`) or an inclusive range of
+ *        them (`6000-6099`).
+ *
+ * \return bool true on success, false if the token is none of them.
+ */
+static bool parse_sensors(char *token, ThresholdProfile *profile)
+{
+    if (strcmp(token, "default") == 0)
+    {
+        profile->first_port = profile->last_port = -1;
+        return true;
+    }
+
+    char *dash = strchr(token, '-');
+    if (dash)
+        *dash = '\0';
+    if (!parse_port(token, &profile->first_port))
+        return false;
+    if (!dash)
+    {
+        profile->last_port = profile->first_port;
+        return true;
+    }
+    return parse_port(dash + 1, &profile->last_port) && profile->last_port >= profile->first_port;
+}
+/**
+ * \brief Parses one profile line: sensors, hot threshold, cold threshold and optional hysteresis and re-alert
+ *        interval.
+ *
+ * \param line The line, without its comment; tokenized in place.
+ * \param profile Output: the profile, with a negative hysteresis or interval when the line leaves them out.
+ *
+ * \return const char* NULL on success, the reason the line is invalid otherwise.
+ */
+static const char *parse_profile(char *line, ThresholdProfile *profile)
+{
+    char *tokens[6], *save = NULL;
+    int count = 0;
+    for (char *token = strtok_r(line, " \t\r\n", &save); token; token = strtok_r(NULL, " \t\r\n", &save))
+    {
+        if (count == 6)
+            return "too many fields";
+        tokens[count++] = token;
+    }
+    if (count < 3 || count > 5)
+        return "expected: <sensors> <hot> <cold> [hysteresis] [realert_seconds]";
+
+    profile->hysteresis = -1.0f;
+    profile->realert_seconds = -1;
+    if (!parse_sensors(tokens[0], profile))
+        return "sensors must be `default`, a port or a range of ports (`first-last`)";
+    if (!parse_float(tokens[1], &profile->hot_threshold) || !parse_float(tokens[2], &profile->cold_threshold))
+        return "thresholds must be numbers";
+    if (profile->cold_threshold >= profile->hot_threshold)
+        return "the cold threshold must be below the hot threshold";
+    if (count > 3 && (!parse_float(tokens[3], &profile->hysteresis) || profile->hysteresis < 0.0f))
+        return "the hysteresis must be a non-negative number";
+    if (count > 4 && !parse_int(tokens[4], &profile->realert_seconds))
+        return "the re-alert interval must be a non-negative number of seconds";
+    return NULL;
+}
+/**
+ * \brief Loads a table of threshold profiles.
+ *
+ * \param path The profile file, NULL for a table holding only the built-in default profile.
+ * \param error Output: why the file was rejected, when NULL is returned.
+ * \param error_size Size of `error`.
+ *
+ * \return ThresholdTable* The table (generation 0), NULL if the file cannot be read, is invalid or memory
+ *         allocation fails.
+ *
+ * \note One profile per line, `#` starts a comment:
+ *       `<default | port | first-last> <hot> <cold> [hysteresis] [realert_seconds]`.
+ *       Sensors are matched on the port they report after the handshake, which is the sensor ID of their
+ *       readings: the gateway keeps it unique and it survives reconnects, unlike the connection handle.
+ *       The `default` line replaces the built-in thresholds of the sensors no other line covers, and the
+ *       lines leaving out the hysteresis or the interval take those of the default profile. Ranges may not
+ *       overlap, so a sensor has exactly one profile. The whole file is rejected on the first invalid line.
+ */
+ThresholdTable *thresholds_load(const char *path, char *error, size_t error_size)
+{
+    ThresholdTable *table = calloc(1, sizeof(ThresholdTable));
+    if (!table)
+    {
+        snprintf(error, error_size, "out of memory");
+        return NULL;
+    }
+    table->fallback = (ThresholdProfile){-1, -1, ALERT_HOT_THRESHOLD, ALERT_COLD_THRESHOLD, ALERT_HYSTERESIS,
+                                         ALERT_REALERT_SECONDS};
+    if (!path)
+        return table;
+
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        snprintf(error, error_size, "%s: %s", path, strerror(errno));
+        thresholds_free(table);
+        return NULL;
+    }
+
+    char line[THRESHOLD_LINE_LENGTH];
+    size_t capacity = 0;
+    bool has_default = false;
+    const char *reason = NULL;
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        line_number++;
+        if (!strchr(line, '\n') && !feof(file))
+        {
+            reason = "line too long";
+            break;
+        }
+        line[strcspn(line, "#")] = '\0';
+        if (line[strspn(line, " \t\r\n")] == '\0')
+            continue;
+
+        ThresholdProfile profile;
+        reason = parse_profile(line, &profile);
+        if (reason)
+            break;
+        if (profile.first_port < 0)
+        {
+            if (has_default)
+            {
+                reason = "second `default` line";
+                break;
+            }
+            table->fallback = profile;
+            has_default = true;
+            continue;
+        }
+        if (table->count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 8;
+            ThresholdProfile *profiles = realloc(table->profiles, capacity * sizeof(ThresholdProfile));
+            if (!profiles)
+            {
+                reason = "out of memory";
+                break;
+            }
+            table->profiles = profiles;
+        }
+        table->profiles[table->count++] = profile;
+    }
+    fclose(file);
+    if (reason)
+    {
+        snprintf(error, error_size, "%s:%d: %s", path, line_number, reason);
+        thresholds_free(table);
+        return NULL;
+    }
+
+    if (table->fallback.hysteresis < 0.0f)
+        table->fallback.hysteresis = ALERT_HYSTERESIS;
+    if (table->fallback.realert_seconds < 0)
+        table->fallback.realert_seconds = ALERT_REALERT_SECONDS;
+    qsort(table->profiles, table->count, sizeof(ThresholdProfile), compare_profiles);
+    for (size_t i = 0; i < table->count; i++)
+    {
+        ThresholdProfile *profile = &table->profiles[i];
+        if (i > 0 && profile->first_port <= table->profiles[i - 1].last_port)
+        {
+            snprintf(error, error_size, "%s: the profiles of ports %d-%d and %d-%d overlap", path,
+                     table->profiles[i - 1].first_port, table->profiles[i - 1].last_port, profile->first_port,
+                     profile->last_port);
+            thresholds_free(table);
+            return NULL;
+        }
+        if (profile->hysteresis < 0.0f)
+            profile->hysteresis = table->fallback.hysteresis;
+        if (profile->realert_seconds < 0)
+            profile->realert_seconds = table->fallback.realert_seconds;
+    }
+    return table;
+}
+/**
+ * \brief Returns the profile of a sensor: the one whose range holds its reported port, the default one
+ *        otherwise.
+ *
+ * \note Binary search over the sorted, non-overlapping ranges; the table is never modified once published.
+ */
+const ThresholdProfile *thresholds_lookup(const ThresholdTable *table, int port)
+{
+    size_t low = 0, high = table->count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (table->profiles[mid].last_port < port)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low < table->count && table->profiles[low].first_port <= port)
+        return &table->profiles[low];
+    return &table->fallback;
+}
+/**
+ * \brief Describes a profile for the console, e.g. "ports 6000-6099: hot 60.0, cold 15.0, hysteresis 3.0, ...".
+ */
+void thresholds_describe(const ThresholdProfile *profile, char *buffer, size_t size)
+{
+    char sensors[32];
+    if (profile->first_port < 0)
+        snprintf(sensors, sizeof(sensors), "default");
+    else if (profile->first_port == profile->last_port)
+        snprintf(sensors, sizeof(sensors), "port %d", profile->first_port);
+    else
+        snprintf(sensors, sizeof(sensors), "ports %d-%d", profile->first_port, profile->last_port);
+    snprintf(buffer, size, "%s: hot %.1f, cold %.1f, hysteresis %.1f, re-alert after %d s", sensors,
+             profile->hot_threshold, profile->cold_threshold, profile->hysteresis, profile->realert_seconds);
+}
+/**
+ * \brief Frees a table. It must not be published, or no reader may still hold it.
+ */
+void thresholds_free(ThresholdTable *table)
+{
+    if (!table)
+        return;
+    free(table->profiles);
+    free(table);
+}
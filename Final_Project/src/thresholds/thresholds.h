@@ -0,0 +1,15 @@
+#ifndef THRESHOLDS_H
+#define THRESHOLDS_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+#include "../utils/utils.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+ThresholdTable *thresholds_load(const char *path, char *error, size_t error_size);
+const ThresholdProfile *thresholds_lookup(const ThresholdTable *table, int port);
+void thresholds_describe(const ThresholdProfile *profile, char *buffer, size_t size);
+void thresholds_free(ThresholdTable *table);
+#endif // THRESHOLDS_H
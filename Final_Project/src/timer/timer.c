@@ -0,0 +1,158 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "timer.h"
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Initializes an empty timer wheel and its 1 s periodic timerfd.
+ *
+ * \param wheel The wheel to initialize.
+ *
+ * \return bool true on success, false if the timerfd could not be created.
+ *
+ * \note The caller watches `wheel->timer_fd` with its I/O backend and calls timer_wheel_advance()
+ * whenever it becomes readable.
+ */
+bool timer_wheel_init(TimerWheel *wheel)
+{
+    memset(wheel->slots, 0, sizeof(wheel->slots));
+    wheel->current = time(NULL);
+
+    wheel->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (wheel->timer_fd < 0)
+    {
+        perror("timerfd_create");
+        return false;
+    }
+
+    struct itimerspec tick = {
+        .it_interval = {.tv_sec = 1, .tv_nsec = 0},
+        .it_value = {.tv_sec = 1, .tv_nsec = 0}};
+    if (timerfd_settime(wheel->timer_fd, 0, &tick, NULL) < 0)
+    {
+        perror("timerfd_settime");
+        close(wheel->timer_fd);
+        wheel->timer_fd = -1;
+        return false;
+    }
+    return true;
+}
+/**
+ * \brief Closes the wheel's timerfd. Armed entries are simply forgotten.
+ *
+ * \param wheel The wheel to destroy.
+ */
+void timer_wheel_destroy(TimerWheel *wheel)
+{
+    if (wheel->timer_fd >= 0)
+        close(wheel->timer_fd);
+    wheel->timer_fd = -1;
+    memset(wheel->slots, 0, sizeof(wheel->slots));
+}
+/**
+ * \brief Removes an entry from the wheel in O(1). Does nothing if it is not armed.
+ *
+ * \param wheel The wheel holding the entry.
+ * \param entry The entry to cancel.
+ */
+void timer_wheel_cancel(TimerWheel *wheel, TimerEntry *entry)
+{
+    if (!entry->armed)
+        return;
+
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        wheel->slots[entry->slot] = entry->next;
+
+    if (entry->next)
+        entry->next->prev = entry->prev;
+
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->armed = false;
+}
+/**
+ * \brief (Re-)arms an entry to expire at `expires` in O(1).
+ *
+ * \param wheel The wheel.
+ * \param entry The entry to arm (it is cancelled first if already armed).
+ * \param expires Epoch second at which the entry expires.
+ *
+ * \note Deadlines beyond the wheel's span go to its last slot and are re-armed when that slot
+ * is processed, so any deadline is supported.
+ */
+void timer_wheel_arm(TimerWheel *wheel, TimerEntry *entry, time_t expires)
+{
+    timer_wheel_cancel(wheel, entry);
+
+    time_t position = expires;
+    if (position < wheel->current)
+        position = wheel->current;
+    if (position - wheel->current >= TIMER_WHEEL_SLOTS)
+        position = wheel->current + TIMER_WHEEL_SLOTS - 1;
+
+    entry->expires = expires;
+    entry->slot = (int)(position % TIMER_WHEEL_SLOTS);
+    entry->armed = true;
+    entry->prev = NULL;
+    entry->next = wheel->slots[entry->slot];
+    if (entry->next)
+        entry->next->prev = entry;
+    wheel->slots[entry->slot] = entry;
+}
+/**
+ * \brief Processes every slot up to `now` and reports the entries that expired.
+ *
+ * \param wheel The wheel.
+ * \param now Current epoch second.
+ * \param on_expire Called once per expired entry (already disarmed). It may free the entry's owner
+ *        or re-arm the entry, but must not cancel other entries.
+ * \param context Passed through to `on_expire`.
+ *
+ * \return int Number of expired entries.
+ *
+ * \note Cost is proportional to the elapsed slots and the entries they hold, not to the number of
+ * armed timers. The timerfd is drained so the next tick produces a new edge.
+ */
+int timer_wheel_advance(TimerWheel *wheel, time_t now, TimerCallback on_expire, void *context)
+{
+    uint64_t ticks;
+    while (wheel->timer_fd >= 0 && read(wheel->timer_fd, &ticks, sizeof(ticks)) == sizeof(ticks))
+        ;
+
+    // after a long stall (or a clock jump) every slot is visited once
+    if (now - wheel->current >= TIMER_WHEEL_SLOTS)
+        wheel->current = now - TIMER_WHEEL_SLOTS + 1;
+
+    int expired = 0;
+    while (wheel->current <= now)
+    {
+        int slot = (int)(wheel->current % TIMER_WHEEL_SLOTS);
+        TimerEntry *entry = wheel->slots[slot];
+        wheel->slots[slot] = NULL;
+        wheel->current++;
+
+        while (entry)
+        {
+            TimerEntry *next = entry->next;
+            entry->next = NULL;
+            entry->prev = NULL;
+            entry->armed = false;
+
+            if (entry->expires > now)
+            {
+                timer_wheel_arm(wheel, entry, entry->expires);
+            }
+            else
+            {
+                on_expire(entry, now, context);
+                expired++;
+            }
+            entry = next;
+        }
+    }
+    return expired;
+}
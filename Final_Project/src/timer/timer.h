@@ -0,0 +1,22 @@
+#ifndef TIMER_H
+#define TIMER_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                     EXPORTED TYPES and DEFINITIONS                         */
+/******************************************************************************/
+// object that embeds `entry` as `member`
+#define TIMER_ENTRY_OWNER(entry, type, member) ((type *)((char *)(entry) - offsetof(type, member)))
+
+typedef void (*TimerCallback)(TimerEntry *entry, time_t now, void *context);
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+bool timer_wheel_init(TimerWheel *wheel);
+void timer_wheel_destroy(TimerWheel *wheel);
+void timer_wheel_arm(TimerWheel *wheel, TimerEntry *entry, time_t expires);
+void timer_wheel_cancel(TimerWheel *wheel, TimerEntry *entry);
+int timer_wheel_advance(TimerWheel *wheel, time_t now, TimerCallback on_expire, void *context);
+#endif // TIMER_H
@@ -1,6 +1,7 @@
 /******************************************************************************/
 /*                              INCLUDE FILES                                 */
 /******************************************************************************/
+#define _GNU_SOURCE // strptime()
 #include "user_interface.h"
 
 /******************************************************************************/
@@ -36,6 +37,18 @@ typedef struct
 {
     Command base;
 } ReaddbCommand;
+typedef struct
+{
+    Command base;
+} AggregateCommand;
+typedef struct
+{
+    Command base;
+} SensorCommand;
+typedef struct
+{
+    Command base;
+} ReloadCommand;
 /******************************************************************************/
 /*                            FUNCTIONS PROTOTYPES                             */
 /******************************************************************************/
@@ -234,6 +247,7 @@ Command *create_clear_log_command(void)
  * \param command_args The arguments for the terminate command, containing the sensor ID.
  *
  * \note This function removes the sensor connection with the specified sensor ID and logs the termination.
+ * Unknown or stale sensor IDs are reported and ignored.
  */
 static void execute_terminate_command(Command *self, const char *command_args)
 {
@@ -244,7 +258,14 @@ static void execute_terminate_command(Command *self, const char *command_args)
     int sensorID_terminate = atoi(info_terminate[1]);
     printf("Sensor id need to terminate: %d\n", sensorID_terminate);
 
-    system_manager.connection_manager.remove(&system_manager.connection_manager.head, sensorID_terminate);
+    // stale IDs (sensor gone, slot reused) are rejected by their generation
+    if (!connection_is_live(sensorID_terminate))
+    {
+        printf("Sensor %d is not connected\n", sensorID_terminate);
+        return;
+    }
+
+    system_manager.connection_manager.remove(sensorID_terminate);
 
     char msg[256];
     snprintf(msg, sizeof(msg), "A sensor node with %d has closed the connection", sensorID_terminate);
@@ -316,7 +337,7 @@ Command *create_status_command(void)
 static void execute_stats_command(Command *self, const char *command_args)
 {
     printf("Review stats connection \n");
-    system_manager.connection_manager.display(system_manager.connection_manager.head);
+    system_manager.connection_manager.display();
 }
 /**
  * \brief Creates a stats command and sets its execution function.
@@ -340,17 +361,113 @@ Command *create_stats_command(void)
 
 /*----------------command readdb handler-------------------------------*/
 /**
- * \brief Executes the readdb command by reading and displaying all data from the database.
+ * \brief Parses a time given to readdb: epoch seconds, `YYYY-MM-DD` or `YYYY-MM-DDTHH:MM:SS` (local time).
+ *
+ * \param text The text to parse.
+ * \param timestamp Output: epoch seconds.
+ *
+ * \return bool true if the text is a valid time, false otherwise.
+ */
+static bool parse_readdb_time(const char *text, int *timestamp)
+{
+    struct tm tm = {0};
+    char *end;
+
+    long value = strtol(text, &end, 10);
+    if (*end == '\0' && end != text)
+    {
+        *timestamp = (int)value;
+        return true;
+    }
+
+    end = strptime(text, "%Y-%m-%d", &tm);
+    if (end != NULL && *end == 'T')
+        end = strptime(end + 1, "%H:%M:%S", &tm);
+    if (end == NULL || *end != '\0')
+        return false;
+
+    tm.tm_isdst = -1;
+    *timestamp = (int)mktime(&tm);
+    return true;
+}
+/**
+ * \brief Parses the `key=value` options of readdb into a query.
+ *
+ * \param command_args The whole command line.
+ * \param query Output: the query.
+ *
+ * \return bool true if every option is valid, false otherwise (an error is printed).
+ *
+ * \note Options: sensor=<port> from=<time> to=<time> limit=<rows> after=<timestamp>:<id>. Stored readings
+ *       identify their sensor by its reported port, which survives reconnects.
+ */
+static bool parse_readdb_query(const char *command_args, ReadingQuery *query)
+{
+    char words[MAX_WORDS][MAX_WORD_LENGTH];
+    int word_count = 0;
+    split_string(command_args, words, &word_count);
+
+    query->sensor_id = -1;
+    query->from = INT_MIN;
+    query->to = INT_MAX;
+    query->limit = STORAGE_PAGE_DEFAULT_ROWS;
+    query->has_cursor = false;
+
+    for (int i = 1; i < word_count; i++)
+    {
+        char *value = strchr(words[i], '=');
+        if (value == NULL)
+        {
+            printf("Error: readdb option '%s' is not key=value\n", words[i]);
+            return false;
+        }
+        *value++ = '\0';
+
+        bool valid = true;
+        if (strcmp(words[i], "sensor") == 0)
+            valid = sscanf(value, "%d", &query->sensor_id) == 1 && query->sensor_id >= 0;
+        else if (strcmp(words[i], "from") == 0)
+            valid = parse_readdb_time(value, &query->from);
+        else if (strcmp(words[i], "to") == 0)
+            valid = parse_readdb_time(value, &query->to);
+        else if (strcmp(words[i], "limit") == 0)
+            valid = sscanf(value, "%d", &query->limit) == 1 && query->limit > 0 && query->limit <= STORAGE_PAGE_MAX_ROWS;
+        else if (strcmp(words[i], "after") == 0)
+            valid = query->has_cursor = sscanf(value, "%d:%ld", &query->after.timestamp, &query->after.id) == 2;
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            printf("Error: invalid readdb option '%s=%s'\n", words[i], value);
+            return false;
+        }
+    }
+    return true;
+}
+/**
+ * \brief Executes the readdb command by reading and displaying one page of data from the database.
  *
  * \param self The command object.
- * \param command_args The arguments for the readdb command (unused).
+ * \param command_args The readdb command line with its optional filters.
  *
- * \note This function reads all data from the database and displays it.
+ * \note Without options the first STORAGE_PAGE_DEFAULT_ROWS readings are shown. When the page is full,
+ *       the cursor to pass as `after=` for the next page is printed.
  */
 static void execute_readdb_command(Command *self, const char *command_args)
 {
+    ReadingQuery query;
+
+    if (!parse_readdb_query(command_args, &query))
+        return;
+
     printf("Read database \n");
-    storage_print_all_data();
+    ReadingPage page = storage_print_readings(&query);
+    system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO,
+                                   "Storage", "Sensor data page printed to console");
+
+    if (page.more)
+        printf("More rows: repeat the command with after=%d:%ld\n", page.next.timestamp, page.next.id);
 }
 /**
  * \brief Creates a readdb command and sets its execution function.
@@ -372,6 +489,109 @@ Command *create_readdb_command(void)
 }
 /*-------------------------------------------------------------*/
 
+/*----------------command aggregate handler-------------------------------*/
+/**
+ * \brief Executes the aggregate command: count, min, max, average and last value of one sensor.
+ *
+ * \param self The command object.
+ * \param command_args The aggregate command line: sensor=<port> [from=<time>] [to=<time>].
+ */
+static void execute_aggregate_command(Command *self, const char *command_args)
+{
+    ReadingQuery query;
+
+    if (!parse_readdb_query(command_args, &query))
+        return;
+    if (query.sensor_id < 0)
+    {
+        printf("Error: aggregate needs sensor=<port>\n");
+        return;
+    }
+
+    if (storage_print_aggregate(&query))
+        system_manager.log_manager.log(&system_manager.log_manager, LOG_INFO,
+                                       "Storage", "Sensor aggregate printed to console");
+}
+/**
+ * \brief Creates an aggregate command and sets its execution function.
+ *
+ * \return A new aggregate command object.
+ */
+Command *create_aggregate_command(void)
+{
+    AggregateCommand *command = malloc(sizeof(AggregateCommand));
+    if (!command)
+    {
+        fprintf(stderr, "Memory allocation failed for aggregate command\n");
+        return NULL;
+    }
+    command->base.execute = execute_aggregate_command;
+    return (Command *)command;
+}
+/*-------------------------------------------------------------*/
+
+/*----------------command sensor handler-------------------------------*/
+/**
+ * \brief Executes the sensor command: window statistics of one sensor from the data manager.
+ *
+ * \param self The command object.
+ * \param command_args The sensor command line: sensor <port>.
+ */
+static void execute_sensor_command(Command *self, const char *command_args)
+{
+    char words[MAX_WORDS][MAX_WORD_LENGTH];
+    int param_count = 0;
+    split_string(command_args, words, &param_count);
+
+    data_display_sensor(atoi(words[1]));
+}
+/**
+ * \brief Creates a sensor command and sets its execution function.
+ *
+ * \return A new sensor command object.
+ */
+Command *create_sensor_command(void)
+{
+    SensorCommand *command = malloc(sizeof(SensorCommand));
+    if (!command)
+    {
+        fprintf(stderr, "Memory allocation failed for sensor command\n");
+        return NULL;
+    }
+    command->base.execute = execute_sensor_command;
+    return (Command *)command;
+}
+/*-------------------------------------------------------------*/
+
+/*----------------command reload handler-------------------------------*/
+/**
+ * \brief Executes the reload command: reloads the threshold profile file.
+ *
+ * \param self The command object.
+ * \param command_args The reload command line: reload.
+ */
+static void execute_reload_command(Command *self, const char *command_args)
+{
+    data_reload_thresholds();
+}
+/**
+ * \brief Creates a reload command and sets its execution function.
+ *
+ * \return A new reload command object.
+ */
+Command *create_reload_command(void)
+{
+    ReloadCommand *command = malloc(sizeof(ReloadCommand));
+    if (!command)
+    {
+        fprintf(stderr, "Memory allocation failed for reload command\n");
+        return NULL;
+    }
+    command->base.execute = execute_reload_command;
+    return (Command *)command;
+}
+/*-------------------------------------------------------------*/
+
 /*----------------command other handler-------------------------------*/
 /*-------------------------------------------------------------*/
 
@@ -393,13 +613,16 @@ static void to_lower_case(char *str)
 
 // list command support
 static const CommandSpec valid_commands[] = {
-    {"connect", 2, create_connect_command},     // connect <id> <port>
-    {"terminate", 1, create_terminate_command}, // terminate <sensorID>
-    {"log", 0, create_log_command},             // log
-    {"clearlog", 0, create_clear_log_command},  // clearlog
-    {"status", 0, create_status_command},       // status
-    {"stats", 0, create_stats_command},         // stats
-    {"readdb", 0, create_readdb_command}        // readdb
+    {"connect", 2, 2, create_connect_command},     // connect <id> <port>
+    {"terminate", 1, 1, create_terminate_command}, // terminate <sensorID>
+    {"log", 0, 0, create_log_command},             // log
+    {"clearlog", 0, 0, create_clear_log_command},  // clearlog
+    {"status", 0, 0, create_status_command},       // status
+    {"stats", 0, 0, create_stats_command},         // stats
+    {"readdb", 0, 5, create_readdb_command},       // readdb [sensor=] [from=] [to=] [limit=] [after=]
+    {"aggregate", 1, 3, create_aggregate_command}, // aggregate sensor= [from=] [to=]
+    {"sensor", 1, 1, create_sensor_command},       // sensor <port>
+    {"reload", 0, 0, create_reload_command}        // reload
 };
 #define NUM_COMMANDS (sizeof(valid_commands) / sizeof(valid_commands[0]))
 /*-----------------------------------*/
@@ -436,12 +659,20 @@ Command *create_command_handler(const char *command_input)
         if (strcmp(words[0], valid_commands[i].name) == 0)
         {
             // check num param
-            if ((word_count - 1) != valid_commands[i].expected_param_count)
+            if ((word_count - 1) < valid_commands[i].min_param_count ||
+                (word_count - 1) > valid_commands[i].max_param_count)
             {
-                printf("Error: Command '%s' expects %d parameters, got %d\n",
-                       valid_commands[i].name,
-                       valid_commands[i].expected_param_count,
-                       word_count - 1);
+                if (valid_commands[i].min_param_count == valid_commands[i].max_param_count)
+                    printf("Error: Command '%s' expects %d parameters, got %d\n",
+                           valid_commands[i].name,
+                           valid_commands[i].min_param_count,
+                           word_count - 1);
+                else
+                    printf("Error: Command '%s' expects %d to %d parameters, got %d\n",
+                           valid_commands[i].name,
+                           valid_commands[i].min_param_count,
+                           valid_commands[i].max_param_count,
+                           word_count - 1);
                 return NULL;
             }
             // return command
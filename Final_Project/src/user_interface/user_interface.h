@@ -22,7 +22,8 @@ typedef struct Command
 typedef struct
 {
     const char *name;         // command name
-    int expected_param_count; // num param
+    int min_param_count;      // num param
+    int max_param_count;
     Command *(*create)(void); // create command
 } CommandSpec;
 /******************************************************************************/
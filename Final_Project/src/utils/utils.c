@@ -66,34 +66,6 @@ bool is_running_port(const int port, const int running_port)
 {
     return port == running_port; //
 }
-/**
- * \brief Checks if the given port is already in use by an existing connection.
- *
- * \param port The port to check.
- *
- * \return true if the port is already connected, false otherwise.
- *
- * \note This function checks the connection list and uses a mutex to ensure thread safety during the check.
- */
-bool is_port_already_connected(const int port)
-{
-    pthread_mutex_lock(&system_manager.connection_manager.mutex);
-
-    ConnectionNode *current = system_manager.connection_manager.head;
-    while (current != NULL)
-    {
-        if (current->connection.port == port &&
-            current->connection.status == CONN_STATUS_CONNECTED)
-        {
-            pthread_mutex_unlock(&system_manager.connection_manager.mutex);
-            return true;
-        }
-        current = current->next;
-    }
-
-    pthread_mutex_unlock(&system_manager.connection_manager.mutex);
-    return false;
-}
 /**
  * \brief Validates the connection parameters (IP and port).
  *
@@ -0,0 +1,250 @@
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "vfs.h"
+/******************************************************************************/
+/*                              PRIVATE DATA                                  */
+/******************************************************************************/
+// an open file of the counting VFS; the root VFS's file follows it in the same allocation
+typedef struct
+{
+    sqlite3_file base;
+    sqlite3_file *real;
+    atomic_ullong *bytes_written; // counter of this file's kind
+} CountingFile;
+
+static sqlite3_vfs *root_vfs;
+static sqlite3_vfs counting_vfs;
+static StorageIoStats *io_stats;
+static sqlite3_io_methods counting_io_methods[3]; // one per io_methods version the root may use
+/******************************************************************************/
+/*                            FUNCTIONS                              */
+/******************************************************************************/
+/**
+ * \brief Returns the root VFS's file wrapped by a counting file.
+ *
+ * \note The pass-through methods below only forward to it.
+ */
+static sqlite3_file *real_file(sqlite3_file *file)
+{
+    return ((CountingFile *)file)->real;
+}
+
+static int counting_close(sqlite3_file *file)
+{
+    sqlite3_file *real = real_file(file);
+    int rc = real->pMethods->xClose(real);
+    file->pMethods = NULL;
+    return rc;
+}
+
+static int counting_read(sqlite3_file *file, void *buffer, int amount, sqlite3_int64 offset)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xRead(real, buffer, amount, offset);
+}
+/**
+ * \brief Writes through to the root VFS and adds the bytes to the counter of the file's kind.
+ */
+static int counting_write(sqlite3_file *file, const void *buffer, int amount, sqlite3_int64 offset)
+{
+    sqlite3_file *real = real_file(file);
+    int rc = real->pMethods->xWrite(real, buffer, amount, offset);
+    if (rc == SQLITE_OK)
+        atomic_fetch_add_explicit(((CountingFile *)file)->bytes_written, amount, memory_order_relaxed);
+    return rc;
+}
+
+static int counting_truncate(sqlite3_file *file, sqlite3_int64 size)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xTruncate(real, size);
+}
+/**
+ * \brief Syncs through to the root VFS and counts the call.
+ */
+static int counting_sync(sqlite3_file *file, int flags)
+{
+    sqlite3_file *real = real_file(file);
+    atomic_fetch_add_explicit(&io_stats->syncs, 1, memory_order_relaxed);
+    return real->pMethods->xSync(real, flags);
+}
+
+static int counting_file_size(sqlite3_file *file, sqlite3_int64 *size)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xFileSize(real, size);
+}
+
+static int counting_lock(sqlite3_file *file, int lock)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xLock(real, lock);
+}
+
+static int counting_unlock(sqlite3_file *file, int lock)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xUnlock(real, lock);
+}
+
+static int counting_check_reserved_lock(sqlite3_file *file, int *out)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xCheckReservedLock(real, out);
+}
+
+static int counting_file_control(sqlite3_file *file, int op, void *arg)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xFileControl(real, op, arg);
+}
+
+static int counting_sector_size(sqlite3_file *file)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xSectorSize(real);
+}
+
+static int counting_device_characteristics(sqlite3_file *file)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xDeviceCharacteristics(real);
+}
+
+static int counting_shm_map(sqlite3_file *file, int region, int size, int extend, void volatile **out)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xShmMap(real, region, size, extend, out);
+}
+
+static int counting_shm_lock(sqlite3_file *file, int offset, int n, int flags)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xShmLock(real, offset, n, flags);
+}
+
+static void counting_shm_barrier(sqlite3_file *file)
+{
+    sqlite3_file *real = real_file(file);
+    real->pMethods->xShmBarrier(real);
+}
+
+static int counting_shm_unmap(sqlite3_file *file, int delete_flag)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xShmUnmap(real, delete_flag);
+}
+
+static int counting_fetch(sqlite3_file *file, sqlite3_int64 offset, int amount, void **out)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xFetch(real, offset, amount, out);
+}
+
+static int counting_unfetch(sqlite3_file *file, sqlite3_int64 offset, void *page)
+{
+    sqlite3_file *real = real_file(file);
+    return real->pMethods->xUnfetch(real, offset, page);
+}
+/**
+ * \brief Opens a file with the root VFS and wraps it so its writes and syncs are counted.
+ *
+ * \note Writes are attributed by the open flags: the main database, its WAL, its rollback journal,
+ *       or anything else (sorter spills, statement journals, temporary databases).
+ */
+static int counting_open(sqlite3_vfs *vfs, const char *name, sqlite3_file *file, int flags, int *out_flags)
+{
+    (void)vfs;
+    CountingFile *counting = (CountingFile *)file;
+    counting->real = (sqlite3_file *)&counting[1];
+
+    int rc = root_vfs->xOpen(root_vfs, name, counting->real, flags, out_flags);
+    if (rc != SQLITE_OK || counting->real->pMethods == NULL)
+    {
+        file->pMethods = NULL;
+        return rc;
+    }
+
+    if (flags & SQLITE_OPEN_MAIN_DB)
+        counting->bytes_written = &io_stats->db_bytes;
+    else if (flags & SQLITE_OPEN_WAL)
+        counting->bytes_written = &io_stats->wal_bytes;
+    else if (flags & SQLITE_OPEN_MAIN_JOURNAL)
+        counting->bytes_written = &io_stats->journal_bytes;
+    else
+        counting->bytes_written = &io_stats->temp_bytes;
+
+    int version = counting->real->pMethods->iVersion;
+    if (version < 1)
+        version = 1;
+    if (version > 3)
+        version = 3;
+    file->pMethods = &counting_io_methods[version - 1];
+    return SQLITE_OK;
+}
+/**
+ * \brief Registers COUNTING_VFS_NAME, a shim over the default VFS that counts the bytes SQLite writes.
+ *
+ * \param stats Counters to update; must outlive every connection opened with the VFS.
+ *
+ * \return bool true on success (or if already registered), false if there is no default VFS.
+ *
+ * \note The shim is not made the default: connections opt in by passing its name to sqlite3_open_v2().
+ *       Every method except xOpen is the root VFS's own.
+ */
+bool register_counting_vfs(StorageIoStats *stats)
+{
+    if (root_vfs != NULL)
+        return true;
+
+    sqlite3_vfs *root = sqlite3_vfs_find(NULL);
+    if (root == NULL)
+        return false;
+
+    sqlite3_io_methods methods = {
+        .iVersion = 3,
+        .xClose = counting_close,
+        .xRead = counting_read,
+        .xWrite = counting_write,
+        .xTruncate = counting_truncate,
+        .xSync = counting_sync,
+        .xFileSize = counting_file_size,
+        .xLock = counting_lock,
+        .xUnlock = counting_unlock,
+        .xCheckReservedLock = counting_check_reserved_lock,
+        .xFileControl = counting_file_control,
+        .xSectorSize = counting_sector_size,
+        .xDeviceCharacteristics = counting_device_characteristics,
+        .xShmMap = counting_shm_map,
+        .xShmLock = counting_shm_lock,
+        .xShmBarrier = counting_shm_barrier,
+        .xShmUnmap = counting_shm_unmap,
+        .xFetch = counting_fetch,
+        .xUnfetch = counting_unfetch,
+    };
+    for (int i = 0; i < 3; i++)
+    {
+        counting_io_methods[i] = methods;
+        counting_io_methods[i].iVersion = i + 1;
+    }
+    // version 1 files have no shared memory, version 2 files no memory-mapped fetch
+    counting_io_methods[0].xShmMap = NULL;
+    counting_io_methods[0].xShmLock = NULL;
+    counting_io_methods[0].xShmBarrier = NULL;
+    counting_io_methods[0].xShmUnmap = NULL;
+    counting_io_methods[0].xFetch = counting_io_methods[1].xFetch = NULL;
+    counting_io_methods[0].xUnfetch = counting_io_methods[1].xUnfetch = NULL;
+
+    io_stats = stats;
+    counting_vfs = *root;
+    counting_vfs.pNext = NULL;
+    counting_vfs.zName = COUNTING_VFS_NAME;
+    counting_vfs.szOsFile = sizeof(CountingFile) + root->szOsFile;
+    counting_vfs.xOpen = counting_open;
+
+    if (sqlite3_vfs_register(&counting_vfs, 0) != SQLITE_OK)
+        return false;
+    root_vfs = root;
+    return true;
+}
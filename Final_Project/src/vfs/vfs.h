@@ -0,0 +1,11 @@
+#ifndef VFS_H
+#define VFS_H
+/******************************************************************************/
+/*                              INCLUDE FILES                                 */
+/******************************************************************************/
+#include "../../include/shared_data.h"
+/******************************************************************************/
+/*                            FUNCTIONS PROTOTYPES                             */
+/******************************************************************************/
+bool register_counting_vfs(StorageIoStats *stats);
+#endif // VFS_H